@@ -3,34 +3,101 @@
 
 #include <stdint.h>
 
+#include "file_system.h"
+
+// Define /dev/null
+// reads are always at end of file and writes are discarded
+size_t null_read(Device *device, char *ptr, size_t len, int64_t offset,
+                 char options) {
+  return 0;
+};
+size_t null_write(Device *device, char *ptr, size_t len, int64_t offset,
+                  char options) {
+  return len;
+};
+
+// Define /dev/zero
+// reads fill the buffer with zeros, writes are discarded like for /dev/null
+size_t zero_read(Device *device, char *ptr, size_t len, int64_t offset,
+                 char options) {
+  memset(ptr, 0, len);
+  return len;
+};
+
 // Define /dev/urandom
+// Uses xoshiro256** (https://prng.di.unimi.it/) in several independent lanes.
+// The state is stored word by word across all lanes, so the loop over the
+// lanes has no dependencies between iterations and can be vectorized.
+#define URANDOM_LANES 4
+#define URANDOM_DEFAULT_SEED 0x39917A73ACA200E4ull
+
+typedef struct UrandomState {
+  uint64_t state[4][URANDOM_LANES];
+} UrandomState;
+static UrandomState urandom_state;
+
+static inline uint64_t urandom_rotl(uint64_t value, int shift) {
+  return (value << shift) | (value >> (64 - shift));
+}
+
+// splitmix64 is recommended to expand a single seed into xoshiro state
+static inline uint64_t urandom_splitmix(uint64_t *seed) {
+  uint64_t result = (*seed += 0x9E3779B97F4A7C15ull);
+  result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ull;
+  result = (result ^ (result >> 27)) * 0x94D049BB133111EBull;
+  return result ^ (result >> 31);
+}
+
+// produce one 64 bit word per lane
+static inline void urandom_next_block(UrandomState *random,
+                                      uint64_t block[URANDOM_LANES]) {
+  uint64_t(*s)[URANDOM_LANES] = random->state;
+  for (int lane = 0; lane < URANDOM_LANES; lane++) {
+    block[lane] = urandom_rotl(s[1][lane] * 5, 7) * 9;
+    uint64_t shifted = s[1][lane] << 17;
+    s[2][lane] ^= s[0][lane];
+    s[3][lane] ^= s[1][lane];
+    s[1][lane] ^= s[2][lane];
+    s[0][lane] ^= s[3][lane];
+    s[2][lane] ^= shifted;
+    s[3][lane] = urandom_rotl(s[3][lane], 45);
+  }
+}
+
 // Using the newlib random functions
 extern void srand(unsigned int seed);
 extern void srandom(unsigned int seed);
-extern long random(void);
-void urandom_init(int64_t seed) {
-  // TODO also seed the other random functions from newlib
+void urandom_init(uint64_t seed) {
+  if (seed == 0) {
+    seed = URANDOM_DEFAULT_SEED;
+  }
   srand(seed);
   srandom(seed);
+  for (int word = 0; word < 4; word++) {
+    for (int lane = 0; lane < URANDOM_LANES; lane++) {
+      urandom_state.state[word][lane] = urandom_splitmix(&seed);
+    }
+  }
 };
-size_t urandom_read(char *ptr, size_t len, int64_t offset, char options) {
+size_t urandom_read(Device *device, char *ptr, size_t len, int64_t offset,
+                    char options) {
   // ignoring offset and flags;
-  size_t long_size = sizeof(long);
-  size_t long_interations = len / long_size;
-
-  long *long_ptr = (long *)ptr;
-  for (size_t long_index = 0; long_index < long_interations; long_index++) {
-    long_ptr[long_index] = random();
+  UrandomState *random = device->state;
+  uint64_t block[URANDOM_LANES];
+  size_t read_bytes = 0;
+  for (; len - read_bytes >= sizeof(block); read_bytes += sizeof(block)) {
+    urandom_next_block(random, block);
+    memcpy(ptr + read_bytes, block, sizeof(block));
   }
-
-  size_t long_offset = long_interations * long_size;
-  long random_num = random();
-  for (size_t char_index = 0; char_index < len - long_offset; char_index++) {
-    ptr[long_offset + char_index] = (char)(random_num >> (8 * char_index));
+  // partial block at the end, the rest of it is discarded
+  if (read_bytes < len) {
+    urandom_next_block(random, block);
+    memcpy(ptr + read_bytes, block, len - read_bytes);
   }
   return len;
 };
-size_t urandom_write(char *ptr, size_t len, int64_t offset, char options) {
+size_t urandom_write(Device *device, char *ptr, size_t len, int64_t offset,
+                     char options) {
   return 0;
 };
 
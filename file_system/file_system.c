@@ -7,13 +7,19 @@
 #include "devices.h"
 #include "include/fs_interface.h"
 #include "paths.h"
+#include "slab.h"
 
-OpenFile open_files[FS_MAX_FILES] = {NULL};
+// descriptor slots, descriptors created with dup share the same open file
+// description and with it the offset and flags
+OpenFile *open_files[FS_MAX_FILES] = {NULL};
+// stdin, stdout and stderr only claim to be a TTY when asked to in environ
+char stdio_is_tty = 0;
 
 // folders that are always present
 // initialize with hard links = 1 to make sure we never attempt deallocation
 D_File fs_root = {
-    .name = "/\0",
+    .name = "/",
+    .name_len = 1,
     .next = NULL,
     .parent = NULL,
     .type = DIRECTORY,
@@ -23,7 +29,8 @@ D_File fs_root = {
     .mode = 0,
 };
 static D_File stdio_folder = {
-    .name = "stdio\0",
+    .name = "stdio",
+    .name_len = 5,
     .next = NULL,
     .parent = NULL,
     .type = DIRECTORY,
@@ -33,7 +40,8 @@ static D_File stdio_folder = {
     .mode = 0,
 };
 static D_File device_folder = {
-    .name = "dev\0",
+    .name = "dev",
+    .name_len = 3,
     .next = NULL,
     .parent = NULL,
     .type = DIRECTORY,
@@ -44,13 +52,52 @@ static D_File device_folder = {
 };
 
 // static devices
-static Device urandom_device = {
+static Device null_device = {
+    .state = NULL,
+    .read = null_read,
+    .write = null_write,
+    .close = NULL,
+    .release = NULL,
+};
+static D_File null_file = {
+    .name = "null",
+    .name_len = 4,
+    .next = NULL,
+    .parent = NULL,
+    .type = DEVICE,
+    .device = &null_device,
+    .hard_links = 1,
+    .open_descripotors = 0,
+    .mode = S_IRUSR | S_IWUSR,
+};
+static Device zero_device = {
     .state = NULL,
+    .read = zero_read,
+    .write = null_write,
+    .close = NULL,
+    .release = NULL,
+};
+static D_File zero_file = {
+    .name = "zero",
+    .name_len = 4,
+    .next = NULL,
+    .parent = NULL,
+    .type = DEVICE,
+    .device = &zero_device,
+    .hard_links = 1,
+    .open_descripotors = 0,
+    .mode = S_IRUSR | S_IWUSR,
+};
+static Device urandom_device = {
+    .state = &urandom_state,
     .read = urandom_read,
     .write = urandom_write,
+    .close = NULL,
+    .release = NULL,
 };
 static D_File urandom_file = {
-    .name = "urandom\0",
+    .name = "urandom",
+    .name_len = 7,
     .next = NULL,
     .parent = NULL,
     .type = DEVICE,
@@ -61,45 +108,47 @@ static D_File urandom_file = {
 };
 
 D_File *create_file(Path *name, char *content, size_t length, uint32_t mode) {
-  D_File *new_file = dandelion_alloc(sizeof(D_File), _Alignof(D_File));
+  D_File *new_file = slab_alloc(&file_cache);
   if (new_file == NULL) {
     return NULL;
   }
-  if (name->length > FS_NAME_LENGTH) {
-    return NULL;
-  }
-  memcpy(new_file->name, name->path, name->length);
+  new_file->name = name->path;
+  new_file->name_len = name->length;
   new_file->type = FILE;
   if (content != NULL) {
-    FileChunk *new_content =
-        dandelion_alloc(sizeof(FileChunk), _Alignof(FileChunk));
+    FileChunk *new_content = slab_alloc(&chunk_cache);
     if (new_content == NULL) {
+      slab_free(&file_cache, new_file);
       return NULL;
     }
     new_content->next = NULL;
     new_content->data = content;
     new_content->capacity = length;
     new_content->used = length;
+    new_content->owns_data = 0;
+    new_content->is_inline = 0;
     new_file->content = new_content;
   } else {
     new_file->content = NULL;
   }
   new_file->hard_links = 0;
   new_file->open_descripotors = 0;
+  new_file->published = 0;
   new_file->mode = mode | S_IFREG;
   return new_file;
 }
 
 D_File *create_directory(Path *name, uint32_t mode) {
-  D_File *new_file = dandelion_alloc(sizeof(D_File), _Alignof(D_File));
-  if (name->length > FS_NAME_LENGTH) {
+  D_File *new_file = slab_alloc(&file_cache);
+  if (new_file == NULL) {
     return NULL;
   }
-  memcpy(new_file->name, name->path, name->length);
-  new_file->name[name->length] = '\0';
+  new_file->name = name->path;
+  new_file->name_len = name->length;
   new_file->type = DIRECTORY;
   new_file->child = NULL;
   new_file->hard_links = 0;
+  new_file->published = 0;
   // directory where user has full permissions
   new_file->mode = S_IFDIR | S_IRUSR | S_IWUSR | S_IXUSR;
   return new_file;
@@ -119,14 +168,14 @@ int link_file_to_folder(D_File *folder, D_File *file) {
     file->next = NULL;
   } else {
     D_File *current = folder->child;
-    if (namecmp(file->name, FS_NAME_LENGTH, current->name, FS_NAME_LENGTH) <
-        0) {
+    if (namecmp(file->name, file->name_len, current->name,
+                current->name_len) < 0) {
       file->next = current;
       folder->child = file;
     } else {
       while (current->next != NULL) {
-        if (namecmp(file->name, FS_NAME_LENGTH, current->next->name,
-                    FS_NAME_LENGTH) < 0) {
+        if (namecmp(file->name, file->name_len, current->next->name,
+                    current->next->name_len) < 0) {
           break;
         } else {
           current = current->next;
@@ -151,7 +200,7 @@ D_File *find_file_in_dir(D_File *directory, Path file) {
   for (D_File *current = directory->child; current != NULL;
        current = current->next) {
     int cmp_result =
-        namecmp(current->name, FS_NAME_LENGTH, file.path, file.length);
+        namecmp(current->name, current->name_len, file.path, file.length);
     if (cmp_result == 0) {
       return current;
     } else if (cmp_result > 0) {
@@ -162,8 +211,12 @@ D_File *find_file_in_dir(D_File *directory, Path file) {
   return NULL;
 }
 
-D_File *find_file_path(Path file_path) {
-  D_File *current = &fs_root;
+D_File *find_file_path_from(D_File *directory, Path file_path) {
+  // absolute paths always start at the root
+  D_File *current = directory;
+  if (file_path.length > 0 && file_path.path[0] == '/') {
+    current = &fs_root;
+  }
   for (Path subpath = get_component_advance(&file_path); subpath.length != 0;
        subpath = get_component_advance(&file_path)) {
     if (current->type != DIRECTORY) {
@@ -177,6 +230,10 @@ D_File *find_file_path(Path file_path) {
   return current;
 }
 
+D_File *find_file_path(Path file_path) {
+  return find_file_path_from(&fs_root, file_path);
+}
+
 D_File *find_file(const char *name) {
   Path file_path = path_from_string(name);
   return find_file_path(file_path);
@@ -185,13 +242,14 @@ D_File *find_file(const char *name) {
 // follow a path and create all directories on the way that do not already
 // exist prevent up prevents moving up in the file tree, to prevent input
 // items getting written into different input sets by going up the file tree
-D_File *create_directories(D_File *directory, Path path, char prevent_up) {
+D_File *create_directories(D_File *directory, Path path, char prevent_up,
+                           char copy_names) {
   if (directory->type != DIRECTORY) {
     return NULL;
   }
   for (Path current_path = get_component_advance(&path);
        current_path.length > 0; current_path = get_component_advance(&path)) {
-    if (current_path.length > FS_NAME_LENGTH) {
+    if (copy_names != 0 && current_path.length >= FS_NAME_LENGTH) {
       return NULL;
     } else if (current_path.length == 1 && current_path.path[0] == '.') {
       // handle special case of single dot for current directory
@@ -213,14 +271,28 @@ D_File *create_directories(D_File *directory, Path path, char prevent_up) {
         directory = candidate_dir;
         continue;
       }
-      D_File *new_dir = dandelion_alloc(sizeof(D_File), _Alignof(D_File));
+      const char *name = current_path.path;
+      if (copy_names != 0) {
+        name = intern_name(current_path.path, current_path.length);
+        if (name == NULL) {
+          return NULL;
+        }
+      }
+      D_File *new_dir = slab_alloc(&file_cache);
+      if (new_dir == NULL) {
+        return NULL;
+      }
       new_dir->type = DIRECTORY;
-      memcpy(new_dir->name, current_path.path, current_path.length);
-      new_dir->name[current_path.length] = '\0';
+      new_dir->name = name;
+      new_dir->name_len = current_path.length;
       new_dir->child = NULL;
+      new_dir->hard_links = 0;
+      new_dir->open_descripotors = 0;
+      new_dir->published = 0;
+      new_dir->mode = S_IFDIR | S_IRUSR | S_IWUSR | S_IXUSR;
       int error = link_file_to_folder(directory, new_dir);
       if (error < 0) {
-        dandelion_free(new_dir);
+        slab_free(&file_cache, new_dir);
         return NULL;
       }
       directory = new_dir;
@@ -229,13 +301,23 @@ D_File *create_directories(D_File *directory, Path path, char prevent_up) {
   return directory;
 }
 
+void free_file_chunk(FileChunk *chunk) {
+  if (is_inline_chunk(chunk)) {
+    slab_free_inline(chunk, chunk->capacity);
+  } else {
+    if (chunk->owns_data) {
+      dandelion_free(chunk->data);
+    }
+    slab_free(&chunk_cache, chunk);
+  }
+}
+
 // free all file chunks in a chunk list and their data
 void free_file_chunks(FileChunk *first) {
   FileChunk *next_chunk = NULL;
   for (FileChunk *chunck = first; chunck != NULL; chunck = next_chunk) {
     next_chunk = chunck->next;
-    dandelion_free(chunck->data);
-    dandelion_free(chunck);
+    free_file_chunk(chunck);
   }
 }
 
@@ -250,21 +332,28 @@ int free_data(D_File *file) {
     }
     break;
   case FILE:
-    free_file_chunks(file->content);
+    // the platform may still read published content until exit
+    if (!file->published) {
+      free_file_chunks(file->content);
+    }
     break;
   case DEVICE:
-    // device should never have 0 hard links
-    // TODO insert panic here
+    // static devices should never have 0 hard links, only devices created at
+    // runtime such as pipes know how to release themselves
+    if (file->device->release == NULL) {
+      return -1;
+    }
+    file->device->release(file->device);
     break;
   default:
     // unkown file type
     return -1;
   }
-  dandelion_free(file);
+  slab_free(&file_cache, file);
   return 0;
 }
 
-int remove_file(D_File *file) {
+int unlink_file_from_folder(D_File *file) {
   D_File *parent = file->parent;
   // iterate through children until we find the file
   if (parent == NULL || parent->type != DIRECTORY) {
@@ -285,8 +374,16 @@ int remove_file(D_File *file) {
       return -1;
     }
   }
+  file->next = NULL;
   file->hard_links -= 1;
-  int error = free_data(file);
+  return 0;
+}
+
+int remove_file(D_File *file) {
+  int error = unlink_file_from_folder(file);
+  if (error != 0)
+    return error;
+  error = free_data(file);
   if (error != 0)
     return error;
   return 0;
@@ -344,20 +441,158 @@ int open_existing_file(unsigned int index, D_File *file, int flags,
   if (file->type == FILE) {
     new_chunk = file->content;
   }
+  OpenFile *new_file = slab_alloc(&open_file_cache);
+  if (new_file == NULL) {
+    return -ENOMEM;
+  }
   // mark that the file is open
   file->open_descripotors += 1;
 
-  OpenFile new_file = {
-      .file = file,
-      .offset = 0,
-      .current_chunk = new_chunk,
-      .open_flags = access_mode,
-  };
+  new_file->file = file;
+  new_file->offset = 0;
+  new_file->current_chunk = new_chunk;
+  new_file->open_flags = access_mode;
+  new_file->references = 1;
+  new_file->written = 0;
   open_files[index] = new_file;
 
   return 0;
 }
 
+// argv, environ and stdin in the stdio folder are inputs, not outputs
+static int is_stdio_input(Path set_ident, D_File *file) {
+  return namecmp(set_ident.path, set_ident.length, "stdio", 5) == 0 &&
+         (namecmp(file->name, file->name_len, "environ", 7) == 0 ||
+          namecmp(file->name, file->name_len, "argv", 4) == 0 ||
+          namecmp(file->name, file->name_len, "stdin", 5) == 0);
+}
+
+// get the content of a file in contiguous memory, copies it if the file has
+// more than one chunk
+static int file_content(D_File *file, char **data, size_t *length) {
+  FileChunk *content = file->content;
+  *data = NULL;
+  *length = 0;
+  if (content == NULL) {
+    return 0;
+  }
+  if (content->next == NULL) {
+    *data = content->data;
+    *length = content->used;
+    return 0;
+  }
+  // find total size needed
+  size_t total_size = 0;
+  for (FileChunk *chunk = content; chunk != NULL; chunk = chunk->next) {
+    total_size += chunk->used;
+  }
+  char *buffer = dandelion_alloc(total_size, _Alignof(max_align_t));
+  if (buffer == NULL) {
+    return -ENOMEM;
+  }
+  for (FileChunk *chunk = content; chunk != NULL; chunk = chunk->next) {
+    memcpy(buffer + *length, chunk->data, chunk->used);
+    *length += chunk->used;
+  }
+  *data = buffer;
+  return 0;
+}
+
+int publish_output_file(D_File *file) {
+  // find the set directory and the length of the path below it
+  size_t ident_len = file->name_len;
+  D_File *set_directory = file->parent;
+  while (set_directory != NULL && set_directory->parent != &fs_root) {
+    ident_len += set_directory->name_len + 1;
+    set_directory = set_directory->parent;
+  }
+  if (set_directory == NULL) {
+    return -EINVAL;
+  }
+  Path set_ident = {.path = set_directory->name,
+                    .length = set_directory->name_len};
+  size_t output_sets = dandelion_output_set_count();
+  size_t set_index = 0;
+  for (; set_index < output_sets; set_index++) {
+    if (namecmp(set_ident.path, set_ident.length,
+                dandelion_output_set_ident(set_index),
+                dandelion_output_set_ident_len(set_index)) == 0) {
+      break;
+    }
+  }
+  if (set_index == output_sets || is_stdio_input(set_ident, file)) {
+    return -EINVAL;
+  }
+  char *data;
+  size_t data_len;
+  char *ident = dandelion_alloc(ident_len, 1);
+  if (ident == NULL) {
+    return -ENOMEM;
+  }
+  if (file_content(file, &data, &data_len) != 0) {
+    // stays in the tree and is collected at exit instead
+    dandelion_free(ident);
+    return -ENOMEM;
+  }
+  // fill in the path from the back
+  size_t position = ident_len;
+  for (D_File *current = file; current != set_directory;
+       current = current->parent) {
+    position -= current->name_len;
+    memcpy(ident + position, current->name, current->name_len);
+    if (position > 0) {
+      ident[--position] = '/';
+    }
+  }
+  IoBuffer output = {.data = data,
+                     .data_len = data_len,
+                     .ident = ident,
+                     .ident_len = ident_len,
+                     .key = 0};
+  if (dandelion_emit_output(set_index, output) != 0) {
+    dandelion_free(ident);
+    // content spread over several chunks was copied
+    if (file->content != NULL && file->content->next != NULL) {
+      dandelion_free(data);
+    }
+    return -EINVAL;
+  }
+  // the platform may read the content until exit, so it is kept when the
+  // node goes away
+  file->published = 1;
+  remove_file(file);
+  return 0;
+}
+
+// the last close of a description that wrote to a file right in an output
+// set directory finishes the file, so it can be streamed out
+static int publishes_on_close(OpenFile *open_file) {
+  D_File *file = open_file->file;
+  return open_file->written && file->type == FILE &&
+         file->open_descripotors == 0 && file->hard_links == 1 &&
+         file->parent != NULL && file->parent->parent == &fs_root &&
+         dandelion_output_streaming();
+}
+
+void release_open_file(OpenFile *open_file) {
+  open_file->references -= 1;
+  if (open_file->references != 0) {
+    return;
+  }
+  D_File *file = open_file->file;
+  if (file->type == DEVICE && file->device->close != NULL) {
+    file->device->close(file->device, open_file->open_flags);
+  }
+  file->open_descripotors -= 1;
+  if (publishes_on_close(open_file)) {
+    // files that can not be published stay and are collected at exit
+    publish_output_file(file);
+  } else {
+    free_data(file);
+  }
+  slab_free(&open_file_cache, open_file);
+}
+
 void setup_charpparray(char *data, size_t length, int *entries,
                        char ***pp_array) {
   if (data == NULL || length == 0) {
@@ -450,16 +685,43 @@ void setup_charpparray(char *data, size_t length, int *entries,
   return;
 }
 
+// DANDELION_TTY set to anything but an empty string or 0 enables the TTY
+static char environ_requests_tty(char **environ) {
+  const char variable[] = "DANDELION_TTY=";
+  size_t variable_len = sizeof(variable) - 1;
+  for (char **entry = environ; *entry != NULL; entry++) {
+    size_t index = 0;
+    while (index < variable_len && (*entry)[index] == variable[index])
+      index++;
+    if (index == variable_len) {
+      const char *value = *entry + variable_len;
+      return value[0] != '\0' && !(value[0] == '0' && value[1] == '\0');
+    }
+  }
+  return 0;
+}
+
 int fs_initialize(int *argc, char ***argv, char ***environ) {
   // error value
   int error;
 
+  // slabs from a previous run are gone with the heap they were allocated from
+  slab_reset();
+
   if ((error = link_file_to_folder(&fs_root, &device_folder)) != 0) {
     return error;
   }
 
+  // add null and zero device
+  if ((error = link_file_to_folder(&device_folder, &null_file)) != 0) {
+    return error;
+  }
+  if ((error = link_file_to_folder(&device_folder, &zero_file)) != 0) {
+    return error;
+  }
+
   // initialize and add urandom device
-  urandom_init(0x39917A73ACA200E4ull); // TODO: get this from input struct
+  urandom_init(dandelion_random_seed());
   if ((error = link_file_to_folder(&device_folder, &urandom_file)) != 0) {
     return error;
   }
@@ -507,7 +769,7 @@ int fs_initialize(int *argc, char ***argv, char ***environ) {
     if (set_path.length == 0)
       continue;
     // create directories for set
-    D_File *set_directory = create_directories(&fs_root, set_path, 1);
+    D_File *set_directory = create_directories(&fs_root, set_path, 1, 0);
     if (set_directory == NULL) {
       // TODO write to stderr on what happened
       return -1;
@@ -523,7 +785,7 @@ int fs_initialize(int *argc, char ***argv, char ***environ) {
         continue;
       Path dir_path = get_directories(total_path);
       Path file_path = get_file(total_path);
-      D_File *item_dir = create_directories(set_directory, dir_path, 1);
+      D_File *item_dir = create_directories(set_directory, dir_path, 1, 0);
       if (item_dir == NULL) {
         return -1;
       }
@@ -569,7 +831,7 @@ int fs_initialize(int *argc, char ***argv, char ***environ) {
     if (set_path.length == 0)
       continue;
     // create directories for set
-    D_File *set_directory = create_directories(&fs_root, set_path, 1);
+    D_File *set_directory = create_directories(&fs_root, set_path, 1, 0);
     if (set_directory == NULL) {
       // TODO write to stderr on what happened
       return -1;
@@ -578,7 +840,7 @@ int fs_initialize(int *argc, char ***argv, char ***environ) {
 
   // if stdin has not been given as an input set create an empty file and
   // open it at index 0
-  if (open_files[STDIN_FILENO].file == NULL) {
+  if (open_files[STDIN_FILENO] == NULL) {
     Path stdin_path = path_from_string("stdin");
     D_File *stdin_file = create_file(&stdin_path, NULL, 0, S_IRUSR);
     if (stdin_file == NULL) {
@@ -604,80 +866,74 @@ int fs_initialize(int *argc, char ***argv, char ***environ) {
     *environ = dandelion_alloc(sizeof(char *), _Alignof(char *));
     **environ = NULL;
   }
+  stdio_is_tty = environ_requests_tty(*environ);
   return 0;
 }
 
-int add_output_from_file(D_File *file, Path previous_path, size_t set_index) {
-  // need to have at least one statement (definition not statement) after a
-  // label, so define this here so we can have a statement after the switch
-  // labels.
-  size_t name_length = 0;
-  char *new_buffer = NULL;
+// sizes needed to turn the files in a tree into outputs
+typedef struct OutputSizes {
+  size_t files;
+  // total length of all idents
+  size_t ident_bytes;
+  // longest directory prefix of any file
+  size_t max_path;
+} OutputSizes;
+
+static void count_outputs(D_File *file, size_t path_len, OutputSizes *sizes) {
   switch (file->type) {
   case FILE:
-    // check name length an create string with complete file name
-    name_length = namelen(file->name, FS_NAME_LENGTH);
-    new_buffer = dandelion_alloc(previous_path.length + name_length, 1);
-    if (new_buffer == NULL) {
-      return -1;
+    sizes->files++;
+    sizes->ident_bytes += path_len + file->name_len;
+    break;
+  case DIRECTORY:
+    path_len += file->name_len + 1;
+    if (path_len > sizes->max_path) {
+      sizes->max_path = path_len;
     }
-    memcpy(new_buffer, previous_path.path, previous_path.length);
-    memcpy(new_buffer + previous_path.length, file->name, name_length);
-    // check for content
-    char *content_buf = NULL;
-    size_t buff_len = 0;
-    FileChunk *content = file->content;
-    if (content != NULL) {
-      // get file content into contiguous memory
-      if (content->next == NULL) {
-        content_buf = content->data;
-        buff_len = content->used;
-      } else {
-        // find total size needed
-        size_t total_size = 0;
-        for (FileChunk *chunck = content; chunck != NULL;
-             chunck = chunck->next) {
-          total_size += chunck->used;
-        }
-        content_buf = dandelion_alloc(total_size, _Alignof(max_align_t));
-        if (content_buf == NULL) {
-          dandelion_exit(ENOMEM);
-          return -1;
-        }
-        for (FileChunk *chunk = content; chunk != NULL; chunk = chunk->next) {
-          memcpy(content_buf + buff_len, chunk->data, chunk->used);
-          buff_len += chunk->used;
-        }
-      }
+    for (D_File *child = file->child; child != NULL; child = child->next) {
+      count_outputs(child, path_len, sizes);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// path holds the directories leading to file and is extended in place when
+// descending, idents are carved from the arena sized by count_outputs
+int add_output_from_file(D_File *file, char *path, size_t path_len,
+                         size_t set_index, char **ident_arena) {
+  char *ident;
+  switch (file->type) {
+  case FILE:
+    ident = *ident_arena;
+    *ident_arena += path_len + file->name_len;
+    memcpy(ident, path, path_len);
+    memcpy(ident + path_len, file->name, file->name_len);
+    char *content_buf;
+    size_t buff_len;
+    if (file_content(file, &content_buf, &buff_len) != 0) {
+      dandelion_exit(ENOMEM);
+      return -1;
     }
     IoBuffer new_out = {.data = content_buf,
                         .data_len = buff_len,
-                        .ident = new_buffer,
-                        .ident_len = name_length + previous_path.length,
+                        .ident = ident,
+                        .ident_len = path_len + file->name_len,
                         .key = 0};
     dandelion_add_output(set_index, new_out);
     return 0;
   case DIRECTORY:
-    // check name length and create a new string / path to recurse further
-    name_length = namelen(file->name, FS_NAME_LENGTH);
-    new_buffer = dandelion_alloc(previous_path.length + name_length + 1, 1);
-    if (new_buffer == NULL) {
-      dandelion_exit(ENOMEM);
-      return -1;
-    }
-    memcpy(new_buffer, previous_path.path, previous_path.length);
-    memcpy(new_buffer + previous_path.length, file->name, name_length);
-    new_buffer[previous_path.length + name_length] = '/';
-    Path new_path = {
-        .length = previous_path.length + name_length + 1,
-        .path = new_buffer,
-    };
+    memcpy(path + path_len, file->name, file->name_len);
+    path_len += file->name_len;
+    path[path_len++] = '/';
     int error = 0;
     for (D_File *child = file->child; child != NULL; child = child->next) {
-      if ((error = add_output_from_file(child, new_path, set_index)) != 0)
+      error = add_output_from_file(child, path, path_len, set_index,
+                                   ident_arena);
+      if (error != 0)
         return error;
     }
-    dandelion_free(new_buffer);
     return 0;
   default:
     return -1;
@@ -687,8 +943,40 @@ int add_output_from_file(D_File *file, Path previous_path, size_t set_index) {
 
 int fs_terminate() {
   // go through output set names and find all files in folders that are
-  // named after them
+  // named after them, first pass finds the sizes of all allocations needed
   size_t output_sets = dandelion_output_set_count();
+  OutputSizes total = {.files = 0, .ident_bytes = 0, .max_path = 0};
+  for (size_t set_index = 0; set_index < output_sets; set_index++) {
+    Path set_ident = {.path = dandelion_output_set_ident(set_index),
+                      .length = dandelion_output_set_ident_len(set_index)};
+    D_File *set_directory = find_file_in_dir(&fs_root, set_ident);
+    if (set_directory == NULL) {
+      continue;
+    }
+    size_t previous_files = total.files;
+    for (D_File *out_file = set_directory->child; out_file != NULL;
+         out_file = out_file->next) {
+      if (!is_stdio_input(set_ident, out_file)) {
+        count_outputs(out_file, 0, &total);
+      }
+    }
+    size_t set_files = total.files - previous_files;
+    if (dandelion_reserve_outputs(set_index, set_files) != 0) {
+      dandelion_exit(ENOMEM);
+      return -1;
+    }
+  }
+  if (total.files == 0) {
+    return 0;
+  }
+  // idents need to live until exit, path is only needed while walking
+  char *ident_arena = dandelion_alloc(total.ident_bytes + 1, 1);
+  char *path = dandelion_alloc(total.max_path + 1, 1);
+  if (ident_arena == NULL || path == NULL) {
+    dandelion_exit(ENOMEM);
+    return -1;
+  }
+  // create a output for each file in the directory
   for (size_t set_index = 0; set_index < output_sets; set_index++) {
     Path set_ident = {.path = dandelion_output_set_ident(set_index),
                       .length = dandelion_output_set_ident_len(set_index)};
@@ -696,19 +984,13 @@ int fs_terminate() {
     if (set_directory == NULL) {
       continue;
     }
-    // create a output for each file in the directory
-    Path empty_path = {.path = NULL, .length = 0};
     for (D_File *out_file = set_directory->child; out_file != NULL;
          out_file = out_file->next) {
-      // ignore argv, environ and stdin in the stdio folder
-      if (namecmp(set_ident.path, set_ident.length, "stdio", 5) == 0) {
-        if (namecmp(out_file->name, FS_NAME_LENGTH, "environ", 7) == 0 ||
-            namecmp(out_file->name, FS_NAME_LENGTH, "argv", 4) == 0 ||
-            namecmp(out_file->name, FS_NAME_LENGTH, "stdin", 5) == 0)
-          continue;
+      if (!is_stdio_input(set_ident, out_file)) {
+        add_output_from_file(out_file, path, 0, set_index, &ident_arena);
       }
-      add_output_from_file(out_file, empty_path, set_index);
     }
   }
+  dandelion_free(path);
   return 0;
 }
@@ -5,14 +5,39 @@
 
 #include "paths.h"
 
+// limit for names created by the function, names of input items and sets are
+// only limited by their ident
 #ifndef FS_NAME_LENGTH
-#define FS_NAME_LENGTH 64
+#define FS_NAME_LENGTH 256
 #endif
 
 #ifndef FS_CHUNK_SIZE
 #define FS_CHUNK_SIZE 4096
 #endif
 
+// largest block size reported by stat, which libc uses to size the buffers
+// of its streams, needs to be a power of two
+#ifndef FS_MAX_BLOCK_SIZE
+#define FS_MAX_BLOCK_SIZE (16 * FS_CHUNK_SIZE)
+#endif
+
+// block size for files without data, which are mostly outputs that are about
+// to be written
+#ifndef FS_EMPTY_BLOCK_SIZE
+#define FS_EMPTY_BLOCK_SIZE (4 * FS_CHUNK_SIZE)
+#endif
+
+// needs to be a power of two
+#ifndef FS_PIPE_CAPACITY
+#define FS_PIPE_CAPACITY (4 * FS_CHUNK_SIZE)
+#endif
+
+// first chunks of files up to this size store their data right after the
+// chunk header in the same allocation
+#ifndef FS_INLINE_SIZE
+#define FS_INLINE_SIZE 512
+#endif
+
 #ifndef FS_MAX_FILES
 #define FS_MAX_FILES 1024
 #endif
@@ -36,20 +61,38 @@ typedef struct FileChunk {
   char *data;
   size_t capacity;
   size_t used;
+  // data of input files belongs to the platform and is never freed
+  char owns_data;
+  // data sits right after the header in an inline size class allocation
+  char is_inline;
   struct FileChunk *next;
 } FileChunk;
 
+// inline chunks are only ever the first chunk of a file, their data is freed
+// together with the chunk
+static inline int is_inline_chunk(FileChunk *chunk) {
+  return chunk->is_inline;
+}
+
 typedef struct Device {
   // for devices that need state can store pointer to arbitrary function
   void *state;
   // functions a device needs to implement
-  size_t (*read)(char *, size_t, int64_t, char);
-  size_t (*write)(char *, size_t, int64_t, char);
+  size_t (*read)(struct Device *, char *, size_t, int64_t, char);
+  size_t (*write)(struct Device *, char *, size_t, int64_t, char);
+  // optional, called when a descriptor opened with the given flags is closed
+  void (*close)(struct Device *, int);
+  // optional, frees the device once the file holding it is freed, devices
+  // without it are static and never freed
+  void (*release)(struct Device *);
 } Device;
 
 // Use D_File instead of File, to avoid potential naming overlap
 typedef struct D_File {
-  char name[FS_NAME_LENGTH];
+  // not zero terminated, points into the ident of an input, a static string
+  // or the name arena, see intern_name
+  const char *name;
+  size_t name_len;
   struct D_File *next;
   struct D_File *parent;
   FileType type;
@@ -60,6 +103,9 @@ typedef struct D_File {
   };
   unsigned short hard_links;
   unsigned short open_descripotors;
+  // set once the file was handed to the platform as an output, it is then no
+  // longer in the tree and its content is not freed
+  char published;
   // contains mode as described in stat.h
   // https://pubs.opengroup.org/onlinepubs/007904975/basedefs/sys/stat.h.html
   // the mode contains the file type, access bits and set-id bits
@@ -75,25 +121,38 @@ typedef struct OpenFile {
   // this means they contain one of O_RDONLY, O_WRONLY or O_RDWR and optionally
   // more
   int open_flags;
+  // number of file descriptors sharing this open file description
+  unsigned int references;
+  // set by the first write through this description
+  char written;
 } OpenFile;
 
 // find a file in a directory using a path as name
 // caller needs to ensure that direcotry is actually a directory
-// and that path is short enough to be valid file name
 D_File *find_file_in_dir(D_File *directory, Path file);
 
 // find a file using a absolute string path
 D_File *find_file(const char *name);
 // find a file using a path of the absolute name
 D_File *find_file_path(Path file_path);
+// find a file using a path relative to directory, absolute paths start at the
+// root regardless of directory
+D_File *find_file_path_from(D_File *directory, Path file_path);
 
 // follow a path and create all directories on the way that do not already
 // exist prevent up prevents moving up in the file tree, to prevent input
 // items getting written into different input sets by going up the file tree
-D_File *create_directories(D_File *directory, Path path, char prevent_up);
+// copy names interns the names of new directories, otherwise they reference
+// the path, which then needs to outlive them
+D_File *create_directories(D_File *directory, Path path, char prevent_up,
+                           char copy_names);
 
+// the file references the name, which needs to outlive it
 D_File *create_file(Path *name, char *content, size_t length, uint32_t mode);
 
+// free a single chunk and its data
+void free_file_chunk(FileChunk *chunk);
+
 // deallocate file and all data it holds on to
 // for directory also deallocate files in folder
 int free_data(D_File *file);
@@ -101,7 +160,24 @@ int free_data(D_File *file);
 // add file to be pointed to by folder
 int link_file_to_folder(D_File *folder, D_File *file);
 
+// remove file from the folder it is linked to, without freeing its data
+int unlink_file_from_folder(D_File *file);
+
+// remove file from its folder and free it if nothing refers to it anymore
+int remove_file(D_File *file);
+
+// hand a file in an output set directory to the platform as an output and
+// remove it from the tree, returns 0 or a negative error code
+int publish_output_file(D_File *file);
+
 int open_existing_file(unsigned int index, D_File *file, int flags,
                        uint32_t mode, char skip_checks);
 
+// drop one reference to an open file description, closing it and freeing the
+// file if nothing refers to it anymore once the last reference is gone
+void release_open_file(OpenFile *open_file);
+
+// create an unnamed pipe device with a fixed capacity ring buffer
+D_File *create_pipe(void);
+
 #endif // __DANDELION_FILE_SYSTEM__
\ No newline at end of file
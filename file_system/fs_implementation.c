@@ -5,9 +5,23 @@
 #include "file_system.h"
 #include "include/fs_interface.h"
 #include "paths.h"
+#include "slab.h"
 
 extern D_File fs_root;
-extern OpenFile open_files[];
+extern OpenFile *open_files[];
+extern char stdio_is_tty;
+
+// descriptor flags are per descriptor and not shared between duplicates, the
+// only one is FD_CLOEXEC, which is only stored as there is no exec
+static unsigned char descriptor_flags[FS_MAX_FILES] = {0};
+
+// get the open file description a descriptor refers to, NULL if not open
+static inline OpenFile *get_open_file(int file) {
+  if (file < 0 || file >= FS_MAX_FILES) {
+    return NULL;
+  }
+  return open_files[file];
+}
 
 // Allocate new filesystem chunk, return NULL if ENOMEM;
 // round up allocation to next multiple of FS_CHUNK_SIZE
@@ -18,8 +32,7 @@ FileChunk *allocate_file_chunk(size_t size) {
   if (new_buffer == NULL) {
     return NULL;
   }
-  FileChunk *new_chunck =
-      dandelion_alloc(sizeof(FileChunk), _Alignof(FileChunk));
+  FileChunk *new_chunck = slab_alloc(&chunk_cache);
   if (new_chunck == NULL) {
     dandelion_free(new_buffer);
     return NULL;
@@ -27,23 +40,62 @@ FileChunk *allocate_file_chunk(size_t size) {
   new_chunck->capacity = chunk_size;
   new_chunck->data = new_buffer;
   new_chunck->used = 0;
+  new_chunck->owns_data = 1;
+  new_chunck->is_inline = 0;
   new_chunck->next = NULL;
   return new_chunck;
 }
 
-static inline void free_file_chunk(FileChunk *chunk) {
-  dandelion_free(chunk->data);
-  dandelion_free(chunk);
-  return;
+// Allocate the first chunk of a file, small ones get their data in the same
+// allocation as the header, rounded up to the next inline size class
+static FileChunk *allocate_first_chunk(size_t size) {
+  if (size > FS_INLINE_SIZE) {
+    return allocate_file_chunk(size);
+  }
+  size_t capacity = size;
+  FileChunk *new_chunk = slab_alloc_inline(&capacity);
+  if (new_chunk == NULL) {
+    return NULL;
+  }
+  new_chunk->capacity = capacity;
+  new_chunk->data = (char *)(new_chunk + 1);
+  new_chunk->used = 0;
+  new_chunk->owns_data = 1;
+  new_chunk->is_inline = 1;
+  new_chunk->next = NULL;
+  return new_chunk;
+}
+
+// Replace the inline first chunk of a file with a regular chunk that has room
+// for additional bytes, moving open descriptions that point to it along
+static FileChunk *promote_inline_chunk(D_File *file, size_t additional) {
+  FileChunk *old_chunk = file->content;
+  FileChunk *new_chunk = allocate_file_chunk(old_chunk->used + additional);
+  if (new_chunk == NULL) {
+    return NULL;
+  }
+  memcpy(new_chunk->data, old_chunk->data, old_chunk->used);
+  new_chunk->used = old_chunk->used;
+  new_chunk->next = old_chunk->next;
+  file->content = new_chunk;
+  for (size_t index = 0; index < FS_MAX_FILES; index++) {
+    if (open_files[index] != NULL &&
+        open_files[index]->current_chunk == old_chunk) {
+      open_files[index]->current_chunk = new_chunk;
+    }
+  }
+  free_file_chunk(old_chunk);
+  return new_chunk;
 }
 
-// Fake that stdin, stdout and stderr are TTY
+// There is no terminal, so stdio is not a TTY and libc fully buffers it,
+// functions that need interactive behaviour can fake one through environ
 int dandelion_isatty(int file) {
   switch (file) {
   case STDIN_FILENO:
   case STDOUT_FILENO:
   case STDERR_FILENO:
-    return 1;
+    return stdio_is_tty;
   default:
     return 0;
   }
@@ -71,7 +123,7 @@ int dandelion_link(const char *old, const char *new_name) {
   Path new_path = path_from_string(new_name);
   Path new_file_name = get_file(new_path);
   Path new_file_dir = get_directories(new_path);
-  D_File *new_dir = create_directories(&fs_root, new_file_dir, 0);
+  D_File *new_dir = create_directories(&fs_root, new_file_dir, 0, 1);
   if (new_dir == NULL) {
     return -ENOTDIR;
   }
@@ -104,6 +156,148 @@ int dandelion_unlink(const char *name) {
   return 0;
 }
 
+// find the directory a *at function resolves relative paths from
+// AT_FDCWD resolves from the root, which is also the working directory
+static D_File *directory_from_descriptor(int dirfd) {
+  if (dirfd == AT_FDCWD) {
+    return &fs_root;
+  }
+  OpenFile *open_file = get_open_file(dirfd);
+  if (open_file == NULL) {
+    return NULL;
+  }
+  return open_file->file;
+}
+
+static inline int is_dot_or_dotdot(Path name) {
+  return (name.length == 1 && name.path[0] == '.') ||
+         (name.length == 2 && name.path[0] == '.' && name.path[1] == '.');
+}
+
+// move the node to its new name, this only relinks the existing node, so
+// neither file content nor subtrees are copied and open descriptors stay valid
+int dandelion_renameat(int old_dirfd, const char *old, int new_dirfd,
+                       const char *new_name) {
+  D_File *old_base = directory_from_descriptor(old_dirfd);
+  D_File *new_base = directory_from_descriptor(new_dirfd);
+  if (old_base == NULL || new_base == NULL) {
+    return -EBADF;
+  }
+  if (old_base->type != DIRECTORY || new_base->type != DIRECTORY) {
+    return -ENOTDIR;
+  }
+  Path old_path = path_from_string(old);
+  Path new_path = path_from_string(new_name);
+  if (old_path.length == 0 || new_path.length == 0) {
+    return -ENOENT;
+  }
+  if (is_dot_or_dotdot(get_file(old_path)) ||
+      is_dot_or_dotdot(get_file(new_path))) {
+    return -EINVAL;
+  }
+  D_File *file = find_file_path_from(old_base, old_path);
+  if (file == NULL) {
+    return -ENOENT;
+  }
+  // the root has no parent and can not be moved
+  if (file->parent == NULL) {
+    return -EINVAL;
+  }
+  Path new_file_name = get_file(new_path);
+  if (new_file_name.length >= FS_NAME_LENGTH) {
+    return -ENAMETOOLONG;
+  }
+  // absolute names lose their leading '/' when splitting off the directory
+  if (new_path.path[0] == '/') {
+    new_base = &fs_root;
+  }
+  D_File *new_dir = find_file_path_from(new_base, get_directories(new_path));
+  if (new_dir == NULL) {
+    return -ENOENT;
+  }
+  if (new_dir->type != DIRECTORY) {
+    return -ENOTDIR;
+  }
+  // a directory can not be moved into its own subtree
+  if (file->type == DIRECTORY) {
+    for (D_File *ancestor = new_dir; ancestor != NULL;
+         ancestor = ancestor->parent) {
+      if (ancestor == file) {
+        return -EINVAL;
+      }
+    }
+  }
+  D_File *existing = find_file_in_dir(new_dir, new_file_name);
+  if (existing == file) {
+    return 0;
+  }
+  if (existing != NULL) {
+    // replacing only works between files or onto an empty directory
+    if (file->type == DIRECTORY) {
+      if (existing->type != DIRECTORY) {
+        return -ENOTDIR;
+      }
+      if (existing->child != NULL) {
+        return -ENOTEMPTY;
+      }
+    } else if (existing->type == DIRECTORY) {
+      return -EISDIR;
+    }
+  }
+  // the existing target is only removed once nothing else can fail
+  const char *name = intern_name(new_file_name.path, new_file_name.length);
+  if (name == NULL) {
+    return -ENOMEM;
+  }
+  D_File *old_dir = file->parent;
+  if (unlink_file_from_folder(file) != 0) {
+    return -EINVAL;
+  }
+  // data of the replaced file stays around while it is still open
+  if (existing != NULL && remove_file(existing) != 0) {
+    link_file_to_folder(old_dir, file);
+    return -EINVAL;
+  }
+  file->name = name;
+  file->name_len = new_file_name.length;
+  // know new_dir is a directory, so this can not fail
+  link_file_to_folder(new_dir, file);
+  return 0;
+}
+
+int dandelion_rename(const char *old, const char *new_name) {
+  return dandelion_renameat(AT_FDCWD, old, AT_FDCWD, new_name);
+}
+
+int dandelion_publish(const char *name) {
+  D_File *file = find_file(name);
+  if (file == NULL) {
+    return -ENOENT;
+  }
+  if (file->type == DIRECTORY) {
+    return -EISDIR;
+  }
+  if (file->type != FILE) {
+    return -EINVAL;
+  }
+  if (file->open_descripotors != 0 || file->hard_links != 1) {
+    return -EBUSY;
+  }
+  return publish_output_file(file);
+}
+
+// find lowest non taken file descriptor starting from start, returns
+// FS_MAX_FILES if all are taken
+static unsigned int lowest_free_descriptor(unsigned int start) {
+  unsigned int file_descriptor = start;
+  for (; file_descriptor < FS_MAX_FILES; file_descriptor++) {
+    if (open_files[file_descriptor] == NULL) {
+      break;
+    }
+  }
+  return file_descriptor;
+}
+
 // currently do not handle O_TMPFILE
 int dandelion_open(const char *name, int flags, uint32_t mode) {
   // check if file is already open, if so fail O_TRUNC with EACCESS
@@ -127,10 +321,15 @@ int dandelion_open(const char *name, int flags, uint32_t mode) {
     if (file_name.length >= FS_NAME_LENGTH) {
       return -EINVAL;
     }
-    D_File *parent = create_directories(&fs_root, dir_path, 0);
+    D_File *parent = create_directories(&fs_root, dir_path, 0, 1);
     if (parent == NULL) {
       return -ENOTDIR;
     }
+    // the name passed in only lives for the call
+    file_name.path = intern_name(file_name.path, file_name.length);
+    if (file_name.path == NULL) {
+      return -ENOMEM;
+    }
     current = create_file(&file_name, NULL, 0, 0);
     if (current == NULL) {
       return -ENOMEM;
@@ -141,13 +340,7 @@ int dandelion_open(const char *name, int flags, uint32_t mode) {
     }
   }
   // at this point know that current is pointing to a valid file
-  // find lowerst non taken file descriptor
-  unsigned int file_descriptor = 0;
-  for (; file_descriptor < FS_MAX_FILES; file_descriptor++) {
-    if (open_files[file_descriptor].file == NULL) {
-      break;
-    }
-  }
+  unsigned int file_descriptor = lowest_free_descriptor(0);
   if (file_descriptor == FS_MAX_FILES) {
     return -EMFILE;
   }
@@ -175,7 +368,7 @@ int dandelion_mkdir(const char *name, uint32_t mode) {
   if (existing != NULL) {
     return -EEXIST;
   }
-  D_File *new_dir = create_directories(parent_file, dir_name, 0);
+  D_File *new_dir = create_directories(parent_file, dir_name, 0, 1);
   if (new_dir == NULL) {
     return -ENOMEM;
   }
@@ -197,22 +390,119 @@ int dandelion_rmdir(const char *name) {
 
 int dandelion_close(int file) {
   // check the file is open
-  D_File *to_close = open_files[file].file;
+  OpenFile *to_close = get_open_file(file);
   if (to_close == NULL) {
     return -EBADF;
   }
-  to_close->open_descripotors -= 1;
-  free_data(to_close);
-  open_files[file].file = NULL;
+  open_files[file] = NULL;
+  descriptor_flags[file] = 0;
+  release_open_file(to_close);
+  return 0;
+}
+
+int dandelion_dup(int file, int min_file, int flags) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL) {
+    return -EBADF;
+  }
+  if (min_file < 0 || min_file >= FS_MAX_FILES) {
+    return -EINVAL;
+  }
+  unsigned int new_file = lowest_free_descriptor(min_file);
+  if (new_file == FS_MAX_FILES) {
+    return -EMFILE;
+  }
+  open_file->references += 1;
+  open_files[new_file] = open_file;
+  descriptor_flags[new_file] = flags & FD_CLOEXEC;
+  return new_file;
+}
+
+int dandelion_dup2(int file, int new_file, int flags) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL || new_file < 0 || new_file >= FS_MAX_FILES) {
+    return -EBADF;
+  }
+  if (file == new_file) {
+    return new_file;
+  }
+  // take the reference first, so closing the target can never free the
+  // description we are duplicating
+  open_file->references += 1;
+  if (open_files[new_file] != NULL) {
+    release_open_file(open_files[new_file]);
+  }
+  open_files[new_file] = open_file;
+  descriptor_flags[new_file] = flags & FD_CLOEXEC;
+  return new_file;
+}
+
+int dandelion_fcntl(int file, int command, int argument) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL) {
+    return -EBADF;
+  }
+  switch (command) {
+  case F_DUPFD:
+    return dandelion_dup(file, argument, 0);
+  case F_DUPFD_CLOEXEC:
+    return dandelion_dup(file, argument, FD_CLOEXEC);
+  case F_GETFD:
+    return descriptor_flags[file];
+  case F_SETFD:
+    descriptor_flags[file] = argument & FD_CLOEXEC;
+    return 0;
+  case F_GETFL:
+    return open_file->open_flags;
+  case F_SETFL:
+    // the access mode can not be changed after opening
+    open_file->open_flags = (open_file->open_flags & O_ACCMODE) |
+                            (argument & (O_APPEND | O_NONBLOCK));
+    return 0;
+  default:
+    return -EINVAL;
+  }
+}
+
+int dandelion_pipe(int fds[2]) {
+  unsigned int read_end = lowest_free_descriptor(0);
+  if (read_end == FS_MAX_FILES) {
+    return -EMFILE;
+  }
+  unsigned int write_end = lowest_free_descriptor(read_end + 1);
+  if (write_end == FS_MAX_FILES) {
+    return -EMFILE;
+  }
+  D_File *pipe = create_pipe();
+  if (pipe == NULL) {
+    return -ENOMEM;
+  }
+  // skip permission checks, the pipe is readable and writable from the start
+  int error = open_existing_file(read_end, pipe, O_RDONLY, 0, 0);
+  if (error < 0) {
+    free_data(pipe);
+    return error;
+  }
+  error = open_existing_file(write_end, pipe, O_WRONLY, 0, 0);
+  if (error < 0) {
+    // closing the only reader releases the pipe
+    dandelion_close(read_end);
+    return error;
+  }
+  fds[0] = read_end;
+  fds[1] = write_end;
   return 0;
 }
 
 int64_t dandelion_lseek(int file, int64_t offset, int whence) {
   int return_val = 0;
   int total_offset = 0;
-  OpenFile *open_file = &open_files[file];
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL) {
+    return -EBADF;
+  }
   D_File *backing_file = open_file->file;
-  if (backing_file == NULL || backing_file->type != FILE) {
+  if (backing_file->type != FILE) {
     return -EBADF;
   }
   // perform seek in phases
@@ -337,15 +627,15 @@ int64_t dandelion_lseek(int file, int64_t offset, int whence) {
 size_t dandelion_read(int file, char *ptr, size_t len, int64_t offset,
                       char options) {
   // get the file descriptor
-  OpenFile *open_file = &open_files[file];
-  // check there is a valid file descriptor there and that it is writable
-  if (open_file->file == NULL || open_file->open_flags & O_WRONLY) {
+  OpenFile *open_file = get_open_file(file);
+  // check there is a valid file descriptor there and that it is readable
+  if (open_file == NULL || open_file->open_flags & O_WRONLY) {
     return -EBADF;
   }
 
   if (open_file->file->type == DEVICE) {
-    size_t result = open_file->file->device->read(ptr, len, offset, options);
-    return result;
+    Device *device = open_file->file->device;
+    return device->read(device, ptr, len, offset, options);
   } else if (open_file->file->type != FILE) {
     return -EINVAL;
   }
@@ -419,28 +709,72 @@ size_t dandelion_read(int file, char *ptr, size_t len, int64_t offset,
   return read_bytes;
 }
 
+int64_t dandelion_read_view(int file, const char **data) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL || open_file->open_flags & O_WRONLY) {
+    return -EBADF;
+  }
+  if (open_file->file->type != FILE) {
+    return -EINVAL;
+  }
+  if (open_file->current_chunk == NULL) {
+    open_file->offset = 0;
+    open_file->current_chunk = open_file->file->content;
+    if (open_file->current_chunk == NULL) {
+      return 0;
+    }
+  }
+  // moving to the start of the next chunk keeps the position in the file
+  FileChunk *current = open_file->current_chunk;
+  while (open_file->offset == current->used && current->next != NULL) {
+    current = current->next;
+    open_file->current_chunk = current;
+    open_file->offset = 0;
+  }
+  *data = current->data + open_file->offset;
+  return current->used - open_file->offset;
+}
+
+int dandelion_read_advance(int file, size_t len) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL || open_file->file->type != FILE ||
+      open_file->current_chunk == NULL ||
+      open_file->current_chunk->used - open_file->offset < len) {
+    return -EINVAL;
+  }
+  open_file->offset += len;
+  return 0;
+}
+
 size_t dandelion_write(int file, char *ptr, size_t len, int64_t offset,
                        char options) {
   // get the file descriptor
-  OpenFile *open_file = &open_files[file];
+  OpenFile *open_file = get_open_file(file);
   // check there is a valid file descriptor there and that it is writable
-  if (open_file->file == NULL || open_file->open_flags & O_RDONLY) {
+  // O_RDONLY is 0, so need to compare the whole access mode
+  if (open_file == NULL || (open_file->open_flags & O_ACCMODE) == O_RDONLY) {
     return -EBADF;
   }
 
   if (open_file->file->type == DEVICE) {
-    return open_file->file->device->write(ptr, len, offset, options);
+    Device *device = open_file->file->device;
+    return device->write(device, ptr, len, offset, options);
   } else if (open_file->file->type != FILE) {
     return -EINVAL;
   }
 
+  if (len > 0) {
+    open_file->written = 1;
+  }
   D_File *d_file = open_file->file;
   FileChunk *current;
   size_t chunk_offset = 0;
   // check if file has content, if not allocate and skip to writing
   if (d_file->content == NULL) {
     size_t allocation_size = options & USE_OFFSET ? offset + len : len;
-    FileChunk *new_chunk = allocate_file_chunk(allocation_size);
+    FileChunk *new_chunk = allocate_first_chunk(allocation_size);
+    if (new_chunk == NULL)
+      return -ENOMEM;
     d_file->content = new_chunk;
     current = new_chunk;
   } else {
@@ -475,7 +809,7 @@ size_t dandelion_write(int file, char *ptr, size_t len, int64_t offset,
       current = open_file->current_chunk;
       if (current == NULL) {
         if (d_file->content == NULL) {
-          FileChunk *new_chunk = allocate_file_chunk(len);
+          FileChunk *new_chunk = allocate_first_chunk(len);
           if (new_chunk == NULL)
             return -ENOMEM;
           d_file->content = new_chunk;
@@ -501,6 +835,13 @@ size_t dandelion_write(int file, char *ptr, size_t len, int64_t offset,
   // know that we can start writing to end of current chunck
 
   size_t writen_bytes = 0;
+  // grow small files into a regular chunk at once instead of chaining a
+  // second chunk behind the inline one
+  if (is_inline_chunk(current) && current->capacity - current->used < len) {
+    current = promote_inline_chunk(d_file, len);
+    if (current == NULL)
+      return -ENOMEM;
+  }
   while (len > 0) {
     int writeable = current->capacity - current->used;
     if (writeable == 0) {
@@ -525,28 +866,51 @@ size_t dandelion_write(int file, char *ptr, size_t len, int64_t offset,
   return writen_bytes;
 }
 
+// preferred size for reads and writes, a power of two that covers the
+// largest chunk or an eighth of the file, so large files are moved in few
+// calls that each touch few chunks
+static size_t block_size(size_t total_size, size_t largest_chunk) {
+  if (total_size == 0) {
+    return FS_EMPTY_BLOCK_SIZE;
+  }
+  size_t wanted = total_size / 8;
+  if (wanted < largest_chunk) {
+    wanted = largest_chunk;
+  }
+  size_t size = FS_CHUNK_SIZE;
+  while (size < wanted && size < FS_MAX_BLOCK_SIZE) {
+    size *= 2;
+  }
+  return size;
+}
+
 static inline int __dandelion_stat(D_File *file, DandelionStat *st) {
   // assume file is non null, caller is supposed to check that
   st->st_mode = file->mode;
   st->hard_links = file->hard_links;
   size_t total_size = 0;
+  size_t largest_chunk = 0;
   if (file->type == FILE) {
     for (FileChunk *current = file->content; current != 0;
          current = current->next) {
       total_size += current->used;
+      if (current->used > largest_chunk) {
+        largest_chunk = current->used;
+      }
     }
   }
   st->file_size = total_size;
-  st->blk_size = FS_CHUNK_SIZE;
+  st->blk_size = file->type == FILE ? block_size(total_size, largest_chunk)
+                                    : FS_CHUNK_SIZE;
   return 0;
 }
 
 int dandelion_fstat(int file, DandelionStat *st) {
-  D_File *current_file = open_files[file].file;
-  if (current_file == NULL) {
+  OpenFile *open_file = get_open_file(file);
+  if (open_file == NULL) {
     return -EBADF;
   }
-  return __dandelion_stat(current_file, st);
+  return __dandelion_stat(open_file->file, st);
 }
 
 int dandelion_stat(const char *file, DandelionStat *st) {
@@ -593,12 +957,12 @@ static inline int __dandelion_truncate(D_File *file, int64_t length) {
 }
 
 int dandelion_ftruncate(int fd, int64_t length) {
-  D_File *current_file = open_files[fd].file;
-  if (current_file == NULL)
+  OpenFile *open_file = get_open_file(fd);
+  if (open_file == NULL)
     return -EBADF;
-  if (!(open_files[fd].open_flags & O_WRONLY))
+  if (!(open_file->open_flags & O_WRONLY))
     return -EBADF;
-  return __dandelion_truncate(current_file, length);
+  return __dandelion_truncate(open_file->file, length);
 }
 
 int dandelion_truncate(const char *path, int64_t length) {
@@ -650,9 +1014,10 @@ int dandelion_readdir(DIR *directory, struct dirent *dirent) {
     return -1;
   }
   directory->child++;
-  size_t max_name_length = MIN(256, FS_NAME_LENGTH);
-  memcpy(dirent->d_name, current_child->name, max_name_length - 1);
-  dirent->d_name[max_name_length] = 0;
+  size_t name_length =
+      MIN(current_child->name_len, sizeof(dirent->d_name) - 1);
+  memcpy(dirent->d_name, current_child->name, name_length);
+  dirent->d_name[name_length] = 0;
   dirent->d_ino = 0;
   dirent->d_off = index;
   dirent->d_type = current_child->type == FILE ? DT_REG : DT_DIR;
@@ -661,4 +1026,99 @@ int dandelion_readdir(DIR *directory, struct dirent *dirent) {
 }
 
 long int dandelion_telldir(DIR *dir) { return dir->child; }
-void dandelion_seekdir(DIR *dir, long int index) { dir->child = index; }
\ No newline at end of file
+void dandelion_seekdir(DIR *dir, long int index) { dir->child = index; }
+// ========================================================
+// glob functions
+// ========================================================
+
+typedef struct GlobWalk {
+  const DandelionGlobPart *parts;
+  size_t part_count;
+  DandelionGlobMatch match;
+  DandelionGlobFound found;
+  void *context;
+  char path[FS_PATH_LENGTH];
+} GlobWalk;
+
+static int glob_walk(GlobWalk *walk, D_File *directory, size_t part,
+                     size_t path_len);
+
+// append the name of a file matching a part to the path and continue with
+// the next part below it, or report it if it matched the last one
+static int glob_visit(GlobWalk *walk, D_File *file, const char *name,
+                      size_t name_len, size_t part, size_t path_len) {
+  size_t separator = path_len > 0 && walk->path[path_len - 1] != '/';
+  if (path_len + separator + name_len >= FS_PATH_LENGTH) {
+    return -ENAMETOOLONG;
+  }
+  if (separator) {
+    walk->path[path_len++] = '/';
+  }
+  memcpy(walk->path + path_len, name, name_len);
+  path_len += name_len;
+  walk->path[path_len] = '\0';
+  if (part + 1 == walk->part_count) {
+    return walk->found(walk->context, walk->path, path_len,
+                       file->type == DIRECTORY);
+  }
+  if (file->type != DIRECTORY) {
+    return 0;
+  }
+  return glob_walk(walk, file, part + 1, path_len);
+}
+
+static int glob_walk(GlobWalk *walk, D_File *directory, size_t part,
+                     size_t path_len) {
+  const DandelionGlobPart *current = &walk->parts[part];
+  if (current->literal) {
+    // literal parts prune the tree to a single child without listing it
+    Path name = {.path = current->pattern, .length = current->length};
+    D_File *file = find_file_in_dir(directory, name);
+    if (file == NULL) {
+      return 0;
+    }
+    return glob_visit(walk, file, current->pattern, current->length, part,
+                      path_len);
+  }
+  for (D_File *child = directory->child; child != NULL; child = child->next) {
+    if (walk->match(walk->context, part, child->name, child->name_len) == 0) {
+      continue;
+    }
+    int result =
+        glob_visit(walk, child, child->name, child->name_len, part, path_len);
+    if (result != 0) {
+      return result;
+    }
+  }
+  return 0;
+}
+
+int dandelion_glob(const char *start, size_t start_len,
+                   const DandelionGlobPart *parts, size_t part_count,
+                   DandelionGlobMatch match, DandelionGlobFound found,
+                   void *context) {
+  if (start_len >= FS_PATH_LENGTH) {
+    return -ENAMETOOLONG;
+  }
+  Path start_path = {.path = start, .length = start_len};
+  D_File *directory = find_file_path(start_path);
+  if (directory == NULL) {
+    return 0;
+  }
+  GlobWalk walk = {
+      .parts = parts,
+      .part_count = part_count,
+      .match = match,
+      .found = found,
+      .context = context,
+  };
+  memcpy(walk.path, start, start_len);
+  walk.path[start_len] = '\0';
+  if (part_count == 0) {
+    return found(context, walk.path, start_len, directory->type == DIRECTORY);
+  }
+  if (directory->type != DIRECTORY) {
+    return 0;
+  }
+  return glob_walk(&walk, directory, 0, start_len);
+}
@@ -9,14 +9,17 @@
 #define EPERM 1
 #define ENOENT 2
 #define EBADF 9
+#define EAGAIN 11
 #define ENOMEM 12
 #define EACCES 13
+#define EBUSY 16
 #define EEXIST 17
 #define ENOTDIR 20
 #define EISDIR 21
 #define EINVAL 22
 #define EMFILE 24
 #define EMLINK 31
+#define EPIPE 32
 #define ENAMETOOLONG 36
 #define ENOTEMPTY 39
 
@@ -37,7 +40,7 @@ struct dirent {
   size_t d_off;
   uint16_t d_ino;
   unsigned char d_type;
-  char d_name[64];
+  char d_name[256];
 };
 
 #define S_IXUSR 00100
@@ -45,6 +48,7 @@ struct dirent {
 #define S_IRUSR 00400
 #define S_IRWXU (S_IXUSR | S_IWUSR | S_IRUSR)
 
+#define S_IFIFO 0010000
 #define S_IFDIR 0040000
 #define S_IFREG 0100000
 
@@ -57,19 +61,58 @@ struct dirent {
 #define O_CREAT 0x200
 #define O_TRUNC 0x400
 #define O_EXCL 0x800
+#define O_NONBLOCK 0x4000
 #define O_ACCMODE (O_RDONLY | O_WRONLY | O_RDWR)
 
-// Fake that stdin, stdout and stderr are TTY
+// fcntl commands and descriptor flags, also matched to newlib
+#define F_DUPFD 0
+#define F_GETFD 1
+#define F_SETFD 2
+#define F_GETFL 3
+#define F_SETFL 4
+#define F_DUPFD_CLOEXEC 14
+#define FD_CLOEXEC 1
+#define AT_FDCWD -2
+
+// stdin, stdout and stderr are only reported as TTY if environ sets
+// DANDELION_TTY to a value other than 0
 int dandelion_isatty(int file);
 
 int dandelion_link(const char *old, const char *new_name);
 
 int dandelion_unlink(const char *name);
 
+// move a file or directory to a new name without copying any of its data
+// AT_FDCWD resolves relative paths from the root, other negative directory
+// descriptors are rejected with EBADF
+int dandelion_rename(const char *old, const char *new_name);
+int dandelion_renameat(int old_dirfd, const char *old, int new_dirfd,
+                       const char *new_name);
+
+// hand a finished file in an output set directory to the platform before exit
+// and remove it from the file system, so it can not change any more
+// fails with EBUSY while the file is open or has other links
+// if the platform streams outputs, this also happens on the last close of a
+// file right in an output set directory, if that description wrote to it
+int dandelion_publish(const char *name);
+
 int dandelion_open(const char *name, int flags, uint32_t mode);
 
 int dandelion_close(int file);
 
+// duplicate a descriptor onto the lowest free descriptor not below min_file,
+// both share the same offset and file status flags
+int dandelion_dup(int file, int min_file, int flags);
+// duplicate a descriptor onto new_file, closing what was open there before
+int dandelion_dup2(int file, int new_file, int flags);
+// supports F_DUPFD, F_DUPFD_CLOEXEC, F_GETFD, F_SETFD, F_GETFL and F_SETFL
+int dandelion_fcntl(int file, int command, int argument);
+
+// create a pipe, fds[0] is the read end and fds[1] the write end
+// pipes never block, reads and writes that can not make progress return EAGAIN
+// reads return 0 once the buffer is empty and all write ends are closed
+int dandelion_pipe(int fds[2]);
+
 int64_t dandelion_lseek(int file, int64_t offset, int whence);
 
 size_t dandelion_read(int file, char *ptr, size_t len, int64_t offset,
@@ -78,6 +121,14 @@ size_t dandelion_read(int file, char *ptr, size_t len, int64_t offset,
 size_t dandelion_write(int file, char *ptr, size_t len, int64_t offset,
                        char options);
 
+// point data to the bytes at the current offset of a regular file, up to the
+// end of the chunk holding them, without moving the offset
+// returns the number of bytes in the view, 0 at the end of the file and
+// -EINVAL for files that are not regular files like pipes and devices
+int64_t dandelion_read_view(int file, const char **data);
+// move the offset past len bytes of the current view
+int dandelion_read_advance(int file, size_t len);
+
 typedef struct DandelionStat {
   size_t st_mode;
   size_t hard_links;
@@ -94,6 +145,32 @@ int dandelion_fstat(int file, DandelionStat *st);
 int dandelion_truncate(const char *path, int64_t length);
 int dandelion_ftruncate(int fd, int64_t length);
 
+// one component of a glob pattern, literal components are looked up by name
+// without listing the directory, the pattern is not zero terminated
+typedef struct DandelionGlobPart {
+  const char *pattern;
+  size_t length;
+  char literal;
+} DandelionGlobPart;
+
+// decide if a name matches the non literal part with the given index
+typedef int (*DandelionGlobMatch)(void *context, size_t part, const char *name,
+                                  size_t name_len);
+// called with the zero terminated path of every file matching all parts, a
+// return other than 0 stops the walk and is returned from dandelion_glob
+typedef int (*DandelionGlobFound)(void *context, const char *path,
+                                  size_t path_len, int is_directory);
+
+// walk the file tree below the directory at start, an empty start is the
+// root, matching the parts one level at a time and only descending into
+// directories matching the parts so far
+// returns 0 once all matches are reported or -ENAMETOOLONG for paths that do
+// not fit FS_PATH_LENGTH
+int dandelion_glob(const char *start, size_t start_len,
+                   const DandelionGlobPart *parts, size_t part_count,
+                   DandelionGlobMatch match, DandelionGlobFound found,
+                   void *context);
+
 /// @brief initializes the filesystem from the existing sets and item buffers
 /// @return an erorr code or 0 if there were no error
 int fs_initialize(int *argc, char ***argv, char ***environ);
@@ -14,43 +14,13 @@ typedef struct Path {
 
 // implement these to make sure this can be build independenlty of any string.h
 
-static inline size_t namelen(const char *const name, size_t max_len) {
-  int length = 0;
-  while (length < max_len && name[length] != '\0') {
-    length++;
-  }
-  // need to count the last char
-  return length;
-}
-
-// the length parameters are the maximum length of the strings,
-// strings may be zero terminated earlier
+// names are ordered by length first and then bytewise, which is enough for
+// keeping directories sorted and lets most mismatches exit on the length
 static inline int namecmp(const char *const name1, size_t name1_length,
                           const char *const name2, size_t name2_length) {
-  size_t max_length = name1_length < name2_length ? name1_length : name2_length;
-  size_t index = 0;
-  for (; index < max_length; index++) {
-    if (name1[index] == name2[index] & name1[index] != '\0')
-      continue;
-    // know that either they are unequal or they are now both at null
-    // termination
-    if (name1[index] == '\0' && name2[index] == '\0')
-      return 0;
-    else if (name1[index] == '\0')
-      return -1;
-    else if (name2[index] == '\0')
-      return 1;
-    else
-      return name1[index] < name2[index] ? -1 : 1;
-  }
-  // they are the same until the end of the shorter one or there has not been
-  // null termination
-  if (name1_length < name2_length && name2[index] != '\0')
-    return -1;
-  else if (name2_length < name1_length && name1[index] != '\0')
-    return 1;
-  else
-    return 0;
+  if (name1_length != name2_length)
+    return name1_length < name2_length ? -1 : 1;
+  return __builtin_memcmp(name1, name2, name1_length);
 }
 
 Path path_from_string(const char *const str);
@@ -0,0 +1,122 @@
+#include <dandelion/runtime.h>
+#include <dandelion/system/system.h>
+#include <stddef.h>
+
+#include "file_system.h"
+#include "include/fs_interface.h"
+#include "slab.h"
+
+// Pipes are devices that hold a ring buffer of fixed capacity.
+// The read and write index only ever grow, their difference is the number of
+// bytes currently in the buffer. As everything runs in a single thread, reads
+// and writes never block, but return EAGAIN when they can not make progress.
+typedef struct Pipe {
+  char *buffer;
+  size_t read_index;
+  size_t write_index;
+  unsigned short readers;
+  unsigned short writers;
+} Pipe;
+
+static size_t pipe_read(Device *device, char *ptr, size_t len, int64_t offset,
+                        char options) {
+  // pipes are not seekable, so offset and options are ignored
+  Pipe *pipe = device->state;
+  size_t available = pipe->write_index - pipe->read_index;
+  if (available == 0) {
+    // only report end of file once there is nobody left to write
+    return pipe->writers == 0 ? 0 : -EAGAIN;
+  }
+  size_t to_read = MIN(len, available);
+  size_t start = pipe->read_index & (FS_PIPE_CAPACITY - 1);
+  size_t first_part = MIN(to_read, FS_PIPE_CAPACITY - start);
+  memcpy(ptr, pipe->buffer + start, first_part);
+  memcpy(ptr + first_part, pipe->buffer, to_read - first_part);
+  pipe->read_index += to_read;
+  return to_read;
+}
+
+static size_t pipe_write(Device *device, char *ptr, size_t len,
+                         int64_t offset, char options) {
+  Pipe *pipe = device->state;
+  if (pipe->readers == 0) {
+    return -EPIPE;
+  }
+  if (len == 0) {
+    return 0;
+  }
+  size_t space = FS_PIPE_CAPACITY - (pipe->write_index - pipe->read_index);
+  if (space == 0) {
+    return -EAGAIN;
+  }
+  size_t to_write = MIN(len, space);
+  size_t start = pipe->write_index & (FS_PIPE_CAPACITY - 1);
+  size_t first_part = MIN(to_write, FS_PIPE_CAPACITY - start);
+  memcpy(pipe->buffer + start, ptr, first_part);
+  memcpy(pipe->buffer, ptr + first_part, to_write - first_part);
+  pipe->write_index += to_write;
+  return to_write;
+}
+
+static void pipe_close(Device *device, int open_flags) {
+  Pipe *pipe = device->state;
+  if (open_flags & O_WRONLY) {
+    pipe->writers -= 1;
+  } else {
+    pipe->readers -= 1;
+  }
+}
+
+static void pipe_release(Device *device) {
+  Pipe *pipe = device->state;
+  dandelion_free(pipe->buffer);
+  dandelion_free(pipe);
+  dandelion_free(device);
+}
+
+D_File *create_pipe(void) {
+  char *buffer = dandelion_alloc(FS_PIPE_CAPACITY, _Alignof(max_align_t));
+  if (buffer == NULL) {
+    return NULL;
+  }
+  Pipe *pipe = dandelion_alloc(sizeof(Pipe), _Alignof(Pipe));
+  if (pipe == NULL) {
+    dandelion_free(buffer);
+    return NULL;
+  }
+  Device *device = dandelion_alloc(sizeof(Device), _Alignof(Device));
+  if (device == NULL) {
+    dandelion_free(pipe);
+    dandelion_free(buffer);
+    return NULL;
+  }
+  device->state = pipe;
+  D_File *file = slab_alloc(&file_cache);
+  if (file == NULL) {
+    pipe_release(device);
+    return NULL;
+  }
+  pipe->buffer = buffer;
+  pipe->read_index = 0;
+  pipe->write_index = 0;
+  // one of each end is opened by the caller
+  pipe->readers = 1;
+  pipe->writers = 1;
+  device->read = pipe_read;
+  device->write = pipe_write;
+  device->close = pipe_close;
+  device->release = pipe_release;
+  // pipes are not linked into any folder, so they are freed as soon as both
+  // ends are closed
+  file->name = "";
+  file->name_len = 0;
+  file->next = NULL;
+  file->parent = NULL;
+  file->type = DEVICE;
+  file->device = device;
+  file->hard_links = 0;
+  file->open_descripotors = 0;
+  file->published = 0;
+  file->mode = S_IFIFO | S_IRUSR | S_IWUSR;
+  return file;
+}
@@ -0,0 +1,137 @@
+#include "slab.h"
+
+#include <dandelion/runtime.h>
+
+#include "file_system.h"
+
+#define SLAB_OBJECT_SIZE(size)                                                 \
+  ((((size) + _Alignof(max_align_t) - 1) / _Alignof(max_align_t)) *           \
+   _Alignof(max_align_t))
+
+SlabCache file_cache = {.object_size = SLAB_OBJECT_SIZE(sizeof(D_File)),
+                        .free_list = NULL};
+SlabCache chunk_cache = {.object_size = SLAB_OBJECT_SIZE(sizeof(FileChunk)),
+                         .free_list = NULL};
+SlabCache open_file_cache = {
+    .object_size = SLAB_OBJECT_SIZE(sizeof(OpenFile)), .free_list = NULL};
+
+// size classes for inline chunks, from the alignment of max_align_t up to
+// FS_INLINE_SIZE in powers of two
+#define INLINE_CLASSES 8
+static SlabCache inline_caches[INLINE_CLASSES];
+
+// sizes up to FS_INLINE_SIZE are only all served if it is one of the classes
+_Static_assert((FS_INLINE_SIZE & (FS_INLINE_SIZE - 1)) == 0,
+               "FS_INLINE_SIZE needs to be a power of two");
+_Static_assert(FS_INLINE_SIZE >= _Alignof(max_align_t) &&
+                   FS_INLINE_SIZE <= (_Alignof(max_align_t)
+                                      << (INLINE_CLASSES - 1)),
+               "FS_INLINE_SIZE needs to be within the inline size classes");
+
+// bump region for names created at runtime, names longer than a slab get
+// their own allocation
+static char *name_arena = NULL;
+static size_t name_arena_left = 0;
+
+static inline size_t inline_class_capacity(size_t class_index) {
+  return _Alignof(max_align_t) << class_index;
+}
+
+static int slab_grow(SlabCache *cache) {
+  char *slab = dandelion_alloc(FS_SLAB_SIZE, _Alignof(max_align_t));
+  if (slab == NULL) {
+    return -1;
+  }
+  // push in reverse so objects are handed out in address order
+  size_t objects = FS_SLAB_SIZE / cache->object_size;
+  for (size_t index = objects; index > 0; index--) {
+    char *address = slab + (index - 1) * cache->object_size;
+    SlabObject *object = (SlabObject *)address;
+    object->next = cache->free_list;
+    cache->free_list = object;
+  }
+  return 0;
+}
+
+void *slab_alloc(SlabCache *cache) {
+  if (cache->free_list == NULL && slab_grow(cache) != 0) {
+    return NULL;
+  }
+  SlabObject *object = cache->free_list;
+  cache->free_list = object->next;
+  return object;
+}
+
+void slab_free(SlabCache *cache, void *object) {
+  SlabObject *freed = object;
+  freed->next = cache->free_list;
+  cache->free_list = freed;
+}
+
+// smallest class holding capacity, INLINE_CLASSES if there is none
+static inline size_t inline_class_index(size_t capacity) {
+  size_t class_index = 0;
+  while (class_index < INLINE_CLASSES &&
+         inline_class_capacity(class_index) < capacity) {
+    class_index++;
+  }
+  return class_index;
+}
+
+void *slab_alloc_inline(size_t *capacity) {
+  size_t class_index = inline_class_index(*capacity);
+  if (class_index >= INLINE_CLASSES ||
+      inline_class_capacity(class_index) > FS_INLINE_SIZE) {
+    return NULL;
+  }
+  SlabCache *cache = &inline_caches[class_index];
+  if (cache->object_size == 0) {
+    cache->object_size = SLAB_OBJECT_SIZE(sizeof(FileChunk)) +
+                         inline_class_capacity(class_index);
+  }
+  *capacity = inline_class_capacity(class_index);
+  return slab_alloc(cache);
+}
+
+void slab_free_inline(void *object, size_t capacity) {
+  size_t class_index = inline_class_index(capacity);
+  if (class_index >= INLINE_CLASSES) {
+    return;
+  }
+  slab_free(&inline_caches[class_index], object);
+}
+
+const char *intern_name(const char *name, size_t length) {
+  char *copy;
+  if (length == 0) {
+    return "";
+  } else if (length > FS_SLAB_SIZE / 4) {
+    copy = dandelion_alloc(length, 1);
+  } else {
+    if (name_arena_left < length) {
+      name_arena = dandelion_alloc(FS_SLAB_SIZE, 1);
+      name_arena_left = name_arena == NULL ? 0 : FS_SLAB_SIZE;
+    }
+    copy = name_arena;
+    if (copy != NULL) {
+      name_arena += length;
+      name_arena_left -= length;
+    }
+  }
+  if (copy == NULL) {
+    return NULL;
+  }
+  __builtin_memcpy(copy, name, length);
+  return copy;
+}
+
+void slab_reset(void) {
+  name_arena = NULL;
+  name_arena_left = 0;
+  file_cache.free_list = NULL;
+  chunk_cache.free_list = NULL;
+  open_file_cache.free_list = NULL;
+  for (size_t class_index = 0; class_index < INLINE_CLASSES; class_index++) {
+    inline_caches[class_index].free_list = NULL;
+  }
+}
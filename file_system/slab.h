@@ -0,0 +1,46 @@
+#ifndef __DANDELION_SLAB__
+#define __DANDELION_SLAB__
+
+#include <stddef.h>
+
+// Pools for the fixed size file system metadata.
+// Each cache carves objects of one size out of FS_SLAB_SIZE slabs taken from
+// dandelion_alloc and keeps freed objects on a free list for reuse, so
+// metadata stays close together and the general allocator only sees slabs.
+
+#ifndef FS_SLAB_SIZE
+#define FS_SLAB_SIZE 4096
+#endif
+
+typedef struct SlabObject {
+  struct SlabObject *next;
+} SlabObject;
+
+typedef struct SlabCache {
+  // size of each object, multiple of the alignment of max_align_t
+  size_t object_size;
+  SlabObject *free_list;
+} SlabCache;
+
+extern SlabCache file_cache;
+extern SlabCache chunk_cache;
+extern SlabCache open_file_cache;
+
+void *slab_alloc(SlabCache *cache);
+void slab_free(SlabCache *cache, void *object);
+
+// allocate a chunk header with an inline payload of at least the requested
+// capacity, payloads are grouped in power of two size classes and capacity is
+// updated to the size of the class
+void *slab_alloc_inline(size_t *capacity);
+void slab_free_inline(void *object, size_t capacity);
+
+// copy a name into the name arena, names are never freed individually, so
+// they can be referenced by files that are renamed or linked elsewhere
+// returns NULL if out of memory
+const char *intern_name(const char *name, size_t length);
+
+// forget all slabs, needed when the heap they were allocated from was reset
+void slab_reset(void);
+
+#endif // __DANDELION_SLAB__
@@ -0,0 +1,101 @@
+#ifndef _DANDELION_CONTAINER_H
+#define _DANDELION_CONTAINER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Packed container holding many small records in a single item.
+    All fields are little endian:
+      uint32_t magic, DANDELION_CONTAINER_MAGIC
+      uint32_t version, DANDELION_CONTAINER_VERSION
+      uint64_t record_count
+      uint64_t offsets[record_count + 1]
+      payload
+    Record i is the payload from offsets[i] to offsets[i + 1], offsets are
+    relative to the start of the payload and never decrease. The last offset
+    is the size of the payload.
+*/
+
+#define DANDELION_CONTAINER_MAGIC 0x43455244 // "DREC"
+#define DANDELION_CONTAINER_VERSION 1
+#define DANDELION_CONTAINER_HEADER_SIZE 16
+
+static inline size_t dandelion_container_index_size(size_t record_count) {
+  return DANDELION_CONTAINER_HEADER_SIZE + (record_count + 1) * 8;
+}
+
+typedef struct DandelionContainer {
+  // start of the offset array, may be unaligned
+  const char *offsets;
+  const char *payload;
+  size_t record_count;
+} DandelionContainer;
+
+// check that data holds a valid container and set up the view of it
+// returns 0 on success and -1 if the data is not a valid container
+int dandelion_container_open(DandelionContainer *container, const void *data,
+                             size_t data_len);
+
+static inline size_t
+dandelion_container_count(const DandelionContainer *container) {
+  return container->record_count;
+}
+
+static inline uint64_t dandelion_container_offset(const char *offsets,
+                                                  size_t index) {
+  uint64_t offset;
+  __builtin_memcpy(&offset, offsets + index * 8, 8);
+  return offset;
+}
+
+// pointer to the record at index inside the container, sets length to its
+// size, index needs to be smaller than the record count
+static inline const char *
+dandelion_container_record(const DandelionContainer *container, size_t index,
+                           size_t *length) {
+  uint64_t start = dandelion_container_offset(container->offsets, index);
+  uint64_t end = dandelion_container_offset(container->offsets, index + 1);
+  *length = end - start;
+  return container->payload + start;
+}
+
+// collects records and serializes them into a container
+typedef struct DandelionContainerWriter {
+  uint64_t *offsets;
+  size_t offsets_cap;
+  char *payload;
+  size_t payload_cap;
+  size_t record_count;
+} DandelionContainerWriter;
+
+// the expected sizes are only used for the initial capacity
+// returns 0 on success and -1 if there is not enough memory
+int dandelion_container_writer_init(DandelionContainerWriter *writer,
+                                    size_t expected_records,
+                                    size_t expected_bytes);
+void dandelion_container_writer_free(DandelionContainerWriter *writer);
+// copies the record into the writer
+// returns 0 on success and -1 if there is not enough memory
+int dandelion_container_add(DandelionContainerWriter *writer,
+                            const void *record, size_t length);
+// size of the serialized container
+size_t dandelion_container_size(const DandelionContainerWriter *writer);
+// serialize into destination, which needs dandelion_container_size bytes
+void dandelion_container_write(const DandelionContainerWriter *writer,
+                               void *destination);
+// serialize into a new output of the set allocated with
+// dandelion_alloc_output, returns 0 on success and -1 otherwise
+int dandelion_container_output(const DandelionContainerWriter *writer,
+                               size_t set_idx, const char *ident,
+                               size_t ident_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DANDELION_CONTAINER_H
@@ -0,0 +1,58 @@
+#ifndef _DANDELION_RECORDS_H
+#define _DANDELION_RECORDS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+// first occurrence of byte in data or NULL if there is none, scans several
+// bytes at once using the vector unit of the target
+const char *dandelion_find_byte(const char *data, size_t len, char byte);
+
+/*
+    Splits data that arrives in one or more chunks into records ending in a
+    delimiter, for example lines of an input item.
+    Records are returned as views without the delimiter. Records inside a
+    chunk point directly into it, only records spanning chunk boundaries are
+    copied into a buffer owned by the reader, which stays valid until the next
+    call on the reader.
+*/
+typedef struct DandelionRecordReader {
+  const char *data;
+  const char *end;
+  char *carry;
+  size_t carry_len;
+  size_t carry_cap;
+  char carry_returned;
+  char delimiter;
+} DandelionRecordReader;
+
+void dandelion_records_init(DandelionRecordReader *reader, char delimiter);
+void dandelion_records_free(DandelionRecordReader *reader);
+// hand the next chunk of data to the reader, the previous chunk needs to be
+// exhausted, meaning dandelion_records_next has returned 0
+void dandelion_records_feed(DandelionRecordReader *reader, const void *data,
+                            size_t len);
+// returns 1 and sets record and len if there is a complete record,
+// 0 if more data needs to be fed and -1 if there is not enough memory
+int dandelion_records_next(DandelionRecordReader *reader, const char **record,
+                           size_t *len);
+// call after the last chunk is exhausted, returns 1 and sets record and len
+// if the data did not end on a delimiter, returns 0 otherwise
+int dandelion_records_finish(DandelionRecordReader *reader,
+                             const char **record, size_t *len);
+
+// split data into ranges parts that each start at a record boundary and are
+// about the same size, range i goes from bounds[i] to bounds[i + 1], so
+// bounds needs space for ranges + 1 entries, ranges needs to be at least 1
+// and single ranges can end up empty
+void dandelion_split_records(const char *data, size_t len, char delimiter,
+                             size_t ranges, size_t *bounds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DANDELION_RECORDS_H
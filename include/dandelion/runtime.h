@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "io_buffer.h"
 
@@ -28,8 +29,76 @@ size_t dandelion_input_set_ident_len(size_t set_idx);
 const char *dandelion_output_set_ident(size_t set_idx);
 size_t dandelion_output_set_ident_len(size_t set_idx);
 
+// seed provided by the platform, 0 if the platform did not provide one
+uint64_t dandelion_random_seed(void);
+
+// current value of the counter behind the clocks, cheap enough to time short
+// sections of code with
+uint64_t dandelion_ticks(void);
+// ticks of the counter per second, 0 if the platform did not provide it in
+// which case the clocks count ticks as nanoseconds
+uint64_t dandelion_tick_frequency(void);
+// nanoseconds since an arbitrary point before entry
+uint64_t dandelion_monotonic_ns(void);
+// nanoseconds since the epoch, starts from 0 at entry if the platform did not
+// provide the wall clock time
+uint64_t dandelion_realtime_ns(void);
+// resolution of the clocks in nanoseconds
+uint64_t dandelion_clock_resolution_ns(void);
+
+// record that the run enters a phase of enum dandelion_phase from
+// dandelion/system/system.h, the runtime marks init, the start of user code
+// and exit on its own, C libraries mark their setup and teardown around main
+void dandelion_mark_phase(int phase);
+// if the function has an output set with this name, dandelion_exit adds an
+// item "phases" to it with a line of name and nanoseconds per reached phase
+#define DANDELION_PHASE_SET "dandelion_phases"
+
 IoBuffer *dandelion_get_input(size_t set_idx, size_t buf_idx);
+
+#define DANDELION_NOT_FOUND ((size_t)-1)
+// index of the first input set with the given name or DANDELION_NOT_FOUND
+size_t dandelion_find_input_set(const char *name, size_t name_len);
+// first buffer in the input set with the given ident or NULL
+IoBuffer *dandelion_find_input(size_t set_idx, const char *name,
+                               size_t name_len);
+
+// buffers in the input set that have the given key in set order, sets count
+// to their number, returns NULL if there are none
+IoBuffer *const *dandelion_find_inputs_by_key(size_t set_idx, size_t key,
+                                              size_t *count);
+// number of distinct keys in the input set
+size_t dandelion_input_key_count(size_t set_idx);
+// buffers sharing the key_idx-th distinct key, keys are visited in ascending
+// order by going from 0 to dandelion_input_key_count, sets count to their
+// number, returns NULL if there is no such key
+IoBuffer *const *dandelion_input_key_group(size_t set_idx, size_t key_idx,
+                                           size_t *count);
 void dandelion_add_output(size_t set_idx, IoBuffer buf);
+// make room for at least additional more outputs in the set, returns 0 on
+// success and -1 if the set does not exist or there is not enough memory
+int dandelion_reserve_outputs(size_t set_idx, size_t additional);
+// add n outputs to the set at once, returns 0 on success and -1 if the set
+// does not exist or there is not enough memory, in which case none are added
+int dandelion_add_outputs(size_t set_idx, const IoBuffer *bufs, size_t n);
+// allocate size bytes for a new output in the set and add it with a copy of
+// the ident, the data is placed in the platform's output region if there is
+// one, returns a pointer to fill the data in or NULL if the set does not exist
+// or there is not enough memory
+void *dandelion_alloc_output(size_t set_idx, const char *ident,
+                             size_t ident_len, size_t size);
+// returns non zero if the platform accepts outputs before exit
+int dandelion_output_streaming(void);
+// publish a finished output to the platform right away if it supports
+// streaming, otherwise it is added like with dandelion_add_output
+// the buffer and ident need to stay valid and unchanged until exit
+// returns 0 on success and -1 if the set does not exist
+int dandelion_emit_output(size_t set_idx, IoBuffer buf);
+// for programs linked against the libc, hand the finished file at path in an
+// output set directory to the platform and remove it from the file system
+// returns 0 on success and -1 with errno set otherwise, EBUSY while the file
+// is still open
+int dandelion_publish_file(const char *path);
 
 #ifdef __cplusplus
 }
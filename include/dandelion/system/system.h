@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "dandelion/io_buffer.h"
 
@@ -31,9 +32,18 @@ struct io_set_info {
   size_t offset;
 };
 
+// Output item handed to the platform before exit
+struct io_stream_entry {
+  // Index of the output set the item belongs to
+  size_t set_index;
+  IoBuffer buffer;
+};
+
 void __dandelion_system_init(void);
 void __dandelion_system_exit(void);
 void __dandelion_system_set_thread_pointer(void *ptr);
+// Called after entries were added to the output ring or when it is full
+void __dandelion_system_publish(void);
 
 // Normal exit codes are reserved up to 255 so we can use the space above
 #define DANDELION_EXIT_UNINITIALIZED                                           \
@@ -44,6 +54,24 @@ void __dandelion_system_set_thread_pointer(void *ptr);
   258                     // free was called but the index showed no occupation
 #define DANDELION_OOM 259 // Ran out of memory for critical operation
 
+// Flags of an output buffer in output_flags
+#define DANDELION_OUTPUT_CONTAINER 1 // data is in the container format
+
+// Phases of a run, the runtime and the C library record the counter value at
+// the start of each of them
+enum dandelion_phase {
+  DANDELION_PHASE_INIT,         // dandelion_init with the platform's setup
+  DANDELION_PHASE_FS_INIT,      // setting up the file system and stdio
+  DANDELION_PHASE_CONSTRUCTORS, // static constructors
+  DANDELION_PHASE_MAIN,         // user code
+  DANDELION_PHASE_DESTRUCTORS,  // static destructors
+  DANDELION_PHASE_CLOSE_FILES,  // flushing and closing open streams
+  DANDELION_PHASE_FS_TERMINATE, // turning files into outputs
+  DANDELION_PHASE_EXIT,         // dandelion_exit
+  DANDELION_PHASE_END,          // control goes back to the platform
+  DANDELION_PHASE_COUNT
+};
+
 struct dandelion_system_data {
   // Exit code of the process, set by the runtime at exit
   int exit_code;
@@ -70,8 +98,92 @@ struct dandelion_system_data {
   IoBuffer *input_bufs;
   // Output buffers, set by the runtime at exit
   IoBuffer *output_bufs;
+
+  // Optional ring of outputs published before exit, initialized by the
+  // platform before entry. Leaving output_ring NULL disables streaming.
+  // output_ring_len is a power of two, the runtime writes entries at
+  // output_ring_head and the platform consumes them from output_ring_tail,
+  // both only ever increase and are taken modulo the length for indexing.
+  // Published items are not repeated in the output buffers at exit and their
+  // memory stays valid until exit.
+  struct io_stream_entry *output_ring;
+  size_t output_ring_len;
+  size_t output_ring_head;
+  size_t output_ring_tail;
+
+  // Optional region for output data, initialized by the platform before
+  // entry. dandelion_alloc_output places data and idents of outputs in it
+  // back to back from output_region_begin, leaving both at 0 makes it fall
+  // back to the heap. Set by the runtime, output_region_used is the number of
+  // bytes used from the start of the region.
+  size_t output_region_begin;
+  size_t output_region_end;
+  size_t output_region_used;
+
+  // Seed for the random number generators, initialized by the platform before
+  // entry. Platforms that leave it at 0 get a fixed default seed.
+  uint64_t random_seed;
+
+  // Clock behind the time functions, initialized by the platform before
+  // entry. clock_frequency is the number of ticks per second of the counter
+  // read by __dandelion_read_ticks, realtime_base the wall clock time in
+  // nanoseconds since the epoch when the counter read clock_base.
+  // Platforms that leave the frequency at 0 get the ticks counted as
+  // nanoseconds, leaving clock_base at 0 starts the clocks at entry.
+  uint64_t clock_frequency;
+  uint64_t clock_base;
+  uint64_t realtime_base;
+
+  // Counter values at the start of each phase of the run, indexed by
+  // enum dandelion_phase and set by the runtime. Phases that were not reached
+  // or are not instrumented stay at 0, each phase lasts until the next one
+  // that has a value.
+  uint64_t phase_ticks[DANDELION_PHASE_COUNT];
+
+  // Flags for each of the output buffers, set by the runtime at exit.
+  // NULL if no output has any flags set.
+  unsigned char *output_flags;
 };
 
+// Counter the clock is based on, readable without a call into the platform
+static inline uint64_t __dandelion_read_ticks(void) {
+#if defined(__x86_64__)
+  uint32_t low;
+  uint32_t high;
+  __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+  return ((uint64_t)high << 32) | low;
+#elif defined(__aarch64__)
+  uint64_t ticks;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+#else
+#error "Missing architecture specific code."
+#endif
+}
+
+static inline const char *__dandelion_phase_name(int phase) {
+  switch (phase) {
+  case DANDELION_PHASE_INIT:
+    return "init";
+  case DANDELION_PHASE_FS_INIT:
+    return "fs_init";
+  case DANDELION_PHASE_CONSTRUCTORS:
+    return "constructors";
+  case DANDELION_PHASE_MAIN:
+    return "main";
+  case DANDELION_PHASE_DESTRUCTORS:
+    return "destructors";
+  case DANDELION_PHASE_CLOSE_FILES:
+    return "close_files";
+  case DANDELION_PHASE_FS_TERMINATE:
+    return "fs_terminate";
+  case DANDELION_PHASE_EXIT:
+    return "exit";
+  default:
+    return "end";
+  }
+}
+
 // Global symbol available to the platform
 extern struct dandelion_system_data __dandelion_system_data;
 
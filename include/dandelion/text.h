@@ -0,0 +1,21 @@
+#ifndef _DANDELION_TEXT_H
+#define _DANDELION_TEXT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+// number of bytes at the start of data that are ASCII, meaning below 0x80,
+// checks several bytes at once using the vector unit of the target
+size_t dandelion_ascii_length(const char *data, size_t len);
+// number of bytes at the start of data that are complete and valid UTF-8
+// characters, checks several bytes at once like dandelion_ascii_length
+size_t dandelion_utf8_length(const char *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DANDELION_TEXT_H
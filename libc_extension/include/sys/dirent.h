@@ -19,7 +19,7 @@ struct dirent {
   size_t d_off;
   uint16_t d_ino;
   unsigned char d_type;
-  char d_name[64];
+  char d_name[256];
 };
 
 DIR *opendir(const char *name);
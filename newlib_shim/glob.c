@@ -0,0 +1,539 @@
+#include <ctype.h>
+#include <fnmatch.h>
+#include <glob.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Shell style pattern matching on bytes in the C locale. Patterns are matched
+    with a single backtracking point at the last star, which is enough as a
+    later star can always take over what an earlier one would have matched.
+    With FNM_PATHNAME pattern and string are matched one component at a time,
+    so no wildcard ever sees a slash.
+    glob does not list directories through readdir and stat, it hands the
+    pattern split into components to the file system, which walks the file
+    tree directly. Leading components without wildcards are resolved as a
+    single path and literal components further down are looked up by name, so
+    only directories matching the pattern so far are ever listed. Each other
+    component is prepared once with the literal text it starts and ends with,
+    which rejects most names before running the matcher.
+*/
+
+typedef struct DandelionGlobPart {
+  const char *pattern;
+  size_t length;
+  char literal;
+} DandelionGlobPart;
+
+typedef int (*DandelionGlobMatch)(void *context, size_t part, const char *name,
+                                  size_t name_len);
+typedef int (*DandelionGlobFound)(void *context, const char *path,
+                                  size_t path_len, int is_directory);
+
+extern int dandelion_glob(const char *start, size_t start_len,
+                          const DandelionGlobPart *parts, size_t part_count,
+                          DandelionGlobMatch match, DandelionGlobFound found,
+                          void *context);
+
+// ========================================================
+// fnmatch
+// ========================================================
+
+static inline int same_byte(unsigned char pattern, unsigned char byte,
+                            int flags) {
+  if (flags & FNM_CASEFOLD) {
+    return tolower(pattern) == tolower(byte);
+  }
+  return pattern == byte;
+}
+
+static int class_matches(const char *name, size_t length, unsigned char byte,
+                         int flags) {
+  static const struct {
+    const char *name;
+    int (*test)(int);
+  } classes[] = {
+      {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank},
+      {"cntrl", iscntrl}, {"digit", isdigit}, {"graph", isgraph},
+      {"lower", islower}, {"print", isprint}, {"punct", ispunct},
+      {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit},
+  };
+  for (size_t index = 0; index < sizeof(classes) / sizeof(classes[0]);
+       index++) {
+    if (strlen(classes[index].name) != length ||
+        memcmp(classes[index].name, name, length) != 0) {
+      continue;
+    }
+    int (*test)(int) = classes[index].test;
+    if (flags & FNM_CASEFOLD) {
+      return test(byte) || test(tolower(byte)) || test(toupper(byte));
+    }
+    return test(byte) != 0;
+  }
+  return 0;
+}
+
+static inline int range_matches(unsigned char low, unsigned char high,
+                                unsigned char byte, int flags) {
+  if (flags & FNM_CASEFOLD) {
+    low = tolower(low);
+    high = tolower(high);
+    byte = tolower(byte);
+  }
+  return low <= byte && byte <= high;
+}
+
+// match a bracket expression starting after its '[' against a byte
+// returns the length of the expression up to and including the closing ']',
+// or 0 if it is not terminated and the '[' is an ordinary character
+static size_t match_bracket(const char *pattern, size_t length,
+                            unsigned char byte, int flags, int *matched) {
+  size_t index = 0;
+  int negate = 0;
+  if (index < length && (pattern[index] == '!' || pattern[index] == '^')) {
+    negate = 1;
+    index++;
+  }
+  int found = 0;
+  // a ']' right at the start is part of the set
+  for (size_t first = index;; first = SIZE_MAX) {
+    if (index >= length) {
+      return 0;
+    }
+    unsigned char low = pattern[index];
+    if (low == ']' && index != first) {
+      break;
+    }
+    if (low == '[' && index + 1 < length && pattern[index + 1] == ':') {
+      size_t end = index + 2;
+      while (end + 1 < length &&
+             (pattern[end] != ':' || pattern[end + 1] != ']')) {
+        end++;
+      }
+      if (end + 1 < length) {
+        found |= class_matches(pattern + index + 2, end - index - 2, byte,
+                               flags);
+        index = end + 2;
+        continue;
+      }
+    }
+    if (low == '\\' && !(flags & FNM_NOESCAPE) && index + 1 < length) {
+      low = pattern[++index];
+    }
+    index++;
+    unsigned char high = low;
+    if (index + 1 < length && pattern[index] == '-' &&
+        pattern[index + 1] != ']') {
+      high = pattern[index + 1];
+      index += 2;
+      if (high == '\\' && !(flags & FNM_NOESCAPE) && index < length) {
+        high = pattern[index++];
+      }
+    }
+    found |= range_matches(low, high, byte, flags);
+  }
+  *matched = found != negate;
+  return index + 1;
+}
+
+// match a whole string against a pattern, both given with their length
+// with leading_period a period at the start of the string needs to be matched
+// by a period in the pattern
+static int match_pattern(const char *pattern, size_t pattern_len,
+                         const char *string, size_t string_len, int flags,
+                         int leading_period) {
+  if (leading_period && string_len > 0 && string[0] == '.' &&
+      !(pattern_len > 0 && pattern[0] == '.') &&
+      !(pattern_len > 1 && pattern[0] == '\\' && pattern[1] == '.' &&
+        !(flags & FNM_NOESCAPE))) {
+    return FNM_NOMATCH;
+  }
+  size_t pattern_index = 0;
+  size_t string_index = 0;
+  // where to resume after the last star, matching one more byte with it
+  size_t star_pattern = SIZE_MAX;
+  size_t star_string = 0;
+  for (;;) {
+    if (pattern_index < pattern_len) {
+      unsigned char token = pattern[pattern_index];
+      if (token == '*') {
+        star_pattern = ++pattern_index;
+        star_string = string_index;
+        continue;
+      }
+      if (string_index < string_len) {
+        unsigned char byte = string[string_index];
+        size_t next = pattern_index + 1;
+        int matched;
+        if (token == '?') {
+          matched = 1;
+        } else if (token == '[') {
+          size_t bracket_len =
+              match_bracket(pattern + next, pattern_len - next, byte, flags,
+                            &matched);
+          if (bracket_len == 0) {
+            matched = byte == '[';
+          }
+          next += bracket_len;
+        } else if (token == '\\' && !(flags & FNM_NOESCAPE)) {
+          // a trailing backslash escapes nothing and never matches
+          if (next == pattern_len) {
+            return FNM_NOMATCH;
+          }
+          matched = same_byte(pattern[next++], byte, flags);
+        } else {
+          matched = same_byte(token, byte, flags);
+        }
+        if (matched) {
+          pattern_index = next;
+          string_index++;
+          continue;
+        }
+      }
+    } else if (string_index == string_len ||
+               ((flags & FNM_LEADING_DIR) && string[string_index] == '/')) {
+      return 0;
+    }
+    if (star_pattern == SIZE_MAX || star_string >= string_len) {
+      return FNM_NOMATCH;
+    }
+    pattern_index = star_pattern;
+    string_index = ++star_string;
+  }
+}
+
+// length of the pattern up to the next slash outside of a bracket expression,
+// next is set to where the pattern continues after it
+static size_t pattern_component(const char *pattern, size_t length, int flags,
+                                size_t *next) {
+  for (size_t index = 0; index < length; index++) {
+    if (pattern[index] == '[') {
+      // a slash inside a bracket expression never matches but does not end
+      // the component
+      int matched;
+      index += match_bracket(pattern + index + 1, length - index - 1, 0, flags,
+                             &matched);
+    } else if (pattern[index] == '/') {
+      *next = index + 1;
+      return index;
+    } else if (pattern[index] == '\\' && !(flags & FNM_NOESCAPE) &&
+               index + 1 < length) {
+      if (pattern[index + 1] == '/') {
+        *next = index + 2;
+        return index;
+      }
+      index++;
+    }
+  }
+  *next = length;
+  return length;
+}
+
+int fnmatch(const char *pattern, const char *string, int flags) {
+  size_t pattern_len = strlen(pattern);
+  size_t string_len = strlen(string);
+  int leading_period = (flags & FNM_PERIOD) != 0;
+  if (!(flags & FNM_PATHNAME)) {
+    return match_pattern(pattern, pattern_len, string, string_len, flags,
+                         leading_period);
+  }
+  for (;;) {
+    size_t next;
+    size_t component_len =
+        pattern_component(pattern, pattern_len, flags, &next);
+    const char *slash = memchr(string, '/', string_len);
+    size_t name_len = slash == NULL ? string_len : (size_t)(slash - string);
+    if (match_pattern(pattern, component_len, string, name_len, flags,
+                      leading_period) != 0) {
+      return FNM_NOMATCH;
+    }
+    if (component_len == pattern_len) {
+      return slash == NULL || (flags & FNM_LEADING_DIR) ? 0 : FNM_NOMATCH;
+    }
+    if (slash == NULL) {
+      return FNM_NOMATCH;
+    }
+    pattern += next;
+    pattern_len -= next;
+    string += name_len + 1;
+    string_len -= name_len + 1;
+  }
+}
+
+// ========================================================
+// glob
+// ========================================================
+
+// literal text every name matching a component needs to start and end with
+typedef struct GlobFilter {
+  size_t prefix_len;
+  size_t suffix_len;
+} GlobFilter;
+
+typedef struct GlobState {
+  const DandelionGlobPart *parts;
+  const GlobFilter *filters;
+  int match_flags;
+  // append a slash to directories
+  char mark;
+  // the pattern ended in a slash and only matches directories
+  char only_directories;
+  char **paths;
+  size_t path_count;
+  size_t path_capacity;
+} GlobState;
+
+static inline int is_wildcard(char byte) {
+  return byte == '*' || byte == '?' || byte == '[';
+}
+
+// escapes are treated like wildcards, so literal components can be looked up
+// by name as they are
+static inline int is_special(char byte) {
+  return is_wildcard(byte) || byte == '\\';
+}
+
+static void compile_part(const char *pattern, size_t length,
+                         DandelionGlobPart *part, GlobFilter *filter) {
+  size_t prefix_len = 0;
+  while (prefix_len < length && !is_special(pattern[prefix_len])) {
+    prefix_len++;
+  }
+  // the suffix stops at the end of bracket expressions as well, for the bytes
+  // before a ']' it is not known whether they are part of one
+  size_t suffix_len = 0;
+  while (suffix_len < length - prefix_len &&
+         !is_special(pattern[length - 1 - suffix_len]) &&
+         pattern[length - 1 - suffix_len] != ']') {
+    suffix_len++;
+  }
+  part->pattern = pattern;
+  part->length = length;
+  part->literal = prefix_len == length;
+  filter->prefix_len = prefix_len;
+  filter->suffix_len = suffix_len;
+}
+
+static int glob_match(void *context, size_t part, const char *name,
+                      size_t name_len) {
+  GlobState *state = context;
+  const DandelionGlobPart *current = &state->parts[part];
+  size_t prefix_len = state->filters[part].prefix_len;
+  size_t suffix_len = state->filters[part].suffix_len;
+  if (name_len < prefix_len + suffix_len ||
+      memcmp(name, current->pattern, prefix_len) != 0 ||
+      memcmp(name + name_len - suffix_len,
+             current->pattern + current->length - suffix_len,
+             suffix_len) != 0) {
+    return 0;
+  }
+  // names starting with a period are only matched by a literal period, which
+  // the prefix already checked if there is one
+  return match_pattern(current->pattern + prefix_len,
+                       current->length - prefix_len, name + prefix_len,
+                       name_len - prefix_len, state->match_flags,
+                       prefix_len == 0) == 0;
+}
+
+static int glob_add(GlobState *state, char *path) {
+  if (state->path_count == state->path_capacity) {
+    size_t capacity =
+        state->path_capacity == 0 ? 16 : 2 * state->path_capacity;
+    char **paths = realloc(state->paths, capacity * sizeof(char *));
+    if (paths == NULL) {
+      return -1;
+    }
+    state->paths = paths;
+    state->path_capacity = capacity;
+  }
+  state->paths[state->path_count++] = path;
+  return 0;
+}
+
+static int glob_found(void *context, const char *path, size_t path_len,
+                      int is_directory) {
+  GlobState *state = context;
+  if (state->only_directories && !is_directory) {
+    return 0;
+  }
+  size_t mark = state->mark && is_directory && path[path_len - 1] != '/';
+  char *copy = malloc(path_len + mark + 1);
+  if (copy == NULL) {
+    return 1;
+  }
+  memcpy(copy, path, path_len);
+  if (mark) {
+    copy[path_len] = '/';
+  }
+  copy[path_len + mark] = '\0';
+  if (glob_add(state, copy) != 0) {
+    free(copy);
+    return 1;
+  }
+  return 0;
+}
+
+static void glob_free_paths(GlobState *state) {
+  for (size_t index = 0; index < state->path_count; index++) {
+    free(state->paths[index]);
+  }
+  free(state->paths);
+}
+
+static int compare_paths(const void *first, const void *second) {
+  return strcmp(*(char *const *)first, *(char *const *)second);
+}
+
+// split the pattern into the leading directory without wildcards and the
+// components after it, the parts are allocated once for all components and
+// also hold the filters
+static int glob_walk(const char *pattern, size_t length, int flags,
+                     GlobState *state) {
+  size_t count = 0;
+  size_t start_len = pattern[0] == '/' ? 1 : 0;
+  int in_start = 1;
+  for (size_t index = 0; index < length;) {
+    while (index < length && pattern[index] == '/') {
+      index++;
+    }
+    if (index == length) {
+      break;
+    }
+    int literal = 1;
+    while (index < length && pattern[index] != '/') {
+      literal &= !is_special(pattern[index]);
+      index++;
+    }
+    in_start &= literal;
+    if (in_start) {
+      start_len = index;
+    } else {
+      count++;
+    }
+  }
+  DandelionGlobPart *parts = NULL;
+  GlobFilter *filters = NULL;
+  if (count > 0) {
+    parts = malloc(count * (sizeof(DandelionGlobPart) + sizeof(GlobFilter)));
+    if (parts == NULL) {
+      return GLOB_NOSPACE;
+    }
+    filters = (GlobFilter *)(parts + count);
+    size_t part = 0;
+    for (size_t index = start_len; index < length;) {
+      while (index < length && pattern[index] == '/') {
+        index++;
+      }
+      if (index == length) {
+        break;
+      }
+      size_t begin = index;
+      while (index < length && pattern[index] != '/') {
+        index++;
+      }
+      compile_part(pattern + begin, index - begin, &parts[part],
+                   &filters[part]);
+      part++;
+    }
+  }
+  state->parts = parts;
+  state->filters = filters;
+  state->match_flags = flags & GLOB_NOESCAPE ? FNM_NOESCAPE : 0;
+  int result = dandelion_glob(pattern, start_len, parts, count, glob_match,
+                              glob_found, state);
+  free(parts);
+  if (result > 0) {
+    return GLOB_NOSPACE;
+  }
+  // the tree is in memory, so the walk can only fail on paths that are too
+  // long, which does not leave a complete result to continue with
+  if (result < 0) {
+    return GLOB_ABORTED;
+  }
+  return 0;
+}
+
+int glob(const char *__restrict pattern, int flags,
+         int (*errfunc)(const char *, int), glob_t *__restrict pglob) {
+  (void)errfunc;
+  if (!(flags & GLOB_APPEND)) {
+    pglob->gl_pathc = 0;
+    pglob->gl_pathv = NULL;
+  }
+  size_t offsets = flags & GLOB_DOOFFS ? pglob->gl_offs : 0;
+  size_t length = strlen(pattern);
+  int magic = 0;
+  for (size_t index = 0; index < length; index++) {
+    magic |= is_wildcard(pattern[index]);
+  }
+  pglob->gl_flags = flags | (magic ? GLOB_MAGCHAR : 0);
+  pglob->gl_matchc = 0;
+
+  GlobState state = {
+      .mark = (flags & GLOB_MARK) != 0,
+      .only_directories = 0,
+      .paths = NULL,
+      .path_count = 0,
+      .path_capacity = 0,
+  };
+  if (length > 0) {
+    if (pattern[length - 1] == '/') {
+      state.mark = 1;
+      state.only_directories = 1;
+    }
+    int error = glob_walk(pattern, length, flags, &state);
+    if (error != 0) {
+      glob_free_paths(&state);
+      return error;
+    }
+  }
+  if (state.path_count == 0) {
+    if (!(flags & GLOB_NOCHECK) && !((flags & GLOB_NOMAGIC) && !magic)) {
+      return GLOB_NOMATCH;
+    }
+    char *copy = strdup(pattern);
+    if (copy == NULL || glob_add(&state, copy) != 0) {
+      free(copy);
+      glob_free_paths(&state);
+      return GLOB_NOSPACE;
+    }
+  } else if (!(flags & GLOB_NOSORT)) {
+    qsort(state.paths, state.path_count, sizeof(char *), compare_paths);
+  }
+
+  size_t previous = pglob->gl_pathc;
+  char **pathv =
+      realloc(pglob->gl_pathv,
+              (offsets + previous + state.path_count + 1) * sizeof(char *));
+  if (pathv == NULL) {
+    glob_free_paths(&state);
+    return GLOB_NOSPACE;
+  }
+  if (pglob->gl_pathv == NULL) {
+    for (size_t index = 0; index < offsets; index++) {
+      pathv[index] = NULL;
+    }
+  }
+  memcpy(pathv + offsets + previous, state.paths,
+         state.path_count * sizeof(char *));
+  pglob->gl_pathv = pathv;
+  pglob->gl_pathc = previous + state.path_count;
+  pglob->gl_matchc = state.path_count;
+  pathv[offsets + pglob->gl_pathc] = NULL;
+  free(state.paths);
+  return 0;
+}
+
+void globfree(glob_t *pglob) {
+  if (pglob->gl_pathv != NULL) {
+    size_t offsets = pglob->gl_flags & GLOB_DOOFFS ? pglob->gl_offs : 0;
+    for (size_t index = 0; index < pglob->gl_pathc; index++) {
+      free(pglob->gl_pathv[offsets + index]);
+    }
+    free(pglob->gl_pathv);
+  }
+  pglob->gl_pathc = 0;
+  pglob->gl_pathv = NULL;
+}
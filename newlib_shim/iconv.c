@@ -0,0 +1,664 @@
+#include <ctype.h>
+#include <errno.h>
+#include <iconv.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Conversion between the Unicode encodings UTF-8, UTF-16 and UTF-32 as well
+    as Latin-1 and ASCII. Runs of ASCII are found with the vectorized scan of
+    the runtime and copied or widened as a whole, UTF-8 converted to UTF-8 is
+    checked with the vectorized validator of the runtime and copied as well.
+    Everything else is decoded into code points and encoded again, in a loop
+    instantiated for each pair of Unicode encodings, and only characters this
+    loop can not convert go through the error handling.
+    UTF-16 and UTF-32 without an explicit byte order are read in the order
+    given by a byte order mark, or in the native order if there is none, and
+    written in the native order after a byte order mark, the same as glibc.
+    tocode can end in //TRANSLIT to replace characters the target encoding
+    can not represent with a question mark and in //IGNORE to skip them and
+    invalid input, in which case the call fails with EILSEQ after converting
+    everything else.
+*/
+
+extern size_t dandelion_ascii_length(const char *data, size_t len);
+extern size_t dandelion_utf8_length(const char *data, size_t len);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define NATIVE_BIG_ENDIAN 1
+#else
+#define NATIVE_BIG_ENDIAN 0
+#endif
+
+// longest normalized encoding name
+#define NAME_LENGTH 16
+
+typedef enum Encoding {
+  ASCII,
+  LATIN1,
+  UTF8,
+  UTF16,
+  UTF16BE,
+  UTF16LE,
+  UTF32,
+  UTF32BE,
+  UTF32LE,
+} Encoding;
+
+// names are compared in upper case and without punctuation, so UTF-8, utf8
+// and UTF_8 are all the same
+static const struct {
+  const char *name;
+  Encoding encoding;
+} encoding_names[] = {
+    {"UTF8", UTF8},
+    {"UTF16", UTF16},
+    {"UTF16BE", UTF16BE},
+    {"UTF16LE", UTF16LE},
+    {"UTF32", UTF32},
+    {"UTF32BE", UTF32BE},
+    {"UTF32LE", UTF32LE},
+    {"UCS4", UTF32BE},
+    {"UCS4BE", UTF32BE},
+    {"UCS4LE", UTF32LE},
+    {"WCHART", NATIVE_BIG_ENDIAN ? UTF32BE : UTF32LE},
+    {"ISO88591", LATIN1},
+    {"LATIN1", LATIN1},
+    {"L1", LATIN1},
+    {"ASCII", ASCII},
+    {"USASCII", ASCII},
+    {"ANSIX341968", ASCII},
+    // the charset of the C locale
+    {"", ASCII},
+};
+
+typedef struct Converter {
+  Encoding from;
+  Encoding to;
+  // skip invalid input and characters the target can not represent
+  char discard;
+  // replace characters the target can not represent with a question mark
+  char transliterate;
+  // byte order of UTF-16 and UTF-32 input without an explicit one, only
+  // known after looking for a byte order mark
+  char input_order_known;
+  char input_big_endian;
+  char wrote_order_mark;
+} Converter;
+
+static int find_encoding(const char *code, Encoding *encoding) {
+  char name[NAME_LENGTH + 1];
+  size_t length = 0;
+  for (; *code != '\0' && !(code[0] == '/' && code[1] == '/'); code++) {
+    if (!isalnum((unsigned char)*code)) {
+      continue;
+    }
+    if (length == NAME_LENGTH) {
+      return -1;
+    }
+    name[length++] = toupper((unsigned char)*code);
+  }
+  name[length] = '\0';
+  for (size_t index = 0;
+       index < sizeof(encoding_names) / sizeof(encoding_names[0]); index++) {
+    if (strcmp(encoding_names[index].name, name) == 0) {
+      *encoding = encoding_names[index].encoding;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static inline size_t unit_size(Encoding encoding) {
+  switch (encoding) {
+  case UTF16:
+  case UTF16BE:
+  case UTF16LE:
+    return 2;
+  case UTF32:
+  case UTF32BE:
+  case UTF32LE:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+// encodings in which ASCII characters are the same single bytes
+static inline int keeps_ascii(Encoding encoding) {
+  return encoding == ASCII || encoding == LATIN1 || encoding == UTF8;
+}
+
+static inline int input_big_endian(const Converter *converter) {
+  if (converter->from == UTF16BE || converter->from == UTF32BE) {
+    return 1;
+  }
+  if (converter->from == UTF16LE || converter->from == UTF32LE) {
+    return 0;
+  }
+  return converter->input_big_endian;
+}
+
+static inline int output_big_endian(Encoding encoding) {
+  if (encoding == UTF16BE || encoding == UTF32BE) {
+    return 1;
+  }
+  if (encoding == UTF16LE || encoding == UTF32LE) {
+    return 0;
+  }
+  return NATIVE_BIG_ENDIAN;
+}
+
+static inline uint32_t read_unit(const unsigned char *in, size_t size,
+                                 int big_endian) {
+  if (size == 2) {
+    return big_endian ? (uint32_t)in[0] << 8 | in[1]
+                      : (uint32_t)in[1] << 8 | in[0];
+  }
+  if (big_endian) {
+    return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 |
+           (uint32_t)in[2] << 8 | in[3];
+  }
+  return (uint32_t)in[3] << 24 | (uint32_t)in[2] << 16 |
+         (uint32_t)in[1] << 8 | in[0];
+}
+
+static inline void write_unit(unsigned char *out, uint32_t unit, size_t size,
+                              int big_endian) {
+  for (size_t index = 0; index < size; index++) {
+    size_t shift = big_endian ? size - 1 - index : index;
+    out[index] = unit >> (8 * shift);
+  }
+}
+
+// store ASCII bytes as UTF-16 or UTF-32 code units, kept as separate loops
+// for each unit size and byte order so the compiler can vectorize them
+static void widen_ascii(const unsigned char *in, size_t count,
+                        unsigned char *out, size_t size, int big_endian) {
+  int swap = big_endian != NATIVE_BIG_ENDIAN;
+  if (size == 2) {
+    for (size_t index = 0; index < count; index++) {
+      uint16_t unit = swap ? (uint16_t)(in[index] << 8) : in[index];
+      memcpy(out + 2 * index, &unit, 2);
+    }
+  } else {
+    for (size_t index = 0; index < count; index++) {
+      uint32_t unit = swap ? (uint32_t)in[index] << 24 : in[index];
+      memcpy(out + 4 * index, &unit, 4);
+    }
+  }
+}
+
+// decode UTF-8 rejecting overlong forms, surrogates and code points above
+// U+10FFFF, which leaves only a narrower range for the second byte of some
+// lead bytes
+static inline __attribute__((always_inline)) int
+decode_utf8(const unsigned char *in, size_t len, uint32_t *code) {
+  unsigned char lead = in[0];
+  if (lead < 0x80) {
+    *code = lead;
+    return 1;
+  }
+  size_t length;
+  uint32_t value;
+  unsigned char lower = 0x80;
+  unsigned char upper = 0xbf;
+  if (lead < 0xc2) {
+    return -1;
+  } else if (lead < 0xe0) {
+    length = 2;
+    value = lead & 0x1f;
+  } else if (lead < 0xf0) {
+    length = 3;
+    value = lead & 0x0f;
+    if (lead == 0xe0) {
+      lower = 0xa0;
+    } else if (lead == 0xed) {
+      upper = 0x9f;
+    }
+  } else if (lead < 0xf5) {
+    length = 4;
+    value = lead & 0x07;
+    if (lead == 0xf0) {
+      lower = 0x90;
+    } else if (lead == 0xf4) {
+      upper = 0x8f;
+    }
+  } else {
+    return -1;
+  }
+  for (size_t index = 1; index < length; index++) {
+    if (index == len) {
+      return 0;
+    }
+    if (in[index] < lower || in[index] > upper) {
+      return -1;
+    }
+    value = value << 6 | (in[index] & 0x3f);
+    lower = 0x80;
+    upper = 0xbf;
+  }
+  *code = value;
+  return length;
+}
+
+// decode one character from the input, returns the number of bytes it takes,
+// 0 if the input ends inside of it and -1 if it is invalid
+static inline __attribute__((always_inline)) int
+decode(Encoding from, int big_endian, const unsigned char *in, size_t len,
+       uint32_t *code) {
+  switch (from) {
+  case ASCII:
+    if (in[0] >= 0x80) {
+      return -1;
+    }
+    *code = in[0];
+    return 1;
+  case LATIN1:
+    *code = in[0];
+    return 1;
+  case UTF8:
+    return decode_utf8(in, len, code);
+  case UTF16:
+  case UTF16BE:
+  case UTF16LE: {
+    if (len < 2) {
+      return 0;
+    }
+    uint32_t unit = read_unit(in, 2, big_endian);
+    if (unit < 0xd800 || unit > 0xdfff) {
+      *code = unit;
+      return 2;
+    }
+    // a surrogate pair needs to start with the high surrogate
+    if (unit >= 0xdc00) {
+      return -1;
+    }
+    if (len < 4) {
+      return 0;
+    }
+    uint32_t low = read_unit(in + 2, 2, big_endian);
+    if (low < 0xdc00 || low > 0xdfff) {
+      return -1;
+    }
+    *code = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+    return 4;
+  }
+  default: {
+    if (len < 4) {
+      return 0;
+    }
+    uint32_t unit = read_unit(in, 4, big_endian);
+    if (unit > 0x10ffff || (unit >= 0xd800 && unit <= 0xdfff)) {
+      return -1;
+    }
+    *code = unit;
+    return 4;
+  }
+  }
+}
+
+// encode one character into the output, returns the number of bytes written,
+// 0 if they do not fit and -1 if the encoding can not represent the character
+static inline __attribute__((always_inline)) int
+encode(Encoding to, int big_endian, uint32_t code, unsigned char *out,
+       size_t len) {
+  switch (to) {
+  case ASCII:
+  case LATIN1:
+    if (len < 1) {
+      return 0;
+    }
+    if (code >= (to == ASCII ? 0x80u : 0x100u)) {
+      return -1;
+    }
+    out[0] = code;
+    return 1;
+  case UTF8:
+    if (code < 0x80) {
+      if (len < 1) {
+        return 0;
+      }
+      out[0] = code;
+      return 1;
+    } else if (code < 0x800) {
+      if (len < 2) {
+        return 0;
+      }
+      out[0] = 0xc0 | code >> 6;
+      out[1] = 0x80 | (code & 0x3f);
+      return 2;
+    } else if (code < 0x10000) {
+      if (len < 3) {
+        return 0;
+      }
+      out[0] = 0xe0 | code >> 12;
+      out[1] = 0x80 | (code >> 6 & 0x3f);
+      out[2] = 0x80 | (code & 0x3f);
+      return 3;
+    }
+    if (len < 4) {
+      return 0;
+    }
+    out[0] = 0xf0 | code >> 18;
+    out[1] = 0x80 | (code >> 12 & 0x3f);
+    out[2] = 0x80 | (code >> 6 & 0x3f);
+    out[3] = 0x80 | (code & 0x3f);
+    return 4;
+  case UTF16:
+  case UTF16BE:
+  case UTF16LE:
+    if (code < 0x10000) {
+      if (len < 2) {
+        return 0;
+      }
+      write_unit(out, code, 2, big_endian);
+      return 2;
+    }
+    if (len < 4) {
+      return 0;
+    }
+    code -= 0x10000;
+    write_unit(out, 0xd800 | code >> 10, 2, big_endian);
+    write_unit(out + 2, 0xdc00 | (code & 0x3ff), 2, big_endian);
+    return 4;
+  default:
+    if (len < 4) {
+      return 0;
+    }
+    write_unit(out, code, 4, big_endian);
+    return 4;
+  }
+}
+
+static inline int is_unicode(Encoding encoding) {
+  return encoding != ASCII && encoding != LATIN1;
+}
+
+// the encodings that only differ in byte order share their code
+static inline Encoding unicode_family(Encoding encoding) {
+  switch (encoding) {
+  case UTF16BE:
+  case UTF16LE:
+    return UTF16;
+  case UTF32BE:
+  case UTF32LE:
+    return UTF32;
+  default:
+    return encoding;
+  }
+}
+
+// convert characters between two Unicode encodings as long as they are
+// valid, complete and fit, everything else is left to the main loop, which
+// also takes over at the start of a long run of ASCII, as the block scan is
+// faster for it
+static inline __attribute__((always_inline)) void
+convert_run(Encoding from, Encoding to, int input_big_endian,
+            int output_big_endian, const unsigned char **in_pos,
+            const unsigned char *in_end, unsigned char **out_pos,
+            unsigned char *out_end) {
+  const unsigned char *in = *in_pos;
+  unsigned char *out = *out_pos;
+  while (in < in_end) {
+    if (from == UTF8 && in[0] < 0x80 && in_end - in >= 8) {
+      uint64_t word;
+      memcpy(&word, in, 8);
+      if ((word & 0x8080808080808080ULL) == 0) {
+        break;
+      }
+    }
+    uint32_t code;
+    int read = decode(from, input_big_endian, in, in_end - in, &code);
+    if (read <= 0) {
+      break;
+    }
+    int written = encode(to, output_big_endian, code, out, out_end - out);
+    if (written <= 0) {
+      break;
+    }
+    in += read;
+    out += written;
+  }
+  *in_pos = in;
+  *out_pos = out;
+}
+
+// instantiate the loop for every pair of Unicode encodings, so decoding and
+// encoding are inlined without going through the switch for every character,
+// which needs the inlining to be forced as the compiler does not consider the
+// switches it removes
+static inline __attribute__((always_inline)) void
+convert_from(Encoding from, const Converter *converter,
+             const unsigned char **in, const unsigned char *in_end,
+             unsigned char **out, unsigned char *out_end) {
+  int input = input_big_endian(converter);
+  int output = output_big_endian(converter->to);
+  switch (unicode_family(converter->to)) {
+  case UTF8:
+    convert_run(from, UTF8, input, output, in, in_end, out, out_end);
+    break;
+  case UTF16:
+    convert_run(from, UTF16, input, output, in, in_end, out, out_end);
+    break;
+  case UTF32:
+    convert_run(from, UTF32, input, output, in, in_end, out, out_end);
+    break;
+  default:
+    break;
+  }
+}
+
+static void convert_unicode(const Converter *converter,
+                            const unsigned char **in,
+                            const unsigned char *in_end, unsigned char **out,
+                            unsigned char *out_end) {
+  switch (unicode_family(converter->from)) {
+  case UTF8:
+    convert_from(UTF8, converter, in, in_end, out, out_end);
+    break;
+  case UTF16:
+    convert_from(UTF16, converter, in, in_end, out, out_end);
+    break;
+  case UTF32:
+    convert_from(UTF32, converter, in, in_end, out, out_end);
+    break;
+  default:
+    break;
+  }
+}
+
+iconv_t iconv_open(const char *tocode, const char *fromcode) {
+  Encoding to;
+  Encoding from;
+  if (find_encoding(tocode, &to) != 0 || find_encoding(fromcode, &from) != 0) {
+    errno = EINVAL;
+    return (iconv_t)-1;
+  }
+  Converter *converter = malloc(sizeof(Converter));
+  if (converter == NULL) {
+    errno = ENOMEM;
+    return (iconv_t)-1;
+  }
+  converter->from = from;
+  converter->to = to;
+  converter->discard = strstr(tocode, "//IGNORE") != NULL;
+  converter->transliterate = strstr(tocode, "//TRANSLIT") != NULL;
+  converter->input_order_known = 0;
+  converter->input_big_endian = NATIVE_BIG_ENDIAN;
+  converter->wrote_order_mark = 0;
+  return converter;
+}
+
+static inline unsigned char *write_order_mark(Converter *converter,
+                                              unsigned char *out,
+                                              size_t size) {
+  if (size == 0) {
+    return out;
+  }
+  write_unit(out, 0xfeff, size, NATIVE_BIG_ENDIAN);
+  converter->wrote_order_mark = 1;
+  return out + size;
+}
+
+size_t iconv(iconv_t cd, char **__restrict inbuf,
+             size_t *__restrict inbytesleft, char **__restrict outbuf,
+             size_t *__restrict outbytesleft) {
+  Converter *converter = cd;
+  if (inbuf == NULL || *inbuf == NULL) {
+    // back to the initial state, none of the encodings need to write anything
+    // for it, but the next input may start with a byte order mark again
+    converter->input_order_known = 0;
+    converter->input_big_endian = NATIVE_BIG_ENDIAN;
+    converter->wrote_order_mark = 0;
+    return 0;
+  }
+  const unsigned char *in = (const unsigned char *)*inbuf;
+  const unsigned char *in_end = in + *inbytesleft;
+  unsigned char *out = NULL;
+  unsigned char *out_end = NULL;
+  if (outbuf != NULL && *outbuf != NULL) {
+    out = (unsigned char *)*outbuf;
+    out_end = out + *outbytesleft;
+  }
+  size_t in_size = unit_size(converter->from);
+  size_t out_size = unit_size(converter->to);
+  size_t irreversible = 0;
+  int error = 0;
+  char skipped = 0;
+
+  if ((converter->from == UTF16 || converter->from == UTF32) &&
+      !converter->input_order_known && (size_t)(in_end - in) >= in_size) {
+    uint32_t mark = read_unit(in, in_size, 1);
+    converter->input_order_known = 1;
+    if (mark == 0xfeff) {
+      converter->input_big_endian = 1;
+      in += in_size;
+    } else if (mark == (in_size == 2 ? 0xfffeu : 0xfffe0000u)) {
+      converter->input_big_endian = 0;
+      in += in_size;
+    }
+  }
+  // the byte order mark is only written together with the first character
+  size_t mark_size = 0;
+  if ((converter->to == UTF16 || converter->to == UTF32) &&
+      !converter->wrote_order_mark) {
+    mark_size = out_size;
+  }
+
+  int ascii_runs = keeps_ascii(converter->from);
+  int unicode = is_unicode(converter->from) && is_unicode(converter->to);
+  int input = input_big_endian(converter);
+  int big_endian = output_big_endian(converter->to);
+  int validate = converter->from == UTF8 && converter->to == UTF8;
+  while (in < in_end) {
+    // UTF-8 to UTF-8 only needs to copy what is valid
+    if (validate) {
+      size_t room = out_end - out;
+      size_t available = in_end - in;
+      size_t valid = dandelion_utf8_length(
+          (const char *)in, available < room ? available : room);
+      if (valid > 0) {
+        memcpy(out, in, valid);
+        in += valid;
+        out += valid;
+        if (in == in_end) {
+          break;
+        }
+      }
+    }
+    if (ascii_runs && in[0] < 0x80 && (size_t)(out_end - out) >= mark_size) {
+      size_t room = (size_t)(out_end - out - mark_size) / out_size;
+      size_t available = in_end - in;
+      size_t ascii = dandelion_ascii_length(
+          (const char *)in, available < room ? available : room);
+      if (ascii > 0) {
+        out = write_order_mark(converter, out, mark_size);
+        mark_size = 0;
+        if (out_size == 1) {
+          memcpy(out, in, ascii);
+        } else {
+          widen_ascii(in, ascii, out, out_size, big_endian);
+        }
+        in += ascii;
+        out += ascii * out_size;
+        if (in == in_end) {
+          break;
+        }
+      }
+    }
+    if (unicode && mark_size == 0) {
+      convert_unicode(converter, &in, in_end, &out, out_end);
+      if (in == in_end) {
+        break;
+      }
+    }
+    uint32_t code;
+    int read = decode(converter->from, input, in, in_end - in, &code);
+    if (read == 0) {
+      error = EINVAL;
+      break;
+    }
+    if (read < 0) {
+      if (!converter->discard) {
+        error = EILSEQ;
+        break;
+      }
+      skipped = 1;
+      in += in_size;
+      continue;
+    }
+    size_t room = out_end - out;
+    room = room < mark_size ? 0 : room - mark_size;
+    int written =
+        encode(converter->to, big_endian, code, out + mark_size, room);
+    if (written < 0 && converter->transliterate) {
+      written = encode(converter->to, big_endian, '?', out + mark_size, room);
+      if (written > 0) {
+        irreversible++;
+      }
+    } else if (written < 0 && converter->discard) {
+      skipped = 1;
+      in += read;
+      continue;
+    }
+    if (written < 0) {
+      error = EILSEQ;
+      break;
+    }
+    if (written == 0) {
+      if ((size_t)(out_end - out) >= mark_size) {
+        out = write_order_mark(converter, out, mark_size);
+      }
+      error = E2BIG;
+      break;
+    }
+    out = write_order_mark(converter, out, mark_size);
+    mark_size = 0;
+    in += read;
+    out += written;
+  }
+
+  *inbuf = (char *)in;
+  *inbytesleft = in_end - in;
+  if (out != NULL) {
+    *outbuf = (char *)out;
+    *outbytesleft = out_end - out;
+  }
+  // like glibc, skipping input is reported once the rest is converted
+  if (error == 0 && skipped) {
+    error = EILSEQ;
+  }
+  if (error != 0) {
+    errno = error;
+    return (size_t)-1;
+  }
+  return irreversible;
+}
+
+int iconv_close(iconv_t cd) {
+  free(cd);
+  return 0;
+}
@@ -0,0 +1,1701 @@
+#include <ctype.h>
+#include <limits.h>
+#include <regex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    POSIX basic and extended regular expressions on bytes in the C locale.
+    Patterns are parsed into a tree and compiled into a program for a
+    Thompson NFA. Match-only queries run on a DFA that is built lazily from
+    the program while scanning, its states are cached in the compiled pattern
+    and reused by later calls. Submatches are found by a Pike VM simulating the
+    NFA, which only runs after the DFA found a match. Where all matches start
+    with a literal, idle scans skip to the next occurrence of it with the
+    vectorized byte search of the runtime. Back-references can not be
+    expressed by automata, patterns using them run on a backtracking matcher.
+    The overall match is the leftmost-longest one, for submatches earlier
+    alternatives and longer repetitions take priority, which is close to but
+    not the same as the POSIX subexpression rules.
+    The GNU operators \| \+ \? in basic expressions and the classes \w \W \s
+    \S are supported, word boundary assertions are not.
+*/
+
+extern const char *dandelion_find_byte(const char *data, size_t len,
+                                       char byte);
+
+#define REGEX_MAGIC 0x52454758
+// upper bound for the program length after expanding repetitions
+#define MAX_PROGRAM 65536
+// deepest nesting of subexpressions
+#define MAX_DEPTH 256
+// states the DFA caches before starting over
+#define MAX_DFA_STATES 512
+// marks a transition that has not been computed yet
+#define DFA_UNKNOWN -1
+// longest literal prefix used for skipping
+#define MAX_PREFIX 32
+
+typedef enum Opcode {
+  OP_BYTE,
+  OP_CLASS,
+  OP_ANY,
+  OP_SPLIT,
+  OP_JMP,
+  OP_SAVE,
+  OP_BOL,
+  OP_EOL,
+  OP_BACKREF,
+  OP_MATCH,
+} Opcode;
+
+typedef struct Inst {
+  uint8_t op;
+  uint8_t byte;
+  // jump target, class index, capture slot or group
+  uint32_t arg;
+  // second target of a split, which has lower priority
+  uint32_t alt;
+} Inst;
+
+typedef struct ByteClass {
+  uint32_t bits[8];
+} ByteClass;
+
+// sparse set of program counters, visiting each pc once per step
+typedef struct PcSet {
+  uint32_t *dense;
+  uint32_t *sparse;
+  size_t len;
+} PcSet;
+
+typedef struct DfaState {
+  // offset of the sorted program counters in the pc pool
+  size_t pcs;
+  size_t pcs_len;
+  char at_bol;
+  char has_match;
+  // a match is reached if the end of a line or of the input follows
+  char match_at_eol;
+  int next[256];
+} DfaState;
+
+typedef struct Dfa {
+  DfaState *states;
+  size_t states_len;
+  uint32_t *pc_pool;
+  size_t pc_pool_len;
+  size_t pc_pool_cap;
+  // open addressing table from pc sets to state index + 1
+  int *table;
+  // start states in the middle and at the beginning of a line, -1 if unknown
+  int starts[2];
+  // buffers for computing new states, sized by the program length
+  PcSet set;
+  uint32_t *stack;
+  uint32_t *sorted;
+  uint32_t *consuming;
+} Dfa;
+
+struct re_guts {
+  Inst *program;
+  size_t program_len;
+  ByteClass *classes;
+  int cflags;
+  char has_backrefs;
+  // nothing can match except at the beginning of a line
+  char start_needs_bol;
+  char prefix[MAX_PREFIX];
+  size_t prefix_len;
+  Dfa dfa;
+};
+
+static inline int class_has(const ByteClass *class, unsigned char byte) {
+  return (class->bits[byte >> 5] >> (byte & 31)) & 1;
+}
+
+static inline void class_add(ByteClass *class, unsigned char byte) {
+  class->bits[byte >> 5] |= 1u << (byte & 31);
+}
+
+// makes room for one more element, doubling the capacity when full
+static int grow(void **array, size_t *cap, size_t len, size_t element) {
+  if (len < *cap) {
+    return 0;
+  }
+  size_t new_cap = *cap == 0 ? 16 : 2 * *cap;
+  void *grown = realloc(*array, new_cap * element);
+  if (grown == NULL) {
+    return -1;
+  }
+  *array = grown;
+  *cap = new_cap;
+  return 0;
+}
+
+// parsing
+
+typedef enum NodeType {
+  NODE_EMPTY,
+  NODE_BYTE,
+  NODE_CLASS,
+  NODE_ANY,
+  NODE_BOL,
+  NODE_EOL,
+  NODE_BACKREF,
+  NODE_CAT,
+  NODE_ALT,
+  NODE_REPEAT,
+  NODE_GROUP,
+} NodeType;
+
+// concatenations and alternations are chains continuing in the right child
+typedef struct Node {
+  NodeType type;
+  // byte, class index, group number or minimum repetitions
+  int value;
+  // maximum repetitions, -1 for no limit
+  int max;
+  int left;
+  int right;
+} Node;
+
+typedef struct Parser {
+  const char *pattern;
+  const char *end;
+  int cflags;
+  int error;
+  int depth;
+  Node *nodes;
+  size_t nodes_len;
+  size_t nodes_cap;
+  ByteClass *classes;
+  size_t classes_len;
+  size_t classes_cap;
+  size_t groups;
+  // groups that have been closed and can be referenced
+  uint32_t closed_groups;
+  char has_backrefs;
+} Parser;
+
+typedef struct Chain {
+  int head;
+  int tail;
+} Chain;
+
+static int new_node(Parser *parser, NodeType type, int value, int left) {
+  if (grow((void **)&parser->nodes, &parser->nodes_cap, parser->nodes_len,
+           sizeof(Node)) != 0) {
+    parser->error = REG_ESPACE;
+    return -1;
+  }
+  Node *node = &parser->nodes[parser->nodes_len];
+  node->type = type;
+  node->value = value;
+  node->max = 0;
+  node->left = left;
+  node->right = -1;
+  return parser->nodes_len++;
+}
+
+static int chain_append(Parser *parser, Chain *chain, NodeType type,
+                        int node) {
+  if (chain->head < 0) {
+    chain->head = node;
+    return 0;
+  }
+  int link;
+  if (chain->tail < 0) {
+    link = new_node(parser, type, 0, chain->head);
+    chain->head = link;
+  } else {
+    link = new_node(parser, type, 0, parser->nodes[chain->tail].right);
+    parser->nodes[chain->tail].right = link;
+  }
+  if (link < 0) {
+    return -1;
+  }
+  parser->nodes[link].right = node;
+  chain->tail = link;
+  return 0;
+}
+
+static int new_class(Parser *parser) {
+  if (grow((void **)&parser->classes, &parser->classes_cap,
+           parser->classes_len, sizeof(ByteClass)) != 0) {
+    parser->error = REG_ESPACE;
+    return -1;
+  }
+  memset(&parser->classes[parser->classes_len], 0, sizeof(ByteClass));
+  return parser->classes_len++;
+}
+
+// adds the other case of every letter in the class
+static void class_fold_case(ByteClass *class) {
+  for (int byte = 0; byte < 256; byte++) {
+    if (class_has(class, byte)) {
+      class_add(class, tolower(byte));
+      class_add(class, toupper(byte));
+    }
+  }
+}
+
+static int byte_node(Parser *parser, unsigned char byte) {
+  if ((parser->cflags & REG_ICASE) && tolower(byte) != toupper(byte)) {
+    int class = new_class(parser);
+    if (class < 0) {
+      return -1;
+    }
+    class_add(&parser->classes[class], byte);
+    class_fold_case(&parser->classes[class]);
+    return new_node(parser, NODE_CLASS, class, -1);
+  }
+  return new_node(parser, NODE_BYTE, byte, -1);
+}
+
+static const struct {
+  const char *name;
+  int (*test)(int);
+} named_classes[] = {
+    {"alnum", isalnum}, {"alpha", isalpha}, {"blank", isblank},
+    {"cntrl", iscntrl}, {"digit", isdigit}, {"graph", isgraph},
+    {"lower", islower}, {"print", isprint}, {"punct", ispunct},
+    {"space", isspace}, {"upper", isupper}, {"xdigit", isxdigit},
+};
+
+// parses the rest of a [: :], [= =] or [. .] element in a bracket expression
+// adds named classes to the class and returns the byte for the others, as
+// only single byte collating elements exist in the C locale
+static int bracket_element(Parser *parser, ByteClass *class, char kind) {
+  const char *start = parser->pattern;
+  while (parser->pattern + 1 < parser->end &&
+         !(parser->pattern[0] == kind && parser->pattern[1] == ']')) {
+    parser->pattern++;
+  }
+  if (parser->pattern + 1 >= parser->end) {
+    parser->error = REG_EBRACK;
+    return -1;
+  }
+  size_t len = parser->pattern - start;
+  parser->pattern += 2;
+  if (kind != ':') {
+    if (len != 1) {
+      parser->error = REG_ECOLLATE;
+      return -1;
+    }
+    return (unsigned char)start[0];
+  }
+  for (size_t index = 0;
+       index < sizeof(named_classes) / sizeof(named_classes[0]); index++) {
+    if (strlen(named_classes[index].name) == len &&
+        memcmp(named_classes[index].name, start, len) == 0) {
+      for (int byte = 0; byte < 256; byte++) {
+        if (named_classes[index].test(byte)) {
+          class_add(class, byte);
+        }
+      }
+      return 0;
+    }
+  }
+  parser->error = REG_ECTYPE;
+  return -1;
+}
+
+static int at_bracket_element(Parser *parser, int allow_class) {
+  return parser->pattern + 1 < parser->end && parser->pattern[0] == '[' &&
+         ((allow_class && parser->pattern[1] == ':') ||
+          parser->pattern[1] == '=' || parser->pattern[1] == '.');
+}
+
+// parses a bracket expression after the opening bracket
+static int parse_bracket(Parser *parser) {
+  ByteClass class = {{0}};
+  int negate = 0;
+  if (parser->pattern < parser->end && *parser->pattern == '^') {
+    negate = 1;
+    parser->pattern++;
+  }
+  int first = 1;
+  while (1) {
+    if (parser->pattern >= parser->end) {
+      parser->error = REG_EBRACK;
+      return -1;
+    }
+    if (*parser->pattern == ']' && !first) {
+      parser->pattern++;
+      break;
+    }
+    first = 0;
+    int low;
+    if (at_bracket_element(parser, 1)) {
+      char kind = parser->pattern[1];
+      parser->pattern += 2;
+      low = bracket_element(parser, &class, kind);
+      if (low < 0) {
+        return -1;
+      }
+      if (kind == ':') {
+        continue;
+      }
+    } else {
+      low = (unsigned char)*parser->pattern++;
+    }
+    // a - right before the closing bracket is an ordinary character
+    if (parser->pattern + 1 >= parser->end || parser->pattern[0] != '-' ||
+        parser->pattern[1] == ']') {
+      class_add(&class, low);
+      continue;
+    }
+    parser->pattern++;
+    int high;
+    if (at_bracket_element(parser, 0)) {
+      char kind = parser->pattern[1];
+      parser->pattern += 2;
+      high = bracket_element(parser, &class, kind);
+      if (high < 0) {
+        return -1;
+      }
+    } else {
+      high = (unsigned char)*parser->pattern++;
+    }
+    if (high < low) {
+      parser->error = REG_ERANGE;
+      return -1;
+    }
+    for (int byte = low; byte <= high; byte++) {
+      class_add(&class, byte);
+    }
+  }
+  if (parser->cflags & REG_ICASE) {
+    class_fold_case(&class);
+  }
+  if (negate) {
+    for (size_t word = 0; word < 8; word++) {
+      class.bits[word] = ~class.bits[word];
+    }
+    if (parser->cflags & REG_NEWLINE) {
+      class.bits['\n' >> 5] &= ~(1u << ('\n' & 31));
+    }
+  }
+  int class_index = new_class(parser);
+  if (class_index < 0) {
+    return -1;
+  }
+  parser->classes[class_index] = class;
+  return new_node(parser, NODE_CLASS, class_index, -1);
+}
+
+// parses the bounds of an interval after the opening brace
+static int parse_interval(Parser *parser, int *min, int *max) {
+  int extended = parser->cflags & REG_EXTENDED;
+  int values[2] = {-1, -1};
+  int current = 0;
+  while (1) {
+    if (parser->pattern >= parser->end) {
+      parser->error = REG_EBRACE;
+      return -1;
+    }
+    char next = *parser->pattern;
+    if (next >= '0' && next <= '9') {
+      int value = values[current] < 0 ? 0 : values[current];
+      value = value * 10 + (next - '0');
+      if (value > RE_DUP_MAX) {
+        parser->error = REG_BADBR;
+        return -1;
+      }
+      values[current] = value;
+      parser->pattern++;
+    } else if (next == ',' && current == 0) {
+      current = 1;
+      parser->pattern++;
+    } else if (extended && next == '}') {
+      parser->pattern++;
+      break;
+    } else if (!extended && next == '\\' &&
+               parser->pattern + 1 < parser->end &&
+               parser->pattern[1] == '}') {
+      parser->pattern += 2;
+      break;
+    } else {
+      parser->error = REG_BADBR;
+      return -1;
+    }
+  }
+  if (values[0] < 0) {
+    parser->error = REG_BADBR;
+    return -1;
+  }
+  *min = values[0];
+  *max = current == 1 ? values[1] : values[0];
+  if (*max >= 0 && *max < *min) {
+    parser->error = REG_BADBR;
+    return -1;
+  }
+  return 0;
+}
+
+static int parse_alternation(Parser *parser, int group);
+
+// returned by parse_atom at the end of a concatenation
+#define NO_ATOM -2
+
+static int parse_atom(Parser *parser, int at_start) {
+  int extended = parser->cflags & REG_EXTENDED;
+  char current = *parser->pattern;
+  const char *next = parser->pattern + 1;
+  if (current == '.') {
+    parser->pattern++;
+    return new_node(parser, NODE_ANY, 0, -1);
+  }
+  if (current == '[') {
+    parser->pattern++;
+    return parse_bracket(parser);
+  }
+  if (current == '^' && (extended || at_start)) {
+    parser->pattern++;
+    return new_node(parser, NODE_BOL, 0, -1);
+  }
+  // in basic expressions $ is an anchor only at the end of a subexpression
+  if (current == '$' &&
+      (extended || next == parser->end ||
+       (next + 1 < parser->end && next[0] == '\\' &&
+        (next[1] == ')' || next[1] == '|')))) {
+    parser->pattern++;
+    return new_node(parser, NODE_EOL, 0, -1);
+  }
+  if (extended) {
+    if (current == '(') {
+      parser->pattern++;
+      return parse_alternation(parser, 1);
+    }
+    if (current == ')' || current == '|') {
+      return NO_ATOM;
+    }
+    if (current == '*' || current == '+' || current == '?' ||
+        (current == '{' && next < parser->end &&
+         isdigit((unsigned char)*next))) {
+      parser->error = REG_BADRPT;
+      return -1;
+    }
+  }
+  if (current != '\\') {
+    parser->pattern++;
+    return byte_node(parser, current);
+  }
+  if (next == parser->end) {
+    parser->error = REG_EESCAPE;
+    return -1;
+  }
+  char escaped = *next;
+  if (!extended) {
+    if (escaped == ')' || escaped == '|') {
+      return NO_ATOM;
+    }
+    if (escaped == '(') {
+      parser->pattern += 2;
+      return parse_alternation(parser, 1);
+    }
+    if (escaped == '{' || escaped == '+' || escaped == '?') {
+      parser->error = REG_BADRPT;
+      return -1;
+    }
+  }
+  parser->pattern += 2;
+  if (escaped >= '1' && escaped <= '9') {
+    int group = escaped - '0';
+    if (!(parser->closed_groups & (1u << group))) {
+      parser->error = REG_ESUBREG;
+      return -1;
+    }
+    parser->has_backrefs = 1;
+    return new_node(parser, NODE_BACKREF, group, -1);
+  }
+  if (escaped == 'w' || escaped == 'W' || escaped == 's' || escaped == 'S') {
+    int class_index = new_class(parser);
+    if (class_index < 0) {
+      return -1;
+    }
+    int word = escaped == 'w' || escaped == 'W';
+    int negate = escaped == 'W' || escaped == 'S';
+    for (int byte = 0; byte < 256; byte++) {
+      int member = word ? isalnum(byte) || byte == '_' : isspace(byte) != 0;
+      if (member != negate) {
+        class_add(&parser->classes[class_index], byte);
+      }
+    }
+    return new_node(parser, NODE_CLASS, class_index, -1);
+  }
+  // word boundaries would need lookbehind in the automata
+  if (escaped == 'b' || escaped == 'B' || escaped == '<' || escaped == '>' ||
+      escaped == '`' || escaped == '\'') {
+    parser->error = REG_EESCAPE;
+    return -1;
+  }
+  return byte_node(parser, escaped);
+}
+
+// applies the repetition operators following an atom
+static int parse_repeats(Parser *parser, int atom) {
+  int extended = parser->cflags & REG_EXTENDED;
+  while (parser->pattern < parser->end) {
+    const char *next = parser->pattern + 1;
+    char operator = *parser->pattern;
+    // apart from * the operators of basic expressions are escaped
+    if (!extended && operator == '\\' && next < parser->end &&
+        (*next == '+' || *next == '?' || *next == '{')) {
+      operator = *next;
+      next++;
+      parser->pattern++;
+    } else if (!extended && operator != '*') {
+      break;
+    }
+    int min;
+    int max;
+    if (operator == '*' || operator == '+' || operator == '?') {
+      parser->pattern++;
+      min = operator == '+' ? 1 : 0;
+      max = operator == '?' ? 1 : -1;
+    } else if (operator == '{' &&
+               (!extended ||
+                (next < parser->end && isdigit((unsigned char)*next)))) {
+      parser->pattern++;
+      if (parse_interval(parser, &min, &max) != 0) {
+        return -1;
+      }
+    } else {
+      break;
+    }
+    // repeating an anchor matches it once
+    NodeType type = parser->nodes[atom].type;
+    if (type == NODE_BOL || type == NODE_EOL) {
+      continue;
+    }
+    atom = new_node(parser, NODE_REPEAT, min, atom);
+    if (atom < 0) {
+      return -1;
+    }
+    parser->nodes[atom].max = max;
+  }
+  return atom;
+}
+
+static int parse_concatenation(Parser *parser) {
+  Chain chain = {-1, -1};
+  int at_start = 1;
+  while (parser->pattern < parser->end) {
+    int atom = parse_atom(parser, at_start);
+    if (atom == NO_ATOM) {
+      break;
+    }
+    if (atom < 0) {
+      return -1;
+    }
+    // a * after a leading ^ is an ordinary character in basic expressions
+    int leading_anchor = at_start && parser->nodes[atom].type == NODE_BOL;
+    if (!leading_anchor || (parser->cflags & REG_EXTENDED)) {
+      atom = parse_repeats(parser, atom);
+      if (atom < 0) {
+        return -1;
+      }
+    }
+    at_start = leading_anchor;
+    if (chain_append(parser, &chain, NODE_CAT, atom) != 0) {
+      return -1;
+    }
+  }
+  if (chain.head < 0) {
+    return new_node(parser, NODE_EMPTY, 0, -1);
+  }
+  return chain.head;
+}
+
+static int at_alternation(Parser *parser) {
+  if (parser->cflags & REG_EXTENDED) {
+    return parser->pattern < parser->end && parser->pattern[0] == '|';
+  }
+  return parser->pattern + 1 < parser->end && parser->pattern[0] == '\\' &&
+         parser->pattern[1] == '|';
+}
+
+static int at_group_end(Parser *parser) {
+  if (parser->cflags & REG_EXTENDED) {
+    return parser->pattern < parser->end && parser->pattern[0] == ')';
+  }
+  return parser->pattern + 1 < parser->end && parser->pattern[0] == '\\' &&
+         parser->pattern[1] == ')';
+}
+
+// parses alternatives up to the end of the pattern or, in a group, up to the
+// closing parenthesis
+static int parse_alternation(Parser *parser, int group) {
+  int extended = parser->cflags & REG_EXTENDED;
+  int number = 0;
+  if (group) {
+    if (++parser->depth > MAX_DEPTH) {
+      parser->error = REG_ESPACE;
+      return -1;
+    }
+    number = ++parser->groups;
+  }
+  Chain chain = {-1, -1};
+  while (1) {
+    int alternative = parse_concatenation(parser);
+    if (alternative < 0 ||
+        chain_append(parser, &chain, NODE_ALT, alternative) != 0) {
+      return -1;
+    }
+    if (!at_alternation(parser)) {
+      break;
+    }
+    parser->pattern += extended ? 1 : 2;
+  }
+  if (!group) {
+    if (parser->pattern != parser->end) {
+      parser->error = REG_EPAREN;
+      return -1;
+    }
+    return chain.head;
+  }
+  if (!at_group_end(parser)) {
+    parser->error = REG_EPAREN;
+    return -1;
+  }
+  parser->pattern += extended ? 1 : 2;
+  parser->depth--;
+  if (number < 32) {
+    parser->closed_groups |= 1u << number;
+  }
+  return new_node(parser, NODE_GROUP, number, chain.head);
+}
+
+// literal bytes every match has to start with
+static size_t find_prefix(const Parser *parser, int root, char *prefix) {
+  size_t len = 0;
+  int index = root;
+  while (len < MAX_PREFIX) {
+    const Node *node = &parser->nodes[index];
+    if (node->type == NODE_BYTE) {
+      prefix[len++] = node->value;
+      break;
+    }
+    if (node->type != NODE_CAT ||
+        parser->nodes[node->left].type != NODE_BYTE) {
+      break;
+    }
+    prefix[len++] = parser->nodes[node->left].value;
+    index = node->right;
+  }
+  return len;
+}
+
+// compilation
+
+typedef struct Compiler {
+  const Node *nodes;
+  Inst *program;
+  size_t len;
+  size_t cap;
+  int error;
+} Compiler;
+
+static int emit(Compiler *compiler, Opcode op, uint32_t arg, uint32_t alt) {
+  if (compiler->len >= MAX_PROGRAM ||
+      grow((void **)&compiler->program, &compiler->cap, compiler->len,
+           sizeof(Inst)) != 0) {
+    compiler->error = REG_ESPACE;
+    return -1;
+  }
+  Inst *inst = &compiler->program[compiler->len];
+  inst->op = op;
+  inst->byte = 0;
+  inst->arg = arg;
+  inst->alt = alt;
+  return compiler->len++;
+}
+
+static int compile_node(Compiler *compiler, int index);
+
+static int compile_repeat(Compiler *compiler, const Node *node) {
+  for (int count = 0; count < node->value; count++) {
+    if (compile_node(compiler, node->left) != 0) {
+      return -1;
+    }
+  }
+  if (node->max < 0) {
+    // split body, out; body; jmp split
+    int split = emit(compiler, OP_SPLIT, 0, 0);
+    if (split < 0 || compile_node(compiler, node->left) != 0 ||
+        emit(compiler, OP_JMP, split, 0) < 0) {
+      return -1;
+    }
+    compiler->program[split].arg = split + 1;
+    compiler->program[split].alt = compiler->len;
+    return 0;
+  }
+  // optional copies nested in each other, skipping one skips all following
+  // ones, the splits are linked through their alt until the end is known
+  uint32_t pending = 0;
+  for (int count = node->value; count < node->max; count++) {
+    int split = emit(compiler, OP_SPLIT, 0, pending);
+    if (split < 0 || compile_node(compiler, node->left) != 0) {
+      return -1;
+    }
+    compiler->program[split].arg = split + 1;
+    pending = split + 1;
+  }
+  while (pending != 0) {
+    Inst *split = &compiler->program[pending - 1];
+    pending = split->alt;
+    split->alt = compiler->len;
+  }
+  return 0;
+}
+
+static int compile_node(Compiler *compiler, int index) {
+  const Node *node = &compiler->nodes[index];
+  int pc;
+  switch (node->type) {
+  case NODE_EMPTY:
+    return 0;
+  case NODE_BYTE:
+    pc = emit(compiler, OP_BYTE, 0, 0);
+    if (pc < 0) {
+      return -1;
+    }
+    compiler->program[pc].byte = node->value;
+    return 0;
+  case NODE_CLASS:
+    return emit(compiler, OP_CLASS, node->value, 0) < 0 ? -1 : 0;
+  case NODE_ANY:
+    return emit(compiler, OP_ANY, 0, 0) < 0 ? -1 : 0;
+  case NODE_BOL:
+    return emit(compiler, OP_BOL, 0, 0) < 0 ? -1 : 0;
+  case NODE_EOL:
+    return emit(compiler, OP_EOL, 0, 0) < 0 ? -1 : 0;
+  case NODE_BACKREF:
+    return emit(compiler, OP_BACKREF, node->value, 0) < 0 ? -1 : 0;
+  case NODE_GROUP:
+    if (emit(compiler, OP_SAVE, 2 * node->value, 0) < 0 ||
+        compile_node(compiler, node->left) != 0 ||
+        emit(compiler, OP_SAVE, 2 * node->value + 1, 0) < 0) {
+      return -1;
+    }
+    return 0;
+  case NODE_REPEAT:
+    return compile_repeat(compiler, node);
+  case NODE_CAT:
+    // chains are walked in a loop, so long patterns do not recurse deeply
+    for (; node->type == NODE_CAT; node = &compiler->nodes[node->right]) {
+      if (compile_node(compiler, node->left) != 0) {
+        return -1;
+      }
+    }
+    return compile_node(compiler, node - compiler->nodes);
+  case NODE_ALT: {
+    // split left, next; left; jmp end; next: ...
+    // the jumps are linked through their targets until the end is known
+    uint32_t pending = 0;
+    for (; node->type == NODE_ALT; node = &compiler->nodes[node->right]) {
+      int split = emit(compiler, OP_SPLIT, 0, 0);
+      if (split < 0 || compile_node(compiler, node->left) != 0) {
+        return -1;
+      }
+      int jump = emit(compiler, OP_JMP, pending, 0);
+      if (jump < 0) {
+        return -1;
+      }
+      pending = jump + 1;
+      compiler->program[split].arg = split + 1;
+      compiler->program[split].alt = compiler->len;
+    }
+    if (compile_node(compiler, node - compiler->nodes) != 0) {
+      return -1;
+    }
+    while (pending != 0) {
+      Inst *jump = &compiler->program[pending - 1];
+      pending = jump->arg;
+      jump->arg = compiler->len;
+    }
+    return 0;
+  }
+  }
+  return -1;
+}
+
+static int dfa_init(Dfa *dfa, size_t program_len) {
+  dfa->set.dense = malloc(program_len * sizeof(uint32_t));
+  dfa->set.sparse = malloc(program_len * sizeof(uint32_t));
+  dfa->stack = malloc(program_len * sizeof(uint32_t));
+  dfa->sorted = malloc(program_len * sizeof(uint32_t));
+  dfa->consuming = malloc(2 * program_len * sizeof(uint32_t));
+  dfa->states = malloc(MAX_DFA_STATES * sizeof(DfaState));
+  dfa->table = calloc(2 * MAX_DFA_STATES, sizeof(int));
+  dfa->starts[0] = -1;
+  dfa->starts[1] = -1;
+  if (dfa->set.dense == NULL || dfa->set.sparse == NULL ||
+      dfa->stack == NULL || dfa->sorted == NULL || dfa->consuming == NULL ||
+      dfa->states == NULL || dfa->table == NULL) {
+    return -1;
+  }
+  return 0;
+}
+
+static void dfa_free(Dfa *dfa) {
+  free(dfa->set.dense);
+  free(dfa->set.sparse);
+  free(dfa->stack);
+  free(dfa->sorted);
+  free(dfa->consuming);
+  free(dfa->states);
+  free(dfa->table);
+  free(dfa->pc_pool);
+}
+
+static void closure(const struct re_guts *guts, PcSet *set, uint32_t *stack,
+                    uint32_t pc, int bol, int eol);
+
+static const char *const error_messages[] = {
+    "success",
+    "no match",
+    "invalid regular expression",
+    "invalid collating element",
+    "invalid character class",
+    "trailing backslash",
+    "invalid back reference",
+    "brackets not balanced",
+    "parentheses not balanced",
+    "braces not balanced",
+    "invalid repetition count",
+    "invalid character range",
+    "out of memory",
+    "repetition operator without operand",
+    "empty expression",
+    "assertion failure",
+    "invalid argument",
+};
+
+int regcomp(regex_t *restrict preg, const char *restrict pattern, int cflags) {
+  if (preg == NULL || pattern == NULL) {
+    return REG_INVARG;
+  }
+  Parser parser = {0};
+  parser.pattern = pattern;
+  parser.cflags = cflags;
+  if (cflags & REG_PEND) {
+    if (preg->re_endp < pattern) {
+      return REG_INVARG;
+    }
+    parser.end = preg->re_endp;
+  } else {
+    parser.end = pattern + strlen(pattern);
+  }
+  int root;
+  if (cflags & REG_NOSPEC) {
+    Chain chain = {-1, -1};
+    root = 0;
+    while (parser.pattern < parser.end && root >= 0) {
+      int byte = byte_node(&parser, *parser.pattern++);
+      root = byte < 0 ? -1 : chain_append(&parser, &chain, NODE_CAT, byte);
+    }
+    if (root >= 0) {
+      root = chain.head >= 0 ? chain.head
+                             : new_node(&parser, NODE_EMPTY, 0, -1);
+    }
+  } else {
+    root = parse_alternation(&parser, 0);
+  }
+  Compiler compiler = {0};
+  compiler.nodes = parser.nodes;
+  struct re_guts *guts = NULL;
+  int error = parser.error != 0 ? parser.error : REG_ESPACE;
+  if (root < 0) {
+    goto fail;
+  }
+  // save 0; expression; save 1; match
+  if (emit(&compiler, OP_SAVE, 0, 0) < 0 ||
+      compile_node(&compiler, root) != 0 ||
+      emit(&compiler, OP_SAVE, 1, 0) < 0 ||
+      emit(&compiler, OP_MATCH, 0, 0) < 0) {
+    error = compiler.error != 0 ? compiler.error : REG_ESPACE;
+    goto fail;
+  }
+  guts = calloc(1, sizeof(struct re_guts));
+  if (guts == NULL || dfa_init(&guts->dfa, compiler.len) != 0) {
+    goto fail;
+  }
+  guts->program = compiler.program;
+  guts->program_len = compiler.len;
+  guts->classes = parser.classes;
+  guts->cflags = cflags;
+  guts->has_backrefs = parser.has_backrefs;
+  if (!(cflags & REG_ICASE)) {
+    guts->prefix_len = find_prefix(&parser, root, guts->prefix);
+  }
+  // check if anything is reachable from the start outside of line starts
+  guts->dfa.set.len = 0;
+  closure(guts, &guts->dfa.set, guts->dfa.stack, 0, 0, 1);
+  guts->start_needs_bol = 1;
+  for (size_t index = 0; index < guts->dfa.set.len; index++) {
+    uint8_t op = guts->program[guts->dfa.set.dense[index]].op;
+    if (op != OP_SAVE && op != OP_BOL && op != OP_JMP && op != OP_SPLIT &&
+        op != OP_EOL) {
+      guts->start_needs_bol = 0;
+    }
+  }
+  free(parser.nodes);
+  preg->re_magic = REGEX_MAGIC;
+  preg->re_nsub = parser.groups;
+  preg->re_g = guts;
+  return 0;
+fail:
+  if (guts != NULL) {
+    dfa_free(&guts->dfa);
+    free(guts);
+  }
+  free(parser.nodes);
+  free(parser.classes);
+  free(compiler.program);
+  return error;
+}
+
+size_t regerror(int errcode, const regex_t *restrict preg,
+                char *restrict errbuf, size_t errbuf_size) {
+  (void)preg;
+  const char *message = "unknown error";
+  if (errcode >= 0 &&
+      (size_t)errcode < sizeof(error_messages) / sizeof(error_messages[0])) {
+    message = error_messages[errcode];
+  }
+  size_t len = strlen(message) + 1;
+  if (errbuf != NULL && errbuf_size != 0) {
+    size_t copy = len < errbuf_size ? len : errbuf_size;
+    memcpy(errbuf, message, copy - 1);
+    errbuf[copy - 1] = '\0';
+  }
+  return len;
+}
+
+void regfree(regex_t *preg) {
+  if (preg == NULL || preg->re_magic != REGEX_MAGIC) {
+    return;
+  }
+  struct re_guts *guts = preg->re_g;
+  dfa_free(&guts->dfa);
+  free(guts->program);
+  free(guts->classes);
+  free(guts);
+  preg->re_magic = 0;
+  preg->re_g = NULL;
+}
+
+// matching
+
+typedef struct Input {
+  // offsets of matches are relative to begin
+  const char *begin;
+  // where the search starts, which counts as the beginning of a line
+  const char *start;
+  const char *end;
+  int cflags;
+  int eflags;
+} Input;
+
+static inline int at_bol(const Input *input, const char *position) {
+  if (position == input->start) {
+    return !(input->eflags & REG_NOTBOL);
+  }
+  return (input->cflags & REG_NEWLINE) && position[-1] == '\n';
+}
+
+static inline int at_eol(const Input *input, const char *position) {
+  if (position == input->end) {
+    return !(input->eflags & REG_NOTEOL);
+  }
+  return (input->cflags & REG_NEWLINE) && position[0] == '\n';
+}
+
+static inline int is_consuming(uint8_t op) {
+  return op == OP_BYTE || op == OP_CLASS || op == OP_ANY;
+}
+
+static inline int inst_matches(const struct re_guts *guts, const Inst *inst,
+                               unsigned char byte) {
+  switch (inst->op) {
+  case OP_BYTE:
+    return inst->byte == byte;
+  case OP_CLASS:
+    return class_has(&guts->classes[inst->arg], byte);
+  case OP_ANY:
+    return byte != '\n' || !(guts->cflags & REG_NEWLINE);
+  default:
+    return 0;
+  }
+}
+
+// next occurrence of the literal prefix at or after from, NULL if there is
+// none before end
+static const char *next_candidate(const struct re_guts *guts, const char *from,
+                                  const char *end) {
+  while ((size_t)(end - from) >= guts->prefix_len) {
+    const char *found = dandelion_find_byte(
+        from, end - from - guts->prefix_len + 1, guts->prefix[0]);
+    if (found == NULL) {
+      return NULL;
+    }
+    if (memcmp(found, guts->prefix, guts->prefix_len) == 0) {
+      return found;
+    }
+    from = found + 1;
+  }
+  return NULL;
+}
+
+static inline int pcset_insert(PcSet *set, uint32_t pc) {
+  uint32_t index = set->sparse[pc];
+  if (index < set->len && set->dense[index] == pc) {
+    return 0;
+  }
+  set->sparse[pc] = set->len;
+  set->dense[set->len++] = pc;
+  return 1;
+}
+
+// adds everything reachable from pc without consuming input to the set
+// end of line assertions are passed only if eol is set, otherwise they stay
+// in the set as pending
+static void closure(const struct re_guts *guts, PcSet *set, uint32_t *stack,
+                    uint32_t pc, int bol, int eol) {
+  size_t stack_len = 0;
+  stack[stack_len++] = pc;
+  while (stack_len > 0) {
+    pc = stack[--stack_len];
+    while (pcset_insert(set, pc)) {
+      const Inst *inst = &guts->program[pc];
+      if (inst->op == OP_JMP) {
+        pc = inst->arg;
+      } else if (inst->op == OP_SPLIT) {
+        stack[stack_len++] = inst->alt;
+        pc = inst->arg;
+      } else if (inst->op == OP_SAVE || (inst->op == OP_BOL && bol) ||
+                 (inst->op == OP_EOL && eol)) {
+        pc++;
+      } else {
+        break;
+      }
+    }
+  }
+}
+
+static int compare_pcs(const void *one, const void *two) {
+  uint32_t first = *(const uint32_t *)one;
+  uint32_t second = *(const uint32_t *)two;
+  return first < second ? -1 : first > second;
+}
+
+static void dfa_reset(Dfa *dfa) {
+  dfa->states_len = 0;
+  dfa->pc_pool_len = 0;
+  dfa->starts[0] = -1;
+  dfa->starts[1] = -1;
+  memset(dfa->table, 0, 2 * MAX_DFA_STATES * sizeof(int));
+}
+
+// finds or creates the state for the pcs in the set of the dfa
+// returns the state index, -1 without memory and -2 if the cache is full
+static int dfa_intern(struct re_guts *guts, int bol) {
+  Dfa *dfa = &guts->dfa;
+  // states only differ in the instructions that can still make progress
+  size_t len = 0;
+  for (size_t index = 0; index < dfa->set.len; index++) {
+    uint32_t pc = dfa->set.dense[index];
+    uint8_t op = guts->program[pc].op;
+    if (is_consuming(op) || op == OP_EOL || op == OP_MATCH) {
+      dfa->sorted[len++] = pc;
+    }
+  }
+  qsort(dfa->sorted, len, sizeof(uint32_t), compare_pcs);
+  uint64_t hash = 14695981039346656037ULL ^ bol;
+  for (size_t index = 0; index < len; index++) {
+    hash = (hash ^ dfa->sorted[index]) * 1099511628211ULL;
+  }
+  size_t slot = hash & (2 * MAX_DFA_STATES - 1);
+  while (dfa->table[slot] != 0) {
+    const DfaState *state = &dfa->states[dfa->table[slot] - 1];
+    if (state->pcs_len == len && state->at_bol == bol &&
+        (len == 0 || memcmp(dfa->pc_pool + state->pcs, dfa->sorted,
+                            len * sizeof(uint32_t)) == 0)) {
+      return dfa->table[slot] - 1;
+    }
+    slot = (slot + 1) & (2 * MAX_DFA_STATES - 1);
+  }
+  if (dfa->states_len == MAX_DFA_STATES) {
+    return -2;
+  }
+  while (dfa->pc_pool_len + len > dfa->pc_pool_cap) {
+    if (grow((void **)&dfa->pc_pool, &dfa->pc_pool_cap, dfa->pc_pool_cap,
+             sizeof(uint32_t)) != 0) {
+      return -1;
+    }
+  }
+  DfaState *state = &dfa->states[dfa->states_len];
+  state->pcs = dfa->pc_pool_len;
+  state->pcs_len = len;
+  state->at_bol = bol;
+  state->has_match = 0;
+  state->match_at_eol = 0;
+  if (len > 0) {
+    memcpy(dfa->pc_pool + state->pcs, dfa->sorted, len * sizeof(uint32_t));
+  }
+  dfa->pc_pool_len += len;
+  // check whether pending end of line assertions lead to a match
+  dfa->set.len = 0;
+  for (size_t index = 0; index < len; index++) {
+    uint32_t pc = dfa->sorted[index];
+    if (guts->program[pc].op == OP_MATCH) {
+      state->has_match = 1;
+    } else if (guts->program[pc].op == OP_EOL) {
+      closure(guts, &dfa->set, dfa->stack, pc + 1, bol, 1);
+    }
+  }
+  for (size_t index = 0; index < dfa->set.len; index++) {
+    if (guts->program[dfa->set.dense[index]].op == OP_MATCH) {
+      state->match_at_eol = 1;
+    }
+  }
+  for (size_t byte = 0; byte < 256; byte++) {
+    state->next[byte] = DFA_UNKNOWN;
+  }
+  dfa->table[slot] = ++dfa->states_len;
+  return dfa->states_len - 1;
+}
+
+// state at a position where no match attempt is in progress yet
+static int dfa_start(struct re_guts *guts, int bol) {
+  Dfa *dfa = &guts->dfa;
+  if (dfa->starts[bol] < 0) {
+    dfa->set.len = 0;
+    closure(guts, &dfa->set, dfa->stack, 0, bol, 0);
+    dfa->starts[bol] = dfa_intern(guts, bol);
+  }
+  return dfa->starts[bol];
+}
+
+// computes the transition of the state on the byte
+static int dfa_step(struct re_guts *guts, int from, unsigned char byte) {
+  Dfa *dfa = &guts->dfa;
+  const DfaState *state = &dfa->states[from];
+  int newline = byte == '\n' && (guts->cflags & REG_NEWLINE);
+  // pending end of line assertions hold right before a newline
+  size_t consuming_len = 0;
+  dfa->set.len = 0;
+  for (size_t index = 0; index < state->pcs_len; index++) {
+    uint32_t pc = dfa->pc_pool[state->pcs + index];
+    if (guts->program[pc].op != OP_EOL) {
+      dfa->consuming[consuming_len++] = pc;
+    } else if (newline) {
+      closure(guts, &dfa->set, dfa->stack, pc + 1, state->at_bol, 1);
+    }
+  }
+  for (size_t index = 0; index < dfa->set.len; index++) {
+    dfa->consuming[consuming_len++] = dfa->set.dense[index];
+  }
+  dfa->set.len = 0;
+  for (size_t index = 0; index < consuming_len; index++) {
+    uint32_t pc = dfa->consuming[index];
+    if (inst_matches(guts, &guts->program[pc], byte)) {
+      closure(guts, &dfa->set, dfa->stack, pc + 1, newline, 0);
+    }
+  }
+  // a match can start at every position
+  closure(guts, &dfa->set, dfa->stack, 0, newline, 0);
+  return dfa_intern(guts, newline);
+}
+
+// empties the full cache except for the state in use and the idle state
+static int dfa_restart(struct re_guts *guts, int *state, int *idle) {
+  Dfa *dfa = &guts->dfa;
+  const DfaState *current = &dfa->states[*state];
+  int bol = current->at_bol;
+  // the reset keeps the contents of the pc pool, so they can still be read
+  size_t pcs = current->pcs;
+  size_t pcs_len = current->pcs_len;
+  dfa_reset(dfa);
+  dfa->set.len = 0;
+  for (size_t index = 0; index < pcs_len; index++) {
+    pcset_insert(&dfa->set, dfa->pc_pool[pcs + index]);
+  }
+  *state = dfa_intern(guts, bol);
+  *idle = dfa_start(guts, 0);
+  return *state < 0 || *idle < 0 ? -1 : 0;
+}
+
+// returns 1 if there is a match, 0 if there is none and -1 if the dfa ran
+// out of memory
+static int dfa_search(struct re_guts *guts, const Input *input) {
+  Dfa *dfa = &guts->dfa;
+  // state without any match attempt in progress in the middle of a line
+  int idle = dfa_start(guts, 0);
+  int state = dfa_start(guts, at_bol(input, input->start));
+  if (idle == -2 || state == -2) {
+    dfa_reset(dfa);
+    idle = dfa_start(guts, 0);
+    state = dfa_start(guts, at_bol(input, input->start));
+  }
+  if (idle < 0 || state < 0) {
+    return -1;
+  }
+  int newlines = guts->cflags & REG_NEWLINE;
+  const char *position = input->start;
+  while (1) {
+    const DfaState *current = &dfa->states[state];
+    if (current->has_match) {
+      return 1;
+    }
+    if (position == input->end) {
+      return current->match_at_eol && at_eol(input, position);
+    }
+    if (current->match_at_eol && newlines && *position == '\n') {
+      return 1;
+    }
+    if (state == idle) {
+      // no new match can start without a new line
+      if (guts->start_needs_bol && !newlines) {
+        return 0;
+      }
+      if (guts->prefix_len > 0) {
+        const char *candidate = next_candidate(guts, position, input->end);
+        if (candidate == NULL) {
+          return 0;
+        }
+        if (candidate != position) {
+          position = candidate;
+          if (at_bol(input, position)) {
+            state = dfa_start(guts, 1);
+            if (state == -2) {
+              dfa_reset(dfa);
+              idle = dfa_start(guts, 0);
+              state = dfa_start(guts, 1);
+            }
+            if (idle < 0 || state < 0) {
+              return -1;
+            }
+          }
+          continue;
+        }
+      }
+    }
+    unsigned char byte = *position;
+    int next = current->next[byte];
+    if (next == DFA_UNKNOWN) {
+      next = dfa_step(guts, state, byte);
+      if (next == -2) {
+        if (dfa_restart(guts, &state, &idle) != 0) {
+          return -1;
+        }
+        next = dfa_step(guts, state, byte);
+      }
+      if (next < 0) {
+        return -1;
+      }
+      dfa->states[state].next[byte] = next;
+    }
+    state = next;
+    position++;
+  }
+}
+
+// nfa simulation tracking submatches
+
+typedef struct ThreadList {
+  // program counters of the threads in priority order
+  uint32_t *pcs;
+  size_t len;
+  // capture slots of each thread
+  regoff_t *captures;
+  PcSet visited;
+} ThreadList;
+
+typedef struct Pike {
+  const struct re_guts *guts;
+  const Input *input;
+  size_t slots;
+  // captures of the thread being extended
+  regoff_t *work;
+  // pcs left to explore, or capture slots to restore when negative
+  struct {
+    int64_t pc;
+    regoff_t old;
+  } *stack;
+  ThreadList lists[2];
+} Pike;
+
+// adds the threads reachable from pc to the list in priority order
+static void add_thread(Pike *pike, ThreadList *list, uint32_t pc,
+                       const char *position) {
+  const struct re_guts *guts = pike->guts;
+  regoff_t offset = position - pike->input->begin;
+  size_t stack_len = 0;
+  pike->stack[stack_len++].pc = pc;
+  while (stack_len > 0) {
+    stack_len--;
+    if (pike->stack[stack_len].pc < 0) {
+      pike->work[-pike->stack[stack_len].pc - 1] = pike->stack[stack_len].old;
+      continue;
+    }
+    pc = pike->stack[stack_len].pc;
+    while (pcset_insert(&list->visited, pc)) {
+      const Inst *inst = &guts->program[pc];
+      if (inst->op == OP_JMP) {
+        pc = inst->arg;
+      } else if (inst->op == OP_SPLIT) {
+        pike->stack[stack_len++].pc = inst->alt;
+        pc = inst->arg;
+      } else if (inst->op == OP_SAVE) {
+        pike->stack[stack_len].pc = -(int64_t)inst->arg - 1;
+        pike->stack[stack_len++].old = pike->work[inst->arg];
+        pike->work[inst->arg] = offset;
+        pc++;
+      } else if ((inst->op == OP_BOL && at_bol(pike->input, position)) ||
+                 (inst->op == OP_EOL && at_eol(pike->input, position))) {
+        pc++;
+      } else {
+        if (is_consuming(inst->op) || inst->op == OP_MATCH) {
+          list->pcs[list->len] = pc;
+          memcpy(&list->captures[list->len * pike->slots], pike->work,
+                 pike->slots * sizeof(regoff_t));
+          list->len++;
+        }
+        break;
+      }
+    }
+  }
+}
+
+static int pike_init(Pike *pike, const struct re_guts *guts,
+                     const Input *input, size_t slots) {
+  size_t len = guts->program_len;
+  pike->guts = guts;
+  pike->input = input;
+  pike->slots = slots;
+  pike->work = malloc(slots * sizeof(regoff_t));
+  pike->stack = malloc((len + 1) * sizeof(*pike->stack));
+  int failed = pike->work == NULL || pike->stack == NULL;
+  for (size_t index = 0; index < 2; index++) {
+    ThreadList *list = &pike->lists[index];
+    list->pcs = malloc(len * sizeof(uint32_t));
+    list->captures = malloc(len * slots * sizeof(regoff_t));
+    list->visited.dense = malloc(len * sizeof(uint32_t));
+    list->visited.sparse = malloc(len * sizeof(uint32_t));
+    list->len = 0;
+    list->visited.len = 0;
+    failed |= list->pcs == NULL || list->captures == NULL ||
+              list->visited.dense == NULL || list->visited.sparse == NULL;
+  }
+  return failed ? -1 : 0;
+}
+
+static void pike_free(Pike *pike) {
+  free(pike->work);
+  free(pike->stack);
+  for (size_t index = 0; index < 2; index++) {
+    free(pike->lists[index].pcs);
+    free(pike->lists[index].captures);
+    free(pike->lists[index].visited.dense);
+    free(pike->lists[index].visited.sparse);
+  }
+}
+
+// finds the leftmost-longest match and stores its captures in result
+// returns 1 on a match, 0 without one and -1 without memory
+static int pike_search(const struct re_guts *guts, const Input *input,
+                       regoff_t *result, size_t slots) {
+  Pike pike;
+  if (pike_init(&pike, guts, input, slots) != 0) {
+    pike_free(&pike);
+    return -1;
+  }
+  ThreadList *current = &pike.lists[0];
+  ThreadList *next = &pike.lists[1];
+  int matched = 0;
+  regoff_t best_start = 0;
+  const char *position = input->start;
+  while (1) {
+    if (!matched) {
+      // with nothing in progress, skip to where a match can start
+      if (current->len == 0 && guts->prefix_len > 0) {
+        position = next_candidate(guts, position, input->end);
+        if (position == NULL) {
+          break;
+        }
+      }
+      if (!guts->start_needs_bol || at_bol(input, position)) {
+        for (size_t slot = 0; slot < slots; slot++) {
+          pike.work[slot] = -1;
+        }
+        add_thread(&pike, current, 0, position);
+      }
+    }
+    next->len = 0;
+    next->visited.len = 0;
+    for (size_t index = 0; index < current->len; index++) {
+      uint32_t pc = current->pcs[index];
+      regoff_t *captures = &current->captures[index * slots];
+      // threads starting right of the best match can not win anymore
+      if (matched && captures[0] > best_start) {
+        continue;
+      }
+      const Inst *inst = &guts->program[pc];
+      if (inst->op == OP_MATCH) {
+        // later matches of the same start are longer
+        if (!matched || captures[0] <= best_start) {
+          matched = 1;
+          best_start = captures[0];
+          memcpy(result, captures, slots * sizeof(regoff_t));
+        }
+        continue;
+      }
+      if (position < input->end &&
+          inst_matches(guts, inst, (unsigned char)*position)) {
+        memcpy(pike.work, captures, slots * sizeof(regoff_t));
+        add_thread(&pike, next, pc + 1, position + 1);
+      }
+    }
+    if (position == input->end || (matched && next->len == 0)) {
+      break;
+    }
+    position++;
+    ThreadList *swap = current;
+    current = next;
+    next = swap;
+    next->visited.len = 0;
+  }
+  pike_free(&pike);
+  return matched;
+}
+
+// backtracking for patterns with back-references
+
+typedef enum ChoiceKind {
+  // continue at pc and offset
+  CHOICE_BRANCH,
+  // restore a capture slot
+  CHOICE_CAPTURE,
+  // restore the offset a split or jump was last passed at
+  CHOICE_MARK,
+} ChoiceKind;
+
+typedef struct Choice {
+  ChoiceKind kind;
+  uint32_t pc;
+  regoff_t value;
+} Choice;
+
+typedef struct Backtracker {
+  const struct re_guts *guts;
+  const Input *input;
+  size_t slots;
+  regoff_t *captures;
+  // offset each split or jump was last passed at on the current path
+  regoff_t *marks;
+  Choice *choices;
+  size_t len;
+  size_t cap;
+} Backtracker;
+
+static int push_choice(Backtracker *bt, ChoiceKind kind, uint32_t pc,
+                       regoff_t value) {
+  if (grow((void **)&bt->choices, &bt->cap, bt->len, sizeof(Choice)) != 0) {
+    return -1;
+  }
+  bt->choices[bt->len].kind = kind;
+  bt->choices[bt->len].pc = pc;
+  bt->choices[bt->len].value = value;
+  bt->len++;
+  return 0;
+}
+
+static int backref_matches(Backtracker *bt, uint32_t group,
+                           regoff_t *offset) {
+  regoff_t start = bt->captures[2 * group];
+  regoff_t end = bt->captures[2 * group + 1];
+  if (start < 0 || end < start) {
+    return 0;
+  }
+  const char *position = bt->input->begin + *offset;
+  const char *text = bt->input->begin + start;
+  size_t len = end - start;
+  if ((size_t)(bt->input->end - position) < len) {
+    return 0;
+  }
+  for (size_t index = 0; index < len; index++) {
+    unsigned char one = text[index];
+    unsigned char two = position[index];
+    if (one != two &&
+        !((bt->guts->cflags & REG_ICASE) && tolower(one) == tolower(two))) {
+      return 0;
+    }
+  }
+  *offset += len;
+  return 1;
+}
+
+// explores the paths starting exactly at start and keeps the longest match
+// in result, returns 1 on a match, 0 without one and -1 without memory
+static int backtrack_at(Backtracker *bt, const char *start,
+                        regoff_t *result) {
+  const struct re_guts *guts = bt->guts;
+  regoff_t input_len = bt->input->end - bt->input->begin;
+  int matched = 0;
+  for (size_t slot = 0; slot < bt->slots; slot++) {
+    bt->captures[slot] = -1;
+  }
+  for (size_t pc = 0; pc < guts->program_len; pc++) {
+    bt->marks[pc] = -1;
+  }
+  bt->len = 0;
+  if (push_choice(bt, CHOICE_BRANCH, 0, start - bt->input->begin) != 0) {
+    return -1;
+  }
+  // a match reaching the end of the input can not be beaten
+  while (bt->len > 0 && !(matched && result[1] == input_len)) {
+    Choice choice = bt->choices[--bt->len];
+    if (choice.kind == CHOICE_CAPTURE) {
+      bt->captures[choice.pc] = choice.value;
+      continue;
+    }
+    if (choice.kind == CHOICE_MARK) {
+      bt->marks[choice.pc] = choice.value;
+      continue;
+    }
+    uint32_t pc = choice.pc;
+    regoff_t offset = choice.value;
+    while (1) {
+      const Inst *inst = &guts->program[pc];
+      const char *position = bt->input->begin + offset;
+      if (inst->op == OP_MATCH) {
+        if (!matched || offset > result[1]) {
+          matched = 1;
+          memcpy(result, bt->captures, bt->slots * sizeof(regoff_t));
+        }
+        break;
+      }
+      if (inst->op == OP_JMP || inst->op == OP_SPLIT) {
+        // passing a loop again without consuming anything can not help
+        if (bt->marks[pc] == offset) {
+          break;
+        }
+        if (push_choice(bt, CHOICE_MARK, pc, bt->marks[pc]) != 0 ||
+            (inst->op == OP_SPLIT &&
+             push_choice(bt, CHOICE_BRANCH, inst->alt, offset) != 0)) {
+          return -1;
+        }
+        bt->marks[pc] = offset;
+        pc = inst->arg;
+      } else if (inst->op == OP_SAVE) {
+        if (push_choice(bt, CHOICE_CAPTURE, inst->arg,
+                        bt->captures[inst->arg]) != 0) {
+          return -1;
+        }
+        bt->captures[inst->arg] = offset;
+        pc++;
+      } else if ((inst->op == OP_BOL && at_bol(bt->input, position)) ||
+                 (inst->op == OP_EOL && at_eol(bt->input, position)) ||
+                 (inst->op == OP_BACKREF &&
+                  backref_matches(bt, inst->arg, &offset))) {
+        pc++;
+      } else if (is_consuming(inst->op) && position < bt->input->end &&
+                 inst_matches(guts, inst, (unsigned char)*position)) {
+        offset++;
+        pc++;
+      } else {
+        break;
+      }
+    }
+  }
+  return matched;
+}
+
+static int backtrack_search(const struct re_guts *guts, const Input *input,
+                            regoff_t *result, size_t slots) {
+  Backtracker bt = {guts, input, slots, NULL, NULL, NULL, 0, 0};
+  bt.captures = malloc(slots * sizeof(regoff_t));
+  bt.marks = malloc(guts->program_len * sizeof(regoff_t));
+  int status = -1;
+  if (bt.captures != NULL && bt.marks != NULL) {
+    status = 0;
+    for (const char *position = input->start; position <= input->end;
+         position++) {
+      if (guts->prefix_len > 0) {
+        position = next_candidate(guts, position, input->end);
+        if (position == NULL) {
+          break;
+        }
+      }
+      if (guts->start_needs_bol && !at_bol(input, position)) {
+        continue;
+      }
+      status = backtrack_at(&bt, position, result);
+      if (status != 0) {
+        break;
+      }
+    }
+  }
+  free(bt.captures);
+  free(bt.marks);
+  free(bt.choices);
+  return status;
+}
+
+int regexec(const regex_t *restrict preg, const char *restrict string,
+            size_t nmatch, regmatch_t pmatch[restrict], int eflags) {
+  if (preg == NULL || preg->re_magic != REGEX_MAGIC || string == NULL) {
+    return REG_BADPAT;
+  }
+  struct re_guts *guts = preg->re_g;
+  Input input = {string, string, NULL, guts->cflags, eflags};
+  if (eflags & REG_STARTEND) {
+    input.start = string + pmatch[0].rm_so;
+    input.end = string + pmatch[0].rm_eo;
+  } else {
+    input.end = string + strlen(string);
+  }
+  if (guts->cflags & REG_NOSUB) {
+    nmatch = 0;
+  }
+  if (!guts->has_backrefs) {
+    // the dfa rejects inputs without a match before submatches are tracked
+    int found = dfa_search(guts, &input);
+    if (found == 0) {
+      return REG_NOMATCH;
+    }
+    if (found == 1 && nmatch == 0) {
+      return 0;
+    }
+  }
+  size_t slots = 2 * (preg->re_nsub + 1);
+  regoff_t *captures = malloc(slots * sizeof(regoff_t));
+  if (captures == NULL) {
+    return REG_ESPACE;
+  }
+  int found = guts->has_backrefs
+                  ? backtrack_search(guts, &input, captures, slots)
+                  : pike_search(guts, &input, captures, slots);
+  if (found <= 0) {
+    free(captures);
+    return found == 0 ? REG_NOMATCH : REG_ESPACE;
+  }
+  for (size_t index = 0; index < nmatch; index++) {
+    if (index <= preg->re_nsub && captures[2 * index] >= 0 &&
+        captures[2 * index + 1] >= 0) {
+      pmatch[index].rm_so = captures[2 * index];
+      pmatch[index].rm_eo = captures[2 * index + 1];
+    } else {
+      pmatch[index].rm_so = -1;
+      pmatch[index].rm_eo = -1;
+    }
+  }
+  free(captures);
+  return 0;
+}
@@ -1,14 +1,15 @@
 #include <errno.h>
-#include <fnmatch.h>
-#include <iconv.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <malloc.h>
 #include <pwd.h>
-#include <regex.h>
 #include <setjmp.h>
 #include <spawn.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <sys/signal.h>
 #include <sys/stat.h>
@@ -32,6 +33,15 @@ extern int main(int argc, char *argv[]);
 extern void __libc_init_array();
 extern void __libc_fini_array();
 
+// phases of the run as numbered in enum dandelion_phase of the runtime
+#define PHASE_FS_INIT 1
+#define PHASE_CONSTRUCTORS 2
+#define PHASE_MAIN 3
+#define PHASE_DESTRUCTORS 4
+#define PHASE_CLOSE_FILES 5
+#define PHASE_FS_TERMINATE 6
+extern void dandelion_mark_phase(int phase);
+
 static inline int process_error(int error) {
   if (error < 0) {
     errno = -error;
@@ -41,18 +51,41 @@ static inline int process_error(int error) {
   }
 }
 
+// without a TTY stdout is fully buffered with a buffer matching the block
+// size of its file, so output is written in few large writes
+// stderr stays unbuffered, so messages written right before abort are kept
+static void setup_stdout_buffer(void) {
+  int file = fileno(stdout);
+  if (isatty(file)) {
+    return;
+  }
+  struct stat st;
+  size_t size = BUFSIZ;
+  if (fstat(file, &st) == 0 && st.st_blksize > 0) {
+    size = st.st_blksize;
+  }
+  setvbuf(stdout, NULL, _IOFBF, size);
+}
+
 int __initialization() {
   int errcode = 0;
   int argc;
   char **argv;
+  dandelion_mark_phase(PHASE_FS_INIT);
   errcode = fs_initialize(&argc, &argv, &environ);
   if (errcode != 0) {
     return errcode;
   }
+  setup_stdout_buffer();
+  dandelion_mark_phase(PHASE_CONSTRUCTORS);
   __libc_init_array();
+  dandelion_mark_phase(PHASE_MAIN);
   errcode = main(argc, argv);
+  dandelion_mark_phase(PHASE_DESTRUCTORS);
   __libc_fini_array();
+  dandelion_mark_phase(PHASE_CLOSE_FILES);
   fcloseall();
+  dandelion_mark_phase(PHASE_FS_TERMINATE);
   fs_terminate();
   return errcode;
 }
@@ -61,6 +94,7 @@ int __initialization() {
 DANDELION_ENTRY(__initialization)
 
 void _exit(int __status) {
+  dandelion_mark_phase(PHASE_FS_TERMINATE);
   fs_terminate();
   dandelion_exit(errno);
   __builtin_unreachable();
@@ -90,6 +124,27 @@ int rmdir(const char *pathname) {
 extern int dandelion_close(int file);
 int close(int file) { return process_error(dandelion_close(file)); }
 
+extern int dandelion_pipe(int fds[2]);
+int pipe(int pipefd[2]) { return process_error(dandelion_pipe(pipefd)); }
+
+extern int dandelion_fcntl(int file, int command, int argument);
+int fcntl(int fd, int op, ...) {
+  // all supported commands take an int argument or none at all
+  va_list args;
+  va_start(args, op);
+  int argument = 0;
+  switch (op) {
+  case F_DUPFD:
+  case F_DUPFD_CLOEXEC:
+  case F_SETFD:
+  case F_SETFL:
+    argument = va_arg(args, int);
+    break;
+  }
+  va_end(args);
+  return process_error(dandelion_fcntl(fd, op, argument));
+}
+
 extern int dandelion_link(const char *old, const char *new);
 int link(const char *__path1, const char *__path2) {
   return process_error(dandelion_link(__path1, __path2));
@@ -100,6 +155,23 @@ int unlink(const char *__path) {
   return process_error(dandelion_unlink(__path));
 }
 
+// newlib is configured with HAVE_RENAME, so rename goes through _rename_r to
+// here instead of emulating it with link and unlink
+extern int dandelion_renameat(int old_dirfd, const char *old, int new_dirfd,
+                              const char *new_name);
+int _rename(const char *old, const char *new_name) {
+  return process_error(dandelion_renameat(AT_FDCWD, old, AT_FDCWD, new_name));
+}
+int renameat(int old_dirfd, const char *old, int new_dirfd,
+             const char *new_name) {
+  return process_error(dandelion_renameat(old_dirfd, old, new_dirfd, new_name));
+}
+
+extern int dandelion_publish(const char *name);
+int dandelion_publish_file(const char *path) {
+  return process_error(dandelion_publish(path));
+}
+
 extern int64_t dandelion_lseek(int file, int64_t ptr, int whence);
 off_t lseek(int __fildes, off_t __offset, int __whence) {
   return process_error(dandelion_lseek(__fildes, __offset, __whence));
@@ -219,13 +291,6 @@ int execve(const char *name, char *const argv[], char *const env[]) {
   return -1;
 }
 
-int fcntl(int fd, int op, ...) {
-  (void)fd;
-  (void)op;
-  errno = ENOSYS;
-  return -1;
-}
-
 void siglongjmp(sigjmp_buf env, int val) {
   (void)env;
   (void)val;
@@ -255,23 +320,135 @@ int clearenv(void) {
   return -1;
 }
 
+extern const char *dandelion_find_byte(const char *data, size_t len,
+                                       char byte);
+extern int64_t dandelion_read_view(int file, const char **data);
+extern int dandelion_read_advance(int file, size_t len);
+extern _READ_WRITE_RETURN_TYPE __sread(struct _reent *ptr, void *cookie,
+                                       char *buf, _READ_WRITE_BUFSIZE_TYPE n);
+
+// append to the line, keeping space for the terminating null byte
+static int line_append(char **lineptr, size_t *n, size_t len, const char *data,
+                       size_t count) {
+  if (len + count + 1 > *n) {
+    size_t new_size = *n < 64 ? 128 : 2 * *n;
+    if (new_size < len + count + 1) {
+      new_size = len + count + 1;
+    }
+    char *line = realloc(*lineptr, new_size);
+    if (line == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    *lineptr = line;
+    *n = new_size;
+  }
+  memcpy(*lineptr + len, data, count);
+  return 0;
+}
+
+// streams reading from a file system file without anything buffered can take
+// the line directly from the file chunks instead of copying them through the
+// stream buffer first
+static int64_t stream_file_view(FILE *stream, const char **data) {
+  if (stream->_r > 0 || stream->_ub._base != NULL ||
+      (stream->_flags & (__SRD | __SEOF | __SERR)) != __SRD ||
+      stream->_read != __sread) {
+    return -1;
+  }
+  return dandelion_read_view(stream->_file, data);
+}
+
 ssize_t getdelim(char **restrict lineptr, size_t *restrict n, int delimiter,
                  FILE *restrict stream) {
-  (void)lineptr;
-  (void)n;
-  (void)delimiter;
-  (void)stream;
-  errno = ENOSYS;
-  return -1;
+  if (lineptr == NULL || n == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (*lineptr == NULL) {
+    *n = 0;
+  }
+  char delimiter_byte = (char)delimiter;
+  size_t len = 0;
+  int error = 0;
+  flockfile(stream);
+  const char *data;
+  int64_t available = stream_file_view(stream, &data);
+  if (available >= 0) {
+    while (1) {
+      if (available <= 0) {
+        if (available == 0) {
+          stream->_flags |= __SEOF;
+        } else {
+          stream->_flags |= __SERR;
+          errno = -available;
+          error = 1;
+        }
+        break;
+      }
+      const char *found = dandelion_find_byte(data, available, delimiter_byte);
+      size_t count = found == NULL ? (size_t)available : found - data + 1;
+      if (line_append(lineptr, n, len, data, count) != 0) {
+        error = 1;
+        break;
+      }
+      len += count;
+      dandelion_read_advance(stream->_file, count);
+      if (stream->_flags & __SOFF) {
+        stream->_offset += count;
+      }
+      if (found != NULL) {
+        break;
+      }
+      available = dandelion_read_view(stream->_file, &data);
+    }
+  } else {
+    // scan the bytes in the stream buffer, refilling it when it runs empty
+    while (1) {
+      if (stream->_r <= 0) {
+        int next = __srget_r(_REENT, stream);
+        if (next == EOF) {
+          break;
+        }
+        char byte = (char)next;
+        if (line_append(lineptr, n, len, &byte, 1) != 0) {
+          error = 1;
+          break;
+        }
+        len++;
+        if (byte == delimiter_byte) {
+          break;
+        }
+        continue;
+      }
+      const char *buffered = (const char *)stream->_p;
+      const char *found =
+          dandelion_find_byte(buffered, stream->_r, delimiter_byte);
+      size_t count = found == NULL ? (size_t)stream->_r : found - buffered + 1;
+      if (line_append(lineptr, n, len, buffered, count) != 0) {
+        error = 1;
+        break;
+      }
+      len += count;
+      stream->_p += count;
+      stream->_r -= count;
+      if (found != NULL) {
+        break;
+      }
+    }
+  }
+  funlockfile(stream);
+  // the stream keeps the error and end of file flags for the caller
+  if (error || len == 0) {
+    return -1;
+  }
+  (*lineptr)[len] = '\0';
+  return len;
 }
 
 ssize_t getline(char **restrict lineptr, size_t *restrict n,
                 FILE *restrict stream) {
-  (void)lineptr;
-  (void)n;
-  (void)stream;
-  errno = ENOSYS;
-  return -1;
+  return getdelim(lineptr, n, '\n', stream);
 }
 
 int fork() {
@@ -314,39 +491,6 @@ uid_t geteuid(void) {
   return 0;
 }
 
-int fnmatch(const char *pattern, const char *string, int flags) {
-  (void)pattern;
-  (void)string;
-  (void)flags;
-  errno = ENOSYS;
-  return FNM_NOMATCH;
-}
-
-iconv_t iconv_open(const char *tocode, const char *fromcode) {
-  (void)tocode;
-  (void)fromcode;
-  errno = ENOSYS;
-  return (iconv_t)-1;
-}
-
-size_t iconv(iconv_t cd, char **__restrict inbuf,
-             size_t *__restrict inbytesleft, char **__restrict outbuf,
-             size_t *__restrict outbytesleft) {
-  (void)cd;
-  (void)inbuf;
-  (void)inbytesleft;
-  (void)outbuf;
-  (void)outbytesleft;
-  errno = ENOSYS;
-  return (size_t)-1;
-}
-
-int iconv_close(iconv_t cd) {
-  (void)cd;
-  errno = ENOSYS;
-  return -1;
-}
-
 FILE *popen(const char *command, const char *type) {
   (void)command;
   (void)type;
@@ -427,12 +571,14 @@ char *setstate(char *state) {
   return NULL;
 }
 
+// same clock as clock_gettime with CLOCK_REALTIME
+extern uint64_t dandelion_realtime_ns(void);
 time_t time(time_t *timer) {
-  errno = ENOSYS;
+  time_t seconds = dandelion_realtime_ns() / 1000000000;
   if (timer != NULL) {
-    *timer = (time_t)-1;
+    *timer = seconds;
   }
-  return (time_t)-1;
+  return seconds;
 }
 
 int futimens(int fd, const struct timespec times[2]) {
@@ -465,41 +611,6 @@ int getpwnam_r(const char *name, struct passwd *pwd, char *buffer,
   return ENOSYS;
 }
 
-int regcomp(regex_t *restrict preg, const char *restrict pattern, int cflags) {
-  (void)preg;
-  (void)pattern;
-  (void)cflags;
-  errno = ENOSYS;
-  return REG_BADPAT;
-}
-
-size_t regerror(int errcode, const regex_t *restrict preg,
-                char *restrict errbuf, size_t errbuf_size) {
-  (void)errcode;
-  (void)preg;
-  if (errbuf != NULL && errbuf_size != 0) {
-    errbuf[0] = '\0';
-  }
-  errno = ENOSYS;
-  return 0;
-}
-
-int regexec(const regex_t *restrict preg, const char *restrict string,
-            size_t nmatch, regmatch_t pmatch[restrict], int eflags) {
-  (void)preg;
-  (void)string;
-  (void)nmatch;
-  (void)pmatch;
-  (void)eflags;
-  errno = ENOSYS;
-  return REG_NOMATCH;
-}
-
-void regfree(regex_t *preg) {
-  (void)preg;
-  errno = ENOSYS;
-}
-
 pid_t waitpid(pid_t pid, int *status, int options) {
   (void)pid;
   (void)status;
@@ -539,10 +650,14 @@ int getrusage(int who, struct rusage *usage) {
 }
 
 int gettimeofday(struct timeval *restrict p, void *restrict tz) {
-  (void)p;
+  // there are no time zones, the obsolete tz argument is ignored
   (void)tz;
-  errno = ENOSYS;
-  return -1;
+  if (p != NULL) {
+    uint64_t nanoseconds = dandelion_realtime_ns();
+    p->tv_sec = nanoseconds / 1000000000;
+    p->tv_usec = nanoseconds % 1000000000 / 1000;
+  }
+  return 0;
 }
 
 int kill(int pid, int sig) {
@@ -550,11 +665,6 @@ int kill(int pid, int sig) {
   return -1;
 }
 
-int pipe(int pipefd[2]) {
-  errno = EFAULT;
-  return -1;
-}
-
 int posix_openpt(int flags) {
   (void)flags;
   errno = ENOSYS;
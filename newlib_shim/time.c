@@ -6,26 +6,24 @@
 #define _POSIX_MONOTONIC_CLOCK
 #define __GNU_VISIBLE 0
 #include <errno.h>
+#include <stdint.h>
 #include <sys/reent.h>
 #include <time.h>
 #undef errno
 extern int errno;
 
-#if defined(__aarch64__)
-static uint64_t __rdtsc() {
-  uint64_t t;
-  __asm volatile("mrs %0, cntvct_el0" : "=r"(t));
-  return t;
-}
-#elif defined(__x86_64__)
-static uint64_t __rdtsc() {
-  uint64_t t;
-  __asm volatile("rdtsc" : "=A"(t));
-  return t;
+// clocks read straight from the counter, scaled by the frequency the
+// platform published
+extern uint64_t dandelion_monotonic_ns(void);
+extern uint64_t dandelion_realtime_ns(void);
+extern uint64_t dandelion_clock_resolution_ns(void);
+
+#define NANOSECONDS_PER_SECOND 1000000000
+
+static void to_timespec(uint64_t nanoseconds, struct timespec *tp) {
+  tp->tv_sec = nanoseconds / NANOSECONDS_PER_SECOND;
+  tp->tv_nsec = nanoseconds % NANOSECONDS_PER_SECOND;
 }
-#else
-#error "Unsupported architecture"
-#endif
 
 static int dandelion_getdate_err;
 
@@ -51,25 +49,44 @@ int clock_settime(clockid_t clock_id, const struct timespec *tp) {
   return -1;
 }
 int clock_gettime(clockid_t clock_id, struct timespec *tp) {
-  // TODO add static timestamp at the start to offset here and possibly fix to
-  // get actual realtime instead of offset one
-  // TODO check if we need to differentiate any of these and if they need setup
-  // from the dandelion side
-  static char is_initialized = 0;
-  static uint64_t base_time;
-  if (is_initialized == 0) {
-    base_time = __rdtsc();
-    is_initialized = 1;
+  switch (clock_id) {
+  case CLOCK_REALTIME:
+    to_timespec(dandelion_realtime_ns(), tp);
+    return 0;
+  // functions run single threaded from start to exit, so the time they spent
+  // on the CPU is the time since they started
+  case CLOCK_MONOTONIC:
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+  case CLOCK_PROCESS_CPUTIME_ID:
+#endif
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  case CLOCK_THREAD_CPUTIME_ID:
+#endif
+    to_timespec(dandelion_monotonic_ns(), tp);
+    return 0;
+  default:
+    errno = EINVAL;
+    return -1;
   }
-  uint64_t time_diff = __rdtsc() - base_time;
-  uint64_t divisor = 1000000000;
-  tp->tv_nsec = time_diff % divisor;
-  tp->tv_sec = time_diff / divisor;
-  return 0;
 }
 int clock_getres(clockid_t clock_id, struct timespec *res) {
-  errno = EINVAL;
-  return -1;
+  switch (clock_id) {
+  case CLOCK_REALTIME:
+  case CLOCK_MONOTONIC:
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+  case CLOCK_PROCESS_CPUTIME_ID:
+#endif
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  case CLOCK_THREAD_CPUTIME_ID:
+#endif
+    if (res != NULL) {
+      to_timespec(dandelion_clock_resolution_ns(), res);
+    }
+    return 0;
+  default:
+    errno = EINVAL;
+    return -1;
+  }
 }
 
 /* Create a Per-Process Timer, P1003.1b-1993, p. 264 */
@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 // Implement functions from unistd that are not already defined in other parts
@@ -42,15 +43,37 @@ int daemon(int nochdir, int noclose) {
 // function to duplicate file descriptor to second file number
 // the filedescriptors should act as one, meaning if seek is called on one of
 // them, the effects should also be visible accessing the file through the new
-// one. if the second parameter is -1, the lowest free file descriptor is
-// chosen, otherwise the file descriptor in filedes2 is used to duplicate the
-// filedescriptor. If filedes2 was open before, it will be closed.
+// one. dup chooses the lowest free file descriptor, dup2 and dup3 use the one
+// in filedes2, closing it if it was open before.
+extern int dandelion_dup(int file, int min_file, int flags);
+extern int dandelion_dup2(int file, int new_file, int flags);
+static int dup_to(int __fildes, int __fildes2, int descriptor_flags,
+                  char lowest_free) {
+  int result;
+  if (lowest_free) {
+    result = dandelion_dup(__fildes, 0, descriptor_flags);
+  } else if (__fildes2 < 0) {
+    result = -EBADF;
+  } else {
+    result = dandelion_dup2(__fildes, __fildes2, descriptor_flags);
+  }
+  if (result < 0) {
+    *__errno() = -result;
+    return -1;
+  }
+  return result;
+}
 int dup3(int __fildes, int __fildes2, int flags) {
-  *__errno() = EMFILE;
-  return -1;
+  if (__fildes == __fildes2 || (flags & ~O_CLOEXEC) != 0) {
+    *__errno() = EINVAL;
+    return -1;
+  }
+  return dup_to(__fildes, __fildes2, flags & O_CLOEXEC ? FD_CLOEXEC : 0, 0);
+}
+int dup2(int __fildes, int __fildes2) {
+  return dup_to(__fildes, __fildes2, 0, 0);
 }
-int dup2(int __fildes, int __fildes2) { return dup3(__fildes, __fildes2, 0); }
-int dup(int __fildes) { return dup3(__fildes, -1, 0); }
+int dup(int __fildes) { return dup_to(__fildes, 0, 0, 1); }
 
 int eaccess(const char *__path, int __mode) { return access(__path, __mode); }
 int euidaccess(const char *__path, int __mode) {
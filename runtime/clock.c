@@ -0,0 +1,131 @@
+#include <stdint.h>
+
+#include "../include/dandelion/runtime.h"
+#include "../include/dandelion/system/system.h"
+#include "runtime.h"
+
+#define sysdata __dandelion_system_data
+
+#define NANOSECONDS_PER_SECOND 1000000000ull
+// fractional bits of the tick to nanosecond factor
+#define CLOCK_SHIFT 32
+
+void reset_clock(void) {
+  rtdata.clock_base = sysdata.clock_base;
+  if (rtdata.clock_base == 0) {
+    rtdata.clock_base = __dandelion_read_ticks();
+  }
+  // precompute the factor so reading the clock needs no division, the error
+  // from rounding it is below a nanosecond per second
+  if (sysdata.clock_frequency == 0) {
+    rtdata.clock_mult = 1ull << CLOCK_SHIFT;
+  } else {
+    rtdata.clock_mult =
+        (NANOSECONDS_PER_SECOND << CLOCK_SHIFT) / sysdata.clock_frequency;
+  }
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks) {
+  unsigned __int128 scaled = (unsigned __int128)ticks * rtdata.clock_mult;
+  return (uint64_t)(scaled >> CLOCK_SHIFT);
+}
+
+uint64_t dandelion_ticks(void) { return __dandelion_read_ticks(); }
+
+uint64_t dandelion_tick_frequency(void) { return sysdata.clock_frequency; }
+
+uint64_t dandelion_monotonic_ns(void) {
+  uint64_t ticks = __dandelion_read_ticks();
+  // counters of different cores may be slightly apart, never go below the base
+  if (ticks < rtdata.clock_base) {
+    return 0;
+  }
+  return ticks_to_ns(ticks - rtdata.clock_base);
+}
+
+uint64_t dandelion_realtime_ns(void) {
+  return sysdata.realtime_base + dandelion_monotonic_ns();
+}
+
+uint64_t dandelion_clock_resolution_ns(void) {
+  uint64_t frequency = sysdata.clock_frequency;
+  if (frequency == 0 || frequency >= NANOSECONDS_PER_SECOND) {
+    return 1;
+  }
+  return (NANOSECONDS_PER_SECOND + frequency - 1) / frequency;
+}
+
+void reset_phases(void) {
+  for (size_t phase = 0; phase < DANDELION_PHASE_COUNT; phase++) {
+    sysdata.phase_ticks[phase] = 0;
+  }
+}
+
+void dandelion_mark_phase(int phase) {
+  if (phase < 0 || phase >= DANDELION_PHASE_COUNT) {
+    return;
+  }
+  sysdata.phase_ticks[phase] = __dandelion_read_ticks();
+}
+
+static char *append_string(char *end, const char *string) {
+  while (*string != '\0') {
+    *end++ = *string++;
+  }
+  return end;
+}
+
+static char *append_number(char *end, uint64_t value) {
+  char digits[20];
+  size_t length = 0;
+  do {
+    digits[length++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  while (length != 0) {
+    *end++ = digits[--length];
+  }
+  return end;
+}
+
+void add_phase_output(void) {
+  size_t set_idx = 0;
+  size_t name_len = sizeof(DANDELION_PHASE_SET) - 1;
+  for (; set_idx < sysdata.output_sets_len; set_idx++) {
+    struct io_set_info *set = &sysdata.output_sets[set_idx];
+    if (set->ident_len == name_len &&
+        __builtin_memcmp(set->ident, DANDELION_PHASE_SET, name_len) == 0) {
+      break;
+    }
+  }
+  if (set_idx == sysdata.output_sets_len) {
+    return;
+  }
+  // the item covers the run up to here, the platform sees the final end
+  dandelion_mark_phase(DANDELION_PHASE_END);
+  // a line with name and nanoseconds for each phase that was reached
+  char text[DANDELION_PHASE_COUNT * 48];
+  char *end = text;
+  for (size_t phase = 0; phase < DANDELION_PHASE_END; phase++) {
+    uint64_t start = sysdata.phase_ticks[phase];
+    if (start == 0) {
+      continue;
+    }
+    size_t next = phase + 1;
+    while (sysdata.phase_ticks[next] == 0) {
+      next++;
+    }
+    // phases marked out of order have no meaningful duration
+    if (sysdata.phase_ticks[next] < start) {
+      continue;
+    }
+    end = append_string(end, __dandelion_phase_name(phase));
+    *end++ = ' ';
+    end = append_number(end, ticks_to_ns(sysdata.phase_ticks[next] - start));
+    *end++ = '\n';
+  }
+  char *data = dandelion_alloc_output(set_idx, "phases", 6, end - text);
+  if (data != NULL) {
+    __builtin_memcpy(data, text, end - text);
+  }
+}
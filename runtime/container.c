@@ -0,0 +1,154 @@
+#include "../include/dandelion/container.h"
+
+#include "../include/dandelion/runtime.h"
+#include "runtime.h"
+
+static inline uint32_t read_u32(const char *data) {
+  uint32_t value;
+  __builtin_memcpy(&value, data, 4);
+  return value;
+}
+
+static inline void write_u32(char *data, uint32_t value) {
+  __builtin_memcpy(data, &value, 4);
+}
+
+static inline void write_u64(char *data, uint64_t value) {
+  __builtin_memcpy(data, &value, 8);
+}
+
+int dandelion_container_open(DandelionContainer *container, const void *data,
+                             size_t data_len) {
+  const char *bytes = data;
+  if (data_len < DANDELION_CONTAINER_HEADER_SIZE ||
+      read_u32(bytes) != DANDELION_CONTAINER_MAGIC ||
+      read_u32(bytes + 4) != DANDELION_CONTAINER_VERSION) {
+    return -1;
+  }
+  uint64_t record_count = dandelion_container_offset(bytes + 8, 0);
+  // reject counts where the index alone would not fit
+  if (record_count >= (data_len - DANDELION_CONTAINER_HEADER_SIZE) / 8) {
+    return -1;
+  }
+  size_t index_size = dandelion_container_index_size(record_count);
+  const char *offsets = bytes + DANDELION_CONTAINER_HEADER_SIZE;
+  // offsets need to be in order and stay within the payload, after this
+  // check records can be accessed without any further bounds checks
+  uint64_t previous = 0;
+  for (size_t index = 0; index <= record_count; index++) {
+    uint64_t offset = dandelion_container_offset(offsets, index);
+    if (offset < previous) {
+      return -1;
+    }
+    previous = offset;
+  }
+  if (previous > data_len - index_size) {
+    return -1;
+  }
+  container->offsets = offsets;
+  container->payload = bytes + index_size;
+  container->record_count = record_count;
+  return 0;
+}
+
+int dandelion_container_writer_init(DandelionContainerWriter *writer,
+                                    size_t expected_records,
+                                    size_t expected_bytes) {
+  writer->offsets_cap = expected_records + 1;
+  writer->payload_cap = expected_bytes == 0 ? 1 : expected_bytes;
+  writer->offsets = dandelion_alloc(writer->offsets_cap * sizeof(uint64_t),
+                                    _Alignof(uint64_t));
+  writer->payload = dandelion_alloc(writer->payload_cap, 1);
+  writer->record_count = 0;
+  if (writer->offsets == NULL || writer->payload == NULL) {
+    dandelion_container_writer_free(writer);
+    return -1;
+  }
+  writer->offsets[0] = 0;
+  return 0;
+}
+
+void dandelion_container_writer_free(DandelionContainerWriter *writer) {
+  if (writer->offsets != NULL) {
+    dandelion_free(writer->offsets);
+  }
+  if (writer->payload != NULL) {
+    dandelion_free(writer->payload);
+  }
+  writer->offsets = NULL;
+  writer->payload = NULL;
+  writer->offsets_cap = 0;
+  writer->payload_cap = 0;
+  writer->record_count = 0;
+}
+
+int dandelion_container_add(DandelionContainerWriter *writer,
+                            const void *record, size_t length) {
+  size_t payload_len = writer->offsets[writer->record_count];
+  if (writer->record_count + 2 > writer->offsets_cap) {
+    size_t new_cap = 2 * writer->offsets_cap;
+    uint64_t *offsets =
+        dandelion_alloc(new_cap * sizeof(uint64_t), _Alignof(uint64_t));
+    if (offsets == NULL) {
+      return -1;
+    }
+    __builtin_memcpy(offsets, writer->offsets,
+                     (writer->record_count + 1) * sizeof(uint64_t));
+    dandelion_free(writer->offsets);
+    writer->offsets = offsets;
+    writer->offsets_cap = new_cap;
+  }
+  if (payload_len + length > writer->payload_cap) {
+    size_t new_cap = 2 * writer->payload_cap;
+    if (new_cap < payload_len + length) {
+      new_cap = payload_len + length;
+    }
+    char *payload = dandelion_alloc(new_cap, 1);
+    if (payload == NULL) {
+      return -1;
+    }
+    __builtin_memcpy(payload, writer->payload, payload_len);
+    dandelion_free(writer->payload);
+    writer->payload = payload;
+    writer->payload_cap = new_cap;
+  }
+  __builtin_memcpy(writer->payload + payload_len, record, length);
+  writer->record_count++;
+  writer->offsets[writer->record_count] = payload_len + length;
+  return 0;
+}
+
+size_t dandelion_container_size(const DandelionContainerWriter *writer) {
+  return dandelion_container_index_size(writer->record_count) +
+         writer->offsets[writer->record_count];
+}
+
+void dandelion_container_write(const DandelionContainerWriter *writer,
+                               void *destination) {
+  char *bytes = destination;
+  write_u32(bytes, DANDELION_CONTAINER_MAGIC);
+  write_u32(bytes + 4, DANDELION_CONTAINER_VERSION);
+  write_u64(bytes + 8, writer->record_count);
+  size_t offsets_size = (writer->record_count + 1) * sizeof(uint64_t);
+  __builtin_memcpy(bytes + DANDELION_CONTAINER_HEADER_SIZE, writer->offsets,
+                   offsets_size);
+  __builtin_memcpy(bytes + DANDELION_CONTAINER_HEADER_SIZE + offsets_size,
+                   writer->payload, writer->offsets[writer->record_count]);
+}
+
+int dandelion_container_output(const DandelionContainerWriter *writer,
+                               size_t set_idx, const char *ident,
+                               size_t ident_len) {
+  if (reserve_container_output() != 0) {
+    return -1;
+  }
+  void *data = dandelion_alloc_output(set_idx, ident, ident_len,
+                                      dandelion_container_size(writer));
+  if (data == NULL) {
+    return -1;
+  }
+  dandelion_container_write(writer, data);
+  // the platform knows the format without looking at the data
+  add_container_output(set_idx);
+  return 0;
+}
@@ -0,0 +1,288 @@
+#include "../include/dandelion/runtime.h"
+
+#include "../include/dandelion/system/system.h"
+#include "runtime.h"
+
+#define sysdata __dandelion_system_data
+
+// scanning a handful of idents is cheaper than building a table for them
+#define INDEX_MIN_ENTRIES 8
+
+// both io_set_info and IoBuffer start with their ident, so the tables can be
+// built over either array by only knowing the size of an entry
+typedef struct IdentPrefix {
+  const char *ident;
+  size_t ident_len;
+} IdentPrefix;
+
+static inline const IdentPrefix *entry_at(const void *entries, size_t stride,
+                                          size_t index) {
+  return (const IdentPrefix *)((const char *)entries + index * stride);
+}
+
+static inline int ident_equal(const IdentPrefix *entry, const char *name,
+                              size_t name_len) {
+  return entry->ident_len == name_len &&
+         __builtin_memcmp(entry->ident, name, name_len) == 0;
+}
+
+// FNV-1a
+static inline size_t hash_ident(const char *ident, size_t ident_len) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t index = 0; index < ident_len; index++) {
+    hash ^= (unsigned char)ident[index];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// returns 0 on success, on failure the table stays empty
+static int build_table(IdentTable *table, const void *entries, size_t stride,
+                       size_t count) {
+  // keep the load factor at or below one half
+  size_t capacity = 1;
+  while (capacity < 2 * count) {
+    capacity <<= 1;
+  }
+  size_t *slots = dandelion_alloc(capacity * sizeof(size_t), sizeof(size_t));
+  if (slots == NULL) {
+    return -1;
+  }
+  for (size_t slot = 0; slot < capacity; slot++) {
+    slots[slot] = 0;
+  }
+  size_t mask = capacity - 1;
+  for (size_t index = 0; index < count; index++) {
+    const IdentPrefix *entry = entry_at(entries, stride, index);
+    size_t slot = hash_ident(entry->ident, entry->ident_len) & mask;
+    // duplicates keep the first entry
+    while (slots[slot] != 0 &&
+           !ident_equal(entry_at(entries, stride, slots[slot] - 1),
+                        entry->ident, entry->ident_len)) {
+      slot = (slot + 1) & mask;
+    }
+    if (slots[slot] == 0) {
+      slots[slot] = index + 1;
+    }
+  }
+  table->slots = slots;
+  table->mask = mask;
+  return 0;
+}
+
+// without a table the entries are scanned
+static size_t find_entry(IdentTable *table, const void *entries,
+                         size_t stride, size_t count, const char *name,
+                         size_t name_len) {
+  if (table != NULL && table->slots == NULL && !table->failed &&
+      count >= INDEX_MIN_ENTRIES) {
+    table->failed = build_table(table, entries, stride, count) != 0;
+  }
+  if (table == NULL || table->slots == NULL) {
+    for (size_t index = 0; index < count; index++) {
+      if (ident_equal(entry_at(entries, stride, index), name, name_len)) {
+        return index;
+      }
+    }
+    return DANDELION_NOT_FOUND;
+  }
+  size_t slot = hash_ident(name, name_len) & table->mask;
+  for (; table->slots[slot] != 0; slot = (slot + 1) & table->mask) {
+    size_t index = table->slots[slot] - 1;
+    if (ident_equal(entry_at(entries, stride, index), name, name_len)) {
+      return index;
+    }
+  }
+  return DANDELION_NOT_FOUND;
+}
+
+// stable bottom up merge sort by key, runs that are already in order are not
+// merged so sorted sets only cost a pass per level
+static int sort_by_key(IoBuffer **buffers, size_t count) {
+  if (count < 2) {
+    return 0;
+  }
+  IoBuffer **scratch =
+      dandelion_alloc(count * sizeof(IoBuffer *), _Alignof(IoBuffer *));
+  if (scratch == NULL) {
+    return -1;
+  }
+  for (size_t width = 1; width < count; width *= 2) {
+    for (size_t left = 0; left + width < count; left += 2 * width) {
+      size_t middle = left + width;
+      size_t right = middle + width < count ? middle + width : count;
+      if (buffers[middle - 1]->key <= buffers[middle]->key) {
+        continue;
+      }
+      size_t first = left, second = middle, out = left;
+      while (first < middle && second < right) {
+        if (buffers[second]->key < buffers[first]->key) {
+          scratch[out++] = buffers[second++];
+        } else {
+          scratch[out++] = buffers[first++];
+        }
+      }
+      while (first < middle) {
+        scratch[out++] = buffers[first++];
+      }
+      while (second < right) {
+        scratch[out++] = buffers[second++];
+      }
+      for (size_t index = left; index < right; index++) {
+        buffers[index] = scratch[index];
+      }
+    }
+  }
+  dandelion_free(scratch);
+  return 0;
+}
+
+static KeyIndex *get_key_index(size_t set_idx) {
+  if (set_idx >= sysdata.input_sets_len) {
+    return NULL;
+  }
+  if (rtdata.input_key_indexes == NULL) {
+    size_t indexes_size = sysdata.input_sets_len * sizeof(KeyIndex);
+    rtdata.input_key_indexes =
+        dandelion_alloc(indexes_size, _Alignof(KeyIndex));
+    if (rtdata.input_key_indexes == NULL) {
+      return NULL;
+    }
+    for (size_t index = 0; index < sysdata.input_sets_len; index++) {
+      rtdata.input_key_indexes[index].sorted = NULL;
+      rtdata.input_key_indexes[index].group_starts = NULL;
+      rtdata.input_key_indexes[index].groups = 0;
+    }
+  }
+  KeyIndex *key_index = &rtdata.input_key_indexes[set_idx];
+  IoBuffer *buffers = input_set_buffers(set_idx);
+  size_t buffers_len = input_set_length(set_idx);
+  if (key_index->group_starts != NULL || buffers_len == 0) {
+    return key_index;
+  }
+  IoBuffer **sorted = dandelion_alloc(buffers_len * sizeof(IoBuffer *),
+                                      _Alignof(IoBuffer *));
+  if (sorted == NULL) {
+    return NULL;
+  }
+  for (size_t index = 0; index < buffers_len; index++) {
+    sorted[index] = &buffers[index];
+  }
+  if (sort_by_key(sorted, buffers_len) != 0) {
+    dandelion_free(sorted);
+    return NULL;
+  }
+  size_t groups = 1;
+  for (size_t index = 1; index < buffers_len; index++) {
+    groups += sorted[index - 1]->key != sorted[index]->key;
+  }
+  size_t *group_starts =
+      dandelion_alloc((groups + 1) * sizeof(size_t), _Alignof(size_t));
+  if (group_starts == NULL) {
+    dandelion_free(sorted);
+    return NULL;
+  }
+  size_t group = 0;
+  group_starts[group++] = 0;
+  for (size_t index = 1; index < buffers_len; index++) {
+    if (sorted[index - 1]->key != sorted[index]->key) {
+      group_starts[group++] = index;
+    }
+  }
+  group_starts[groups] = buffers_len;
+  key_index->sorted = sorted;
+  key_index->group_starts = group_starts;
+  key_index->groups = groups;
+  return key_index;
+}
+
+void reset_input_indexes(void) {
+  rtdata.input_set_table.slots = NULL;
+  rtdata.input_set_table.mask = 0;
+  rtdata.input_set_table.failed = 0;
+  rtdata.input_item_tables = NULL;
+  rtdata.input_item_tables_failed = 0;
+  rtdata.input_key_indexes = NULL;
+}
+
+size_t dandelion_find_input_set(const char *name, size_t name_len) {
+  return find_entry(&rtdata.input_set_table, sysdata.input_sets,
+                    sizeof(struct io_set_info), sysdata.input_sets_len, name,
+                    name_len);
+}
+
+IoBuffer *dandelion_find_input(size_t set_idx, const char *name,
+                               size_t name_len) {
+  if (set_idx >= sysdata.input_sets_len) {
+    return NULL;
+  }
+  if (rtdata.input_item_tables == NULL && !rtdata.input_item_tables_failed) {
+    size_t tables_size = sysdata.input_sets_len * sizeof(IdentTable);
+    rtdata.input_item_tables =
+        dandelion_alloc(tables_size, _Alignof(IdentTable));
+    rtdata.input_item_tables_failed = rtdata.input_item_tables == NULL;
+    for (size_t index = 0;
+         rtdata.input_item_tables != NULL && index < sysdata.input_sets_len;
+         index++) {
+      rtdata.input_item_tables[index].slots = NULL;
+      rtdata.input_item_tables[index].mask = 0;
+      rtdata.input_item_tables[index].failed = 0;
+    }
+  }
+  IoBuffer *buffers = input_set_buffers(set_idx);
+  IdentTable *table = rtdata.input_item_tables == NULL
+                          ? NULL
+                          : &rtdata.input_item_tables[set_idx];
+  size_t index = find_entry(table, buffers, sizeof(IoBuffer),
+                            input_set_length(set_idx), name, name_len);
+  if (index == DANDELION_NOT_FOUND) {
+    return NULL;
+  }
+  return &buffers[index];
+}
+
+size_t dandelion_input_key_count(size_t set_idx) {
+  KeyIndex *key_index = get_key_index(set_idx);
+  if (key_index == NULL) {
+    return 0;
+  }
+  return key_index->groups;
+}
+
+IoBuffer *const *dandelion_input_key_group(size_t set_idx, size_t key_idx,
+                                           size_t *count) {
+  *count = 0;
+  KeyIndex *key_index = get_key_index(set_idx);
+  if (key_index == NULL || key_idx >= key_index->groups) {
+    return NULL;
+  }
+  size_t start = key_index->group_starts[key_idx];
+  *count = key_index->group_starts[key_idx + 1] - start;
+  return &key_index->sorted[start];
+}
+
+IoBuffer *const *dandelion_find_inputs_by_key(size_t set_idx, size_t key,
+                                              size_t *count) {
+  *count = 0;
+  KeyIndex *key_index = get_key_index(set_idx);
+  if (key_index == NULL) {
+    return NULL;
+  }
+  // binary search for the group with the key
+  size_t low = 0;
+  size_t high = key_index->groups;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    size_t middle_key = key_index->sorted[key_index->group_starts[middle]]->key;
+    if (middle_key < key) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if (low == key_index->groups ||
+      key_index->sorted[key_index->group_starts[low]]->key != key) {
+    return NULL;
+  }
+  return dandelion_input_key_group(set_idx, low, count);
+}
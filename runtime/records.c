@@ -0,0 +1,191 @@
+#include "../include/dandelion/records.h"
+
+#include <stdint.h>
+
+#include "../include/dandelion/runtime.h"
+#include "vector.h"
+
+#if defined(__SSE2__)
+static inline const char *find_in_block(const char *block, char byte) {
+  byte_vector pattern = {byte, byte, byte, byte, byte, byte, byte, byte,
+                         byte, byte, byte, byte, byte, byte, byte, byte};
+  byte_vector low;
+  byte_vector high;
+  __builtin_memcpy(&low, block, 16);
+  __builtin_memcpy(&high, block + 16, 16);
+  uint32_t mask =
+      (uint32_t)__builtin_ia32_pmovmskb128((byte_vector)(low == pattern)) |
+      (uint32_t)__builtin_ia32_pmovmskb128((byte_vector)(high == pattern))
+          << 16;
+  if (mask == 0) {
+    return NULL;
+  }
+  return block + __builtin_ctz(mask);
+}
+#elif defined(__ARM_NEON)
+static inline const char *find_in_block(const char *block, char byte) {
+  uint8x16_t pattern = vdupq_n_u8((uint8_t)byte);
+  uint8x16_t low = vceqq_u8(vld1q_u8((const uint8_t *)block), pattern);
+  uint8x16_t high = vceqq_u8(vld1q_u8((const uint8_t *)block + 16), pattern);
+  if (vmaxvq_u8(vorrq_u8(low, high)) == 0) {
+    return NULL;
+  }
+  uint64_t mask = neon_mask(low);
+  if (mask != 0) {
+    return block + __builtin_ctzll(mask) / 4;
+  }
+  return block + 16 + __builtin_ctzll(neon_mask(high)) / 4;
+}
+#else
+// word at a time fallback, a byte of the xor is zero where the byte matches
+static inline const char *find_in_block(const char *block, char byte) {
+  const uint64_t ones = 0x0101010101010101ULL;
+  const uint64_t highs = 0x8080808080808080ULL;
+  uint64_t pattern = ones * (uint8_t)byte;
+  for (size_t offset = 0; offset < BLOCK_SIZE; offset += 8) {
+    uint64_t word;
+    __builtin_memcpy(&word, block + offset, 8);
+    word ^= pattern;
+    if (((word - ones) & ~word & highs) != 0) {
+      for (size_t index = offset; index < offset + 8; index++) {
+        if (block[index] == byte) {
+          return block + index;
+        }
+      }
+    }
+  }
+  return NULL;
+}
+#endif
+
+const char *dandelion_find_byte(const char *data, size_t len, char byte) {
+  const char *end = data + len;
+  // loads are unaligned, so blocks never read past the end of data
+  for (; end - data >= BLOCK_SIZE; data += BLOCK_SIZE) {
+    const char *found = find_in_block(data, byte);
+    if (found != NULL) {
+      return found;
+    }
+  }
+  for (; data < end; data++) {
+    if (*data == byte) {
+      return data;
+    }
+  }
+  return NULL;
+}
+
+void dandelion_records_init(DandelionRecordReader *reader, char delimiter) {
+  reader->data = NULL;
+  reader->end = NULL;
+  reader->carry = NULL;
+  reader->carry_len = 0;
+  reader->carry_cap = 0;
+  reader->carry_returned = 0;
+  reader->delimiter = delimiter;
+}
+
+void dandelion_records_free(DandelionRecordReader *reader) {
+  if (reader->carry != NULL) {
+    dandelion_free(reader->carry);
+  }
+  dandelion_records_init(reader, reader->delimiter);
+}
+
+void dandelion_records_feed(DandelionRecordReader *reader, const void *data,
+                            size_t len) {
+  reader->data = data;
+  reader->end = reader->data + len;
+}
+
+// append to the partial record carried over from previous chunks
+static int carry_append(DandelionRecordReader *reader, const char *data,
+                        size_t len) {
+  if (len == 0) {
+    return 0;
+  }
+  if (reader->carry_len + len > reader->carry_cap) {
+    size_t new_cap = reader->carry_cap == 0 ? 64 : 2 * reader->carry_cap;
+    if (new_cap < reader->carry_len + len) {
+      new_cap = reader->carry_len + len;
+    }
+    char *carry = dandelion_alloc(new_cap, 1);
+    if (carry == NULL) {
+      return -1;
+    }
+    if (reader->carry != NULL) {
+      __builtin_memcpy(carry, reader->carry, reader->carry_len);
+      dandelion_free(reader->carry);
+    }
+    reader->carry = carry;
+    reader->carry_cap = new_cap;
+  }
+  __builtin_memcpy(reader->carry + reader->carry_len, data, len);
+  reader->carry_len += len;
+  return 0;
+}
+
+int dandelion_records_next(DandelionRecordReader *reader, const char **record,
+                           size_t *len) {
+  if (reader->carry_returned) {
+    reader->carry_len = 0;
+    reader->carry_returned = 0;
+  }
+  size_t available = reader->end - reader->data;
+  const char *found =
+      dandelion_find_byte(reader->data, available, reader->delimiter);
+  if (found == NULL) {
+    // the rest of the chunk starts a record that continues in the next one
+    if (carry_append(reader, reader->data, available) != 0) {
+      return -1;
+    }
+    reader->data = reader->end;
+    return 0;
+  }
+  size_t record_len = found - reader->data;
+  if (reader->carry_len == 0) {
+    *record = reader->data;
+    *len = record_len;
+  } else {
+    if (carry_append(reader, reader->data, record_len) != 0) {
+      return -1;
+    }
+    *record = reader->carry;
+    *len = reader->carry_len;
+    reader->carry_returned = 1;
+  }
+  reader->data = found + 1;
+  return 1;
+}
+
+int dandelion_records_finish(DandelionRecordReader *reader,
+                             const char **record, size_t *len) {
+  if (reader->carry_returned || reader->carry_len == 0) {
+    reader->carry_len = 0;
+    reader->carry_returned = 0;
+    return 0;
+  }
+  *record = reader->carry;
+  *len = reader->carry_len;
+  reader->carry_returned = 1;
+  return 1;
+}
+
+void dandelion_split_records(const char *data, size_t len, char delimiter,
+                             size_t ranges, size_t *bounds) {
+  bounds[0] = 0;
+  for (size_t range = 1; range < ranges; range++) {
+    // move the even split point forward to just after the next delimiter
+    size_t position = len / ranges * range + len % ranges * range / ranges;
+    if (position < bounds[range - 1]) {
+      position = bounds[range - 1];
+    }
+    if (position > 0 && data[position - 1] != delimiter) {
+      const char *found =
+          dandelion_find_byte(data + position, len - position, delimiter);
+      position = found == NULL ? len : (size_t)(found - data) + 1;
+    }
+    bounds[range] = position;
+  }
+  bounds[ranges] = len;
+}
@@ -26,6 +26,8 @@ static size_t last_descriptor;
 
 static char TLS[256] = {};
 void dandelion_init(void) {
+  reset_phases();
+  dandelion_mark_phase(DANDELION_PHASE_INIT);
   __dandelion_system_init();
 
   // allocate space for thread local storage
@@ -37,39 +39,11 @@ void dandelion_init(void) {
   alloc_base = 0;
   last_descriptor = 0;
 
-  // parse raw input data into tree structure
-  rtdata.input_sets =
-      dandelion_alloc(sysdata.input_sets_len * sizeof(IoSet), _Alignof(IoSet));
-  if (rtdata.input_sets == NULL && sysdata.input_sets_len != 0) {
-    sysdata.exit_code = DANDELION_OOM;
-    __dandelion_system_exit();
-    return;
-  }
-  for (size_t i = 0; i < sysdata.input_sets_len; ++i) {
-    IoSet *set = &rtdata.input_sets[i];
-    size_t num_bufs =
-        sysdata.input_sets[i + 1].offset - sysdata.input_sets[i].offset;
-    set->ident = sysdata.input_sets[i].ident;
-    set->ident_len = sysdata.input_sets[i].ident_len;
-    set->buffers =
-        dandelion_alloc(num_bufs * sizeof(IoBuffer), _Alignof(IoBuffer));
-    if (set->buffers == NULL && num_bufs != 0) {
-      sysdata.exit_code = DANDELION_OOM;
-      __dandelion_system_exit();
-      return;
-    }
-    set->buffers_len = num_bufs;
-    set->buffers_cap = num_bufs;
-    for (size_t j = 0; j < num_bufs; ++j) {
-      size_t buf_offset = sysdata.input_sets[i].offset + j;
-      set->buffers[j].ident = sysdata.input_bufs[buf_offset].ident;
-      set->buffers[j].ident_len = sysdata.input_bufs[buf_offset].ident_len;
-      set->buffers[j].data = sysdata.input_bufs[buf_offset].data;
-      set->buffers[j].data_len = sysdata.input_bufs[buf_offset].data_len;
-      set->buffers[j].key = sysdata.input_bufs[buf_offset].key;
-    }
-  }
+  reset_input_indexes();
+  reset_clock();
 
+  // input sets are used straight from the platform's buffer array, only
+  // outputs need their own tree structure
   rtdata.output_sets =
       dandelion_alloc(sysdata.output_sets_len * sizeof(IoSet), _Alignof(IoSet));
   if (rtdata.output_sets == NULL && sysdata.output_sets_len != 0) {
@@ -84,44 +58,52 @@ void dandelion_init(void) {
     rtdata.output_sets[i].buffers_len = 0;
     rtdata.output_sets[i].buffers_cap = 0;
   }
+  rtdata.output_arena = NULL;
+  rtdata.output_arena_cap = 0;
+  rtdata.container_outputs = NULL;
+  rtdata.container_outputs_len = 0;
+  rtdata.container_outputs_cap = 0;
+
+  // C libraries move this to main after setting themselves up
+  dandelion_mark_phase(DANDELION_PHASE_MAIN);
 }
 
 void dandelion_exit(int exit_code) {
+  dandelion_mark_phase(DANDELION_PHASE_EXIT);
   sysdata.exit_code = exit_code;
-  // convert tree structure into raw output data
-  size_t num_output_bufs = 0;
-  for (size_t i = 0; i < sysdata.output_sets_len; ++i) {
-    num_output_bufs += rtdata.output_sets[i].buffers_len;
-  }
-
-  sysdata.output_bufs =
-      dandelion_alloc(num_output_bufs * sizeof(IoBuffer), _Alignof(IoBuffer));
-  if (sysdata.output_bufs == NULL && num_output_bufs != 0) {
-    sysdata.exit_code = DANDELION_OOM;
-    __dandelion_system_exit();
-    return;
-  }
-
+  add_phase_output();
+  // the sets already are in order in the arena, only need to close the gaps
+  // left by unused capacity
   size_t current_offset = 0;
   for (size_t i = 0; i < sysdata.output_sets_len; ++i) {
-    sysdata.output_sets[i].offset = current_offset;
-
     IoSet *tree_set = &rtdata.output_sets[i];
-    current_offset += tree_set->buffers_len;
-    for (size_t j = 0; j < tree_set->buffers_len; ++j) {
-      IoBuffer *tree_buf = &tree_set->buffers[j];
-      IoBuffer *raw_buf =
-          &sysdata.output_bufs[sysdata.output_sets[i].offset + j];
-      raw_buf->ident = tree_buf->ident;
-      raw_buf->ident_len = tree_buf->ident_len;
-      raw_buf->data = tree_buf->data;
-      raw_buf->data_len = tree_buf->data_len;
-      raw_buf->key = tree_buf->key;
+    IoBuffer *target = rtdata.output_arena + current_offset;
+    if (tree_set->buffers != target && tree_set->buffers_len != 0) {
+      __builtin_memmove(target, tree_set->buffers,
+                        tree_set->buffers_len * sizeof(IoBuffer));
     }
+    sysdata.output_sets[i].offset = current_offset;
+    current_offset += tree_set->buffers_len;
   }
   // sentinel set output
   sysdata.output_sets[sysdata.output_sets_len].offset = current_offset;
+  sysdata.output_bufs = rtdata.output_arena;
+  // without memory for the flags the containers are handed over as plain data
+  sysdata.output_flags = NULL;
+  if (rtdata.container_outputs_len != 0) {
+    unsigned char *flags = dandelion_alloc(current_offset, 1);
+    if (flags != NULL) {
+      __builtin_memset(flags, 0, current_offset);
+      for (size_t i = 0; i < rtdata.container_outputs_len; ++i) {
+        OutputRef *ref = &rtdata.container_outputs[i];
+        flags[sysdata.output_sets[ref->set_idx].offset + ref->position] |=
+            DANDELION_OUTPUT_CONTAINER;
+      }
+      sysdata.output_flags = flags;
+    }
+  }
 
+  dandelion_mark_phase(DANDELION_PHASE_END);
   __dandelion_system_exit();
 }
 
@@ -248,6 +230,11 @@ void *dandelion_alloc(size_t size, size_t alignment) {
     size_t index_mod = (current + 1) % local_alignment;
     size_t rounding_indices =
         index_mod == 0 ? 0 : local_alignment - (index_mod);
+    // free space too small to even hold the alignment
+    if (end_index < current + rounding_indices + 1) {
+      current = end_index + 1;
+      continue;
+    }
     // need to subtract one as current is occupied
     size_t potential_size = end_index - (current + rounding_indices) - 1;
     if (local_size <= potential_size && potential_size < smallest_size) {
@@ -314,9 +301,9 @@ void *dandelion_alloc(size_t size, size_t alignment) {
       } else {
         // mark as occupied, this is either one or two indices. If it is
         // one we write the same thing to it twice, if it is two we have
-        // an empty free allocation
-        free_root[0] = (actual_start - 1);
-        free_root[actual_start - 1] = 0;
+        // an empty occupied allocation
+        free_root[0] = (actual_start - 1) | OCCUPIED_FLAG;
+        free_root[actual_start - 1] = 0 | OCCUPIED_FLAG;
       }
     } else {
       free_root[start] = actual_start - 1;
@@ -394,21 +381,83 @@ size_t dandelion_input_set_count(void) { return sysdata.input_sets_len; }
 
 size_t dandelion_output_set_count(void) { return sysdata.output_sets_len; }
 
+uint64_t dandelion_random_seed(void) { return sysdata.random_seed; }
+
 size_t dandelion_input_buffer_count(size_t set_idx) {
   if (set_idx >= sysdata.input_sets_len) {
     return 0;
   }
-  return rtdata.input_sets[set_idx].buffers_len;
+  return input_set_length(set_idx);
 }
 
 IoBuffer *dandelion_get_input(size_t set_idx, size_t buf_idx) {
   if (set_idx >= sysdata.input_sets_len) {
     return NULL;
   }
-  if (buf_idx >= rtdata.input_sets[set_idx].buffers_len) {
+  if (buf_idx >= input_set_length(set_idx)) {
     return NULL;
   }
-  return &rtdata.input_sets[set_idx].buffers[buf_idx];
+  return &input_set_buffers(set_idx)[buf_idx];
+}
+
+// The buffers of all output sets live in one arena, each set owning a segment
+// of buffers_cap entries right after the segment of the previous set. Growing
+// a set shifts the segments of the following sets back, or moves everything
+// into a larger arena once the arena is full.
+static int grow_output_set(IoSet *set, size_t new_cap) {
+  size_t set_idx = set - rtdata.output_sets;
+  size_t extra = new_cap - set->buffers_cap;
+  size_t used_cap = 0;
+  for (size_t i = 0; i < sysdata.output_sets_len; ++i) {
+    used_cap += rtdata.output_sets[i].buffers_cap;
+  }
+  if (used_cap + extra > rtdata.output_arena_cap) {
+    size_t arena_cap = 2 * rtdata.output_arena_cap;
+    if (arena_cap < used_cap + extra) {
+      arena_cap = used_cap + extra;
+    }
+    IoBuffer *arena =
+        dandelion_alloc(arena_cap * sizeof(IoBuffer), _Alignof(IoBuffer));
+    if (arena == NULL) {
+      return -1;
+    }
+    IoBuffer *segment = arena;
+    for (size_t i = 0; i < sysdata.output_sets_len; ++i) {
+      IoSet *current = &rtdata.output_sets[i];
+      for (size_t j = 0; j < current->buffers_len; ++j) {
+        segment[j] = current->buffers[j];
+      }
+      current->buffers = segment;
+      segment += current->buffers_cap + (i == set_idx ? extra : 0);
+    }
+    if (rtdata.output_arena != NULL) {
+      dandelion_free(rtdata.output_arena);
+    }
+    rtdata.output_arena = arena;
+    rtdata.output_arena_cap = arena_cap;
+  } else {
+    // move the later sets back, starting with the last one so nothing gets
+    // overwritten before it was moved
+    for (size_t i = sysdata.output_sets_len; i > set_idx + 1; --i) {
+      IoSet *current = &rtdata.output_sets[i - 1];
+      __builtin_memmove(current->buffers + extra, current->buffers,
+                        current->buffers_len * sizeof(IoBuffer));
+      current->buffers += extra;
+    }
+  }
+  set->buffers_cap = new_cap;
+  return 0;
+}
+
+int dandelion_reserve_outputs(size_t set_idx, size_t additional) {
+  if (set_idx >= sysdata.output_sets_len) {
+    return -1;
+  }
+  IoSet *set = &rtdata.output_sets[set_idx];
+  if (set->buffers_cap - set->buffers_len >= additional) {
+    return 0;
+  }
+  return grow_output_set(set, set->buffers_len + additional);
 }
 
 void dandelion_add_output(size_t set_idx, IoBuffer buf) {
@@ -421,17 +470,142 @@ void dandelion_add_output(size_t set_idx, IoBuffer buf) {
     if (new_cap == 0) {
       new_cap = 1;
     }
-    IoBuffer *new_bufs =
-        dandelion_alloc(new_cap * sizeof(IoBuffer), _Alignof(IoBuffer));
-    for (size_t i = 0; i < set->buffers_len; ++i) {
-      new_bufs[i] = set->buffers[i];
+    if (grow_output_set(set, new_cap) != 0) {
+      return;
     }
-    set->buffers = new_bufs;
-    set->buffers_cap = new_cap;
   }
   set->buffers[set->buffers_len++] = buf;
 }
 
+int dandelion_add_outputs(size_t set_idx, const IoBuffer *bufs, size_t n) {
+  if (set_idx >= sysdata.output_sets_len) {
+    return -1;
+  }
+  IoSet *set = &rtdata.output_sets[set_idx];
+  if (set->buffers_cap - set->buffers_len < n) {
+    // keep growth geometric when called repeatedly with small batches
+    size_t new_cap = set->buffers_cap * 2;
+    if (new_cap < set->buffers_len + n) {
+      new_cap = set->buffers_len + n;
+    }
+    if (grow_output_set(set, new_cap) != 0) {
+      return -1;
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    set->buffers[set->buffers_len + i] = bufs[i];
+  }
+  set->buffers_len += n;
+  return 0;
+}
+
+// bump allocation from the output region, NULL if there is none or it is full
+static char *alloc_output_region(size_t size, size_t alignment) {
+  if (sysdata.output_region_begin == 0) {
+    return NULL;
+  }
+  size_t start = sysdata.output_region_begin + sysdata.output_region_used;
+  start = (start + alignment - 1) & ~(alignment - 1);
+  if (start + size > sysdata.output_region_end) {
+    return NULL;
+  }
+  sysdata.output_region_used = start + size - sysdata.output_region_begin;
+  return (char *)start;
+}
+
+void *dandelion_alloc_output(size_t set_idx, const char *ident,
+                             size_t ident_len, size_t size) {
+  if (set_idx >= sysdata.output_sets_len) {
+    return NULL;
+  }
+  // make sure adding the output can not fail after the data is allocated
+  IoSet *set = &rtdata.output_sets[set_idx];
+  if (set->buffers_len == set->buffers_cap) {
+    size_t new_cap = set->buffers_cap == 0 ? 1 : set->buffers_cap * 2;
+    if (grow_output_set(set, new_cap) != 0) {
+      return NULL;
+    }
+  }
+  char *data = alloc_output_region(size + ident_len, _Alignof(max_align_t));
+  if (data == NULL && sysdata.output_region_begin != 0) {
+    return NULL;
+  } else if (data == NULL) {
+    data = dandelion_alloc(size + ident_len, _Alignof(max_align_t));
+    if (data == NULL) {
+      return NULL;
+    }
+  }
+  // the ident goes right after the data
+  char *ident_copy = data + size;
+  for (size_t i = 0; i < ident_len; ++i) {
+    ident_copy[i] = ident[i];
+  }
+  IoBuffer buf = {.ident = ident_copy,
+                  .ident_len = ident_len,
+                  .data = data,
+                  .data_len = size,
+                  .key = 0};
+  set->buffers[set->buffers_len++] = buf;
+  return data;
+}
+
+int reserve_container_output(void) {
+  if (rtdata.container_outputs_len < rtdata.container_outputs_cap) {
+    return 0;
+  }
+  size_t new_cap =
+      rtdata.container_outputs_cap == 0 ? 4 : rtdata.container_outputs_cap * 2;
+  OutputRef *refs =
+      dandelion_alloc(new_cap * sizeof(OutputRef), _Alignof(OutputRef));
+  if (refs == NULL) {
+    return -1;
+  }
+  for (size_t i = 0; i < rtdata.container_outputs_len; ++i) {
+    refs[i] = rtdata.container_outputs[i];
+  }
+  if (rtdata.container_outputs != NULL) {
+    dandelion_free(rtdata.container_outputs);
+  }
+  rtdata.container_outputs = refs;
+  rtdata.container_outputs_cap = new_cap;
+  return 0;
+}
+
+void add_container_output(size_t set_idx) {
+  OutputRef ref = {.set_idx = set_idx,
+                   .position = rtdata.output_sets[set_idx].buffers_len - 1};
+  rtdata.container_outputs[rtdata.container_outputs_len++] = ref;
+}
+
+int dandelion_output_streaming(void) { return sysdata.output_ring != NULL; }
+
+int dandelion_emit_output(size_t set_idx, IoBuffer buf) {
+  if (set_idx >= sysdata.output_sets_len) {
+    return -1;
+  }
+  if (sysdata.output_ring != NULL) {
+    // give the platform a chance to drain a full ring
+    if (sysdata.output_ring_head - sysdata.output_ring_tail ==
+        sysdata.output_ring_len) {
+      __dandelion_system_publish();
+    }
+    size_t head = sysdata.output_ring_head;
+    if (head - sysdata.output_ring_tail < sysdata.output_ring_len) {
+      struct io_stream_entry *entry =
+          &sysdata.output_ring[head & (sysdata.output_ring_len - 1)];
+      entry->set_index = set_idx;
+      entry->buffer = buf;
+      // entry needs to be complete before the platform can see it
+      __atomic_store_n(&sysdata.output_ring_head, head + 1, __ATOMIC_RELEASE);
+      __dandelion_system_publish();
+      return 0;
+    }
+  }
+  // no streaming or the ring stayed full, hand it over at exit instead
+  dandelion_add_output(set_idx, buf);
+  return 0;
+}
+
 size_t dandelion_output_buffer_count(size_t set_idx) {
   if (set_idx >= sysdata.output_sets_len) {
     return 0;
@@ -443,14 +617,14 @@ const char *dandelion_input_set_ident(size_t set_idx) {
   if (set_idx >= sysdata.input_sets_len) {
     return NULL;
   }
-  return rtdata.input_sets[set_idx].ident;
+  return sysdata.input_sets[set_idx].ident;
 }
 
 size_t dandelion_input_set_ident_len(size_t set_idx) {
   if (set_idx >= sysdata.input_sets_len) {
     return 0;
   }
-  return rtdata.input_sets[set_idx].ident_len;
+  return sysdata.input_sets[set_idx].ident_len;
 }
 
 const char *dandelion_output_set_ident(size_t set_idx) {
@@ -15,10 +15,74 @@ typedef struct IoSet {
   size_t buffers_cap;
 } IoSet;
 
+// open addressing hash table over idents, slots hold the index of the entry
+// plus one so zero marks an empty slot
+typedef struct IdentTable {
+  size_t *slots;
+  size_t mask;
+  // set when the slots could not be allocated, lookups scan from then on
+  char failed;
+} IdentTable;
+
+// buffers of a set ordered by key, keeping the set order for equal keys
+// group i holds the buffers from group_starts[i] to group_starts[i + 1]
+typedef struct KeyIndex {
+  IoBuffer **sorted;
+  size_t *group_starts;
+  size_t groups;
+} KeyIndex;
+
+// output at a position in a set, positions stay the same until exit
+typedef struct OutputRef {
+  size_t set_idx;
+  size_t position;
+} OutputRef;
+
 typedef struct RuntimeData {
-  IoSet *input_sets;
   IoSet *output_sets;
+  // buffers of all output sets, each set uses a segment in set order
+  IoBuffer *output_arena;
+  size_t output_arena_cap;
+  // lookup indexes over the inputs, built on first use
+  IdentTable input_set_table;
+  IdentTable *input_item_tables;
+  char input_item_tables_failed;
+  KeyIndex *input_key_indexes;
+  // counter value the clocks start from and the factor converting ticks
+  // since then to nanoseconds with CLOCK_SHIFT fractional bits
+  uint64_t clock_base;
+  uint64_t clock_mult;
+  // outputs written in the container format, reported to the platform in
+  // output_flags at exit
+  OutputRef *container_outputs;
+  size_t container_outputs_len;
+  size_t container_outputs_cap;
 } RuntimeData;
 
+// forget all lookup indexes, called when the inputs are set up
+void reset_input_indexes(void);
+// take over the clock published by the platform, called at init
+void reset_clock(void);
+// forget the phases of an earlier run, called at init
+void reset_phases(void);
+// add the phase durations as an output if there is a set for them
+void add_phase_output(void);
+// make room to remember one more container output, returns 0 on success and
+// -1 if there is not enough memory
+int reserve_container_output(void);
+// remember that the output last added to the set is a container
+void add_container_output(size_t set_idx);
+
 extern RuntimeData __runtime_global_data;
 #define rtdata __runtime_global_data
+
+// input sets are consecutive slices of the platform's buffer array
+static inline IoBuffer *input_set_buffers(size_t set_idx) {
+  return &__dandelion_system_data
+              .input_bufs[__dandelion_system_data.input_sets[set_idx].offset];
+}
+
+static inline size_t input_set_length(size_t set_idx) {
+  return __dandelion_system_data.input_sets[set_idx + 1].offset -
+         __dandelion_system_data.input_sets[set_idx].offset;
+}
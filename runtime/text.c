@@ -0,0 +1,201 @@
+#include "../include/dandelion/text.h"
+
+#include <stdint.h>
+
+#include "vector.h"
+
+#if defined(__SSE2__)
+// the mask of the sign bits directly gives the bytes outside of ASCII
+static inline size_t ascii_in_block(const char *block) {
+  byte_vector low;
+  byte_vector high;
+  __builtin_memcpy(&low, block, 16);
+  __builtin_memcpy(&high, block + 16, 16);
+  uint32_t mask = (uint32_t)__builtin_ia32_pmovmskb128(low) |
+                  (uint32_t)__builtin_ia32_pmovmskb128(high) << 16;
+  if (mask == 0) {
+    return BLOCK_SIZE;
+  }
+  return __builtin_ctz(mask);
+}
+#elif defined(__ARM_NEON)
+static inline size_t ascii_in_block(const char *block) {
+  uint8x16_t low = vld1q_u8((const uint8_t *)block);
+  uint8x16_t high = vld1q_u8((const uint8_t *)block + 16);
+  if (vmaxvq_u8(vorrq_u8(low, high)) < 0x80) {
+    return BLOCK_SIZE;
+  }
+  uint64_t mask = neon_mask(vcltzq_s8(vreinterpretq_s8_u8(low)));
+  if (mask != 0) {
+    return __builtin_ctzll(mask) / 4;
+  }
+  return 16 + __builtin_ctzll(neon_mask(vcltzq_s8(vreinterpretq_s8_u8(high)))) /
+                  4;
+}
+#else
+static inline size_t ascii_in_block(const char *block) {
+  const uint64_t highs = 0x8080808080808080ULL;
+  for (size_t offset = 0; offset < BLOCK_SIZE; offset += 8) {
+    uint64_t word;
+    __builtin_memcpy(&word, block + offset, 8);
+    if ((word & highs) != 0) {
+      size_t index = offset;
+      while ((signed char)block[index] >= 0) {
+        index++;
+      }
+      return index;
+    }
+  }
+  return BLOCK_SIZE;
+}
+#endif
+
+size_t dandelion_ascii_length(const char *data, size_t len) {
+  size_t index = 0;
+  for (; len - index >= BLOCK_SIZE; index += BLOCK_SIZE) {
+    size_t ascii = ascii_in_block(data + index);
+    if (ascii != BLOCK_SIZE) {
+      return index + ascii;
+    }
+  }
+  while (index < len && (signed char)data[index] >= 0) {
+    index++;
+  }
+  return index;
+}
+
+// length of the valid UTF-8 character at the start of data, or 0 if it is
+// invalid or does not end before len, overlong forms, surrogates and code
+// points above U+10FFFF are invalid, which only leaves a narrower range for
+// the second byte of some lead bytes
+static inline size_t utf8_character(const uint8_t *data, size_t len) {
+  uint8_t lead = data[0];
+  if (lead < 0x80) {
+    return 1;
+  }
+  size_t length;
+  uint8_t lower = 0x80;
+  uint8_t upper = 0xbf;
+  if (lead < 0xc2) {
+    return 0;
+  } else if (lead < 0xe0) {
+    length = 2;
+  } else if (lead < 0xf0) {
+    length = 3;
+    lower = lead == 0xe0 ? 0xa0 : lower;
+    upper = lead == 0xed ? 0x9f : upper;
+  } else if (lead < 0xf5) {
+    length = 4;
+    lower = lead == 0xf0 ? 0x90 : lower;
+    upper = lead == 0xf4 ? 0x8f : upper;
+  } else {
+    return 0;
+  }
+  if (len < length || data[1] < lower || data[1] > upper) {
+    return 0;
+  }
+  for (size_t index = 2; index < length; index++) {
+    if ((data[index] & 0xc0) != 0x80) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+static size_t utf8_length_from(const char *data, size_t index, size_t len) {
+  while (index < len) {
+    if ((signed char)data[index] >= 0) {
+      index += dandelion_ascii_length(data + index, len - index);
+      continue;
+    }
+    size_t length =
+        utf8_character((const uint8_t *)data + index, len - index);
+    if (length == 0) {
+      break;
+    }
+    index += length;
+  }
+  return index;
+}
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+// generic vector extensions, which compile to SSE2 and NEON alike
+typedef uint8_t utf8_vector __attribute__((vector_size(16)));
+typedef uint64_t word_vector __attribute__((vector_size(16)));
+
+#define UTF8_BLOCK 16
+
+/*
+    Checks a block of UTF-8 without decoding it. Each byte is compared with
+    the bytes one, two and three positions before it, which also reach into
+    the previous block: a byte needs to be a continuation byte exactly if one
+    of these is the lead byte of a character that long. The lead bytes of
+    overlong two byte forms and of code points above U+10FFFF never occur and
+    the other invalid forms are second bytes out of range for their lead.
+    Characters crossing into the next block are checked with it.
+*/
+static inline int utf8_block_valid(const uint8_t *block) {
+  utf8_vector bytes;
+  utf8_vector prev1;
+  utf8_vector prev2;
+  utf8_vector prev3;
+  __builtin_memcpy(&bytes, block, 16);
+  __builtin_memcpy(&prev1, block - 1, 16);
+  __builtin_memcpy(&prev2, block - 2, 16);
+  __builtin_memcpy(&prev3, block - 3, 16);
+  utf8_vector continuation = (utf8_vector)(bytes >= 0x80) &
+                             (utf8_vector)(bytes < 0xc0);
+  utf8_vector required = (utf8_vector)(prev1 >= 0xc0) |
+                         (utf8_vector)(prev2 >= 0xe0) |
+                         (utf8_vector)(prev3 >= 0xf0);
+  utf8_vector invalid = continuation ^ required;
+  invalid |= (utf8_vector)((bytes & 0xfe) == 0xc0) |
+             (utf8_vector)(bytes >= 0xf5);
+  invalid |= (utf8_vector)(prev1 == 0xe0) & (utf8_vector)(bytes < 0xa0);
+  invalid |= (utf8_vector)(prev1 == 0xed) & (utf8_vector)(bytes > 0x9f);
+  invalid |= (utf8_vector)(prev1 == 0xf0) & (utf8_vector)(bytes < 0x90);
+  invalid |= (utf8_vector)(prev1 == 0xf4) & (utf8_vector)(bytes > 0x8f);
+  word_vector words = (word_vector)invalid;
+  return (words[0] | words[1]) == 0;
+}
+
+// blocks of ASCII are valid unless a character before them is missing its
+// continuation bytes
+static inline int utf8_block_ascii(const uint8_t *block) {
+  word_vector words;
+  __builtin_memcpy(&words, block, 16);
+  return ((words[0] | words[1]) & 0x8080808080808080ULL) == 0 &&
+         block[-1] < 0xc0 && block[-2] < 0xe0 && block[-3] < 0xf0;
+}
+
+size_t dandelion_utf8_length(const char *data, size_t len) {
+  if (len < UTF8_BLOCK) {
+    return utf8_length_from(data, 0, len);
+  }
+  // the first block is checked from a copy, so nothing before data is read
+  uint8_t first[3 + UTF8_BLOCK] = {0};
+  __builtin_memcpy(first + 3, data, UTF8_BLOCK);
+  if (!utf8_block_valid(first + 3)) {
+    return utf8_length_from(data, 0, len);
+  }
+  size_t index = UTF8_BLOCK;
+  while (len - index >= UTF8_BLOCK) {
+    const uint8_t *block = (const uint8_t *)data + index;
+    if (!utf8_block_ascii(block) && !utf8_block_valid(block)) {
+      break;
+    }
+    index += UTF8_BLOCK;
+  }
+  // everything before the last character starting in the valid blocks is
+  // complete, so the rest is checked from its lead byte on
+  size_t start = index - 1;
+  while (start > index - 4 && ((uint8_t)data[start] & 0xc0) == 0x80) {
+    start--;
+  }
+  return utf8_length_from(data, start, len);
+}
+#else
+size_t dandelion_utf8_length(const char *data, size_t len) {
+  return utf8_length_from(data, 0, len);
+}
+#endif
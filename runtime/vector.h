@@ -0,0 +1,24 @@
+#pragma once
+
+// helpers shared by the scans that look at a block of bytes at a time
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// number of bytes compared per step of the vector loops
+#define BLOCK_SIZE 32
+
+#if defined(__SSE2__)
+// use vector extensions and the builtin directly, as the intrinsics headers
+// pull in the hosted stdlib.h with some compilers
+typedef char byte_vector __attribute__((vector_size(16)));
+#elif defined(__ARM_NEON)
+// narrowing the comparison result gives 4 bits per byte in a 64 bit mask
+static inline uint64_t neon_mask(uint8x16_t equal) {
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(equal), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+#endif
@@ -60,7 +60,7 @@ int memcmp(const void *str1, const void *str2, size_t n) {
   uint8_t *two = (uint8_t *)str2;
   for (size_t i = 0; i < n; i++) {
     if (one[i] != two[i])
-      return one > two ? 1 : -1;
+      return one[i] > two[i] ? 1 : -1;
   }
   return 0;
 }
\ No newline at end of file
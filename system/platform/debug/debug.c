@@ -2,14 +2,22 @@
 #include <stdint.h>
 
 #include "../../system.h"
+#include "dandelion/container.h"
 #include "dandelion/system/system.h"
 #include "syscall.h"
 
 #define sysdata __dandelion_system_data
 
 #define DIRENT_BUF_SIZE 4096
+// needs to be a power of two
+#define OUTPUT_RING_LEN 64
+#define OUTPUT_REGION_SIZE (1ull << 30)
 #define DT_DIR 4
 #define DT_REG 8
+#define EEXIST 17
+#define NANOSECONDS_PER_SECOND 1000000000ull
+// shortest time the counter is measured against the host clock
+#define CALIBRATION_NS 10000000ull
 
 static size_t my_strlen(const char *string) {
   size_t len = 0;
@@ -50,7 +58,125 @@ static void write_all(int fd, const void *buffer, size_t size) {
   return;
 }
 
-static void dump_io_buf(const char *setid, size_t setidlen, IoBuffer *buf) {
+static void *vm_alloc(size_t size) {
+  long ret = __syscall(SYS_mmap, NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ret < 0 && ret > -4096) {
+    return NULL;
+  }
+  return (void *)ret;
+}
+
+// records of a container are kept as files named by their index
+static void format_index(char *name, size_t index) {
+  char digits[20];
+  size_t length = 0;
+  do {
+    digits[length++] = '0' + index % 10;
+    index /= 10;
+  } while (index != 0);
+  for (size_t position = 0; position < length; position++) {
+    name[position] = digits[length - 1 - position];
+  }
+  name[length] = '\0';
+}
+
+// pack the files 0, 1, 2, ... of an item directory into a container
+static void pack_records(int dir_fd, void **data, size_t *data_len) {
+  char name[21];
+  size_t records = 0;
+  size_t payload_size = 0;
+  for (;; records++) {
+    format_index(name, records);
+    int record_fd = __syscall(SYS_openat, dir_fd, name, O_RDONLY);
+    if (record_fd < 0)
+      break;
+    ptrdiff_t record_size = __syscall(SYS_lseek, record_fd, 0, 2);
+    __syscall(SYS_close, record_fd);
+    if (record_size < 0)
+      print_and_exit("Could not get record size\n", -1);
+    payload_size += record_size;
+  }
+  size_t index_size = dandelion_container_index_size(records);
+  char *container = vm_alloc(index_size + payload_size);
+  if (container == NULL)
+    print_and_exit("Could not allocate container\n", -1);
+  uint32_t header[2] = {DANDELION_CONTAINER_MAGIC,
+                        DANDELION_CONTAINER_VERSION};
+  my_memcpy(container, header, sizeof(header));
+  uint64_t record_count = records;
+  my_memcpy(container + 8, &record_count, 8);
+  uint64_t offset = 0;
+  for (size_t record = 0; record < records; record++) {
+    my_memcpy(container + DANDELION_CONTAINER_HEADER_SIZE + record * 8,
+              &offset, 8);
+    format_index(name, record);
+    int record_fd = __syscall(SYS_openat, dir_fd, name, O_RDONLY);
+    ptrdiff_t read_bytes;
+    while ((read_bytes = __syscall(SYS_read, record_fd,
+                                   container + index_size + offset,
+                                   payload_size - offset)) > 0) {
+      offset += read_bytes;
+    }
+    if (read_bytes < 0)
+      print_and_exit("Could not read record\n", -1);
+    __syscall(SYS_close, record_fd);
+  }
+  my_memcpy(container + DANDELION_CONTAINER_HEADER_SIZE + records * 8, &offset,
+            8);
+  *data = container;
+  *data_len = index_size + payload_size;
+}
+
+// write the records of a valid container as files into a new directory,
+// returns 0 if the data was unpacked
+static int unpack_records(const char *path, IoBuffer *buf) {
+  const char *data = buf->data;
+  uint32_t header[2];
+  uint64_t records;
+  if (buf->data_len < DANDELION_CONTAINER_HEADER_SIZE)
+    return -1;
+  my_memcpy(header, data, sizeof(header));
+  my_memcpy(&records, data + 8, 8);
+  if (header[0] != DANDELION_CONTAINER_MAGIC ||
+      header[1] != DANDELION_CONTAINER_VERSION ||
+      records >= (buf->data_len - DANDELION_CONTAINER_HEADER_SIZE) / 8)
+    return -1;
+  size_t index_size = dandelion_container_index_size(records);
+  const char *offsets = data + DANDELION_CONTAINER_HEADER_SIZE;
+  for (size_t record = 0; record < records; record++) {
+    if (dandelion_container_offset(offsets, record) >
+        dandelion_container_offset(offsets, record + 1))
+      return -1;
+  }
+  if (dandelion_container_offset(offsets, records) >
+      buf->data_len - index_size)
+    return -1;
+  // the directory is left over from an earlier run
+  int error = __syscall(SYS_mkdirat, AT_FDCWD, path, 00777);
+  if (error < 0 && error != -EEXIST)
+    print_and_exit("Failed to create record directory\n", -error);
+  int dir_fd = __syscall(SYS_openat, AT_FDCWD, path, O_RDONLY);
+  if (dir_fd < 0)
+    print_and_exit("Failed to open record directory\n", -dir_fd);
+  char name[21];
+  for (size_t record = 0; record < records; record++) {
+    uint64_t start = dandelion_container_offset(offsets, record);
+    uint64_t end = dandelion_container_offset(offsets, record + 1);
+    format_index(name, record);
+    int record_fd = __syscall(SYS_openat, dir_fd, name,
+                              O_WRONLY | O_CREAT | O_TRUNC, 00666);
+    if (record_fd < 0)
+      print_and_exit("Failed to open record file\n", -record_fd);
+    write_all(record_fd, data + index_size + start, end - start);
+    __syscall(SYS_close, record_fd);
+  }
+  __syscall(SYS_close, dir_fd);
+  return 0;
+}
+
+static void dump_io_buf(const char *setid, size_t setidlen, IoBuffer *buf,
+                        unsigned char flags) {
   char tmp[256] = "output_sets/";
   size_t start_len = my_strlen(tmp);
   if (setid == NULL || buf == NULL || buf->ident == NULL) {
@@ -68,34 +194,75 @@ static void dump_io_buf(const char *setid, size_t setidlen, IoBuffer *buf) {
   // print the set and buffer identifiers to console
   write_all(1, tmp, start_len + setidlen + 1 + identlen);
   write_all(1, "\n", 1);
+  // containers are written as a directory of their records
+  if ((flags & DANDELION_OUTPUT_CONTAINER) && unpack_records(tmp, buf) == 0)
+    return;
   // open file file for the data
   int out_fd =
       __syscall(SYS_openat, AT_FDCWD, tmp, O_WRONLY | O_CREAT | O_TRUNC, 00666);
   if (out_fd < 0)
     print_and_exit("Failed to open output file\n", -out_fd);
   write_all(out_fd, buf->data, buf->data_len);
+  __syscall(SYS_close, out_fd);
+}
+
+static uint64_t host_clock_ns(int clock) {
+  struct {
+    int64_t tv_sec;
+    int64_t tv_nsec;
+  } time;
+  if (__syscall(SYS_clock_gettime, clock, &time) < 0)
+    print_and_exit("Could not read host clock\n", -1);
+  return time.tv_sec * NANOSECONDS_PER_SECOND + time.tv_nsec;
 }
 
+// publish the counter frequency, on x86 it is measured against the host clock
+// from the given sample on, which is taken early so loading the inputs counts
+// towards the calibration time
+static void calibrate_clock(uint64_t start_ticks, uint64_t start_ns) {
+#if defined(__x86_64__)
+  uint64_t elapsed_ticks;
+  uint64_t elapsed_ns;
+  do {
+    elapsed_ns = host_clock_ns(CLOCK_MONOTONIC) - start_ns;
+    elapsed_ticks = __dandelion_read_ticks() - start_ticks;
+  } while (elapsed_ns < CALIBRATION_NS);
+  // keep the product below 64 bits, the precision stays well below a ppm
+  while (elapsed_ns > (1ull << 31)) {
+    elapsed_ns >>= 1;
+    elapsed_ticks >>= 1;
+  }
+  sysdata.clock_frequency = elapsed_ticks * NANOSECONDS_PER_SECOND / elapsed_ns;
+#elif defined(__aarch64__)
+  (void)start_ticks;
+  (void)start_ns;
+  uint64_t frequency;
+  __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+  sysdata.clock_frequency = frequency;
+#else
+#error "Missing architecture specific code."
+#endif
+  sysdata.realtime_base = host_clock_ns(CLOCK_REALTIME);
+  sysdata.clock_base = __dandelion_read_ticks();
+}
+
+// write items published before exit as they come in
+static struct io_stream_entry output_ring[OUTPUT_RING_LEN];
+
 static void dump_global_data() {
   for (size_t i = 0; i < sysdata.output_sets_len; ++i) {
     struct io_set_info *set = &sysdata.output_sets[i];
     size_t num_elems = sysdata.output_sets[i + 1].offset - set->offset;
     for (size_t j = 0; j < num_elems; ++j) {
-      dump_io_buf(set->ident, set->ident_len,
-                  &sysdata.output_bufs[set->offset + j]);
+      size_t index = set->offset + j;
+      unsigned char flags =
+          sysdata.output_flags == NULL ? 0 : sysdata.output_flags[index];
+      dump_io_buf(set->ident, set->ident_len, &sysdata.output_bufs[index],
+                  flags);
     }
   }
 }
 
-static void *vm_alloc(size_t size) {
-  long ret = __syscall(SYS_mmap, NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
-                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-  if (ret < 0 && ret > -4096) {
-    return NULL;
-  }
-  return (void *)ret;
-}
-
 static inline char *round_up_to(char *original, size_t alignment) {
   size_t mod = ((uintptr_t)original) % alignment;
   size_t additional = alignment - (mod == 0 ? alignment : mod);
@@ -119,6 +286,8 @@ static void *debug_alloc(size_t size) {
 }
 
 void __dandelion_platform_init(void) {
+  uint64_t calibration_ticks = __dandelion_read_ticks();
+  uint64_t calibration_ns = host_clock_ns(CLOCK_MONOTONIC);
   size_t alloc_size = 1ull << 31;
   void *heap_ptr = vm_alloc(alloc_size);
   void *heap_end = (void *)((char *)heap_ptr + alloc_size);
@@ -230,6 +399,18 @@ void __dandelion_platform_init(void) {
         current_buffer->ident = item_ident_buffer;
         current_buffer->ident_len = item_ident_len;
         current_buffer->key = 0;
+        // directories are packed into a container of their records
+        if (set_dirent->d_type == DT_DIR) {
+          int records_fd = __syscall(SYS_openat, set_folder_fd,
+                                     set_dirent->d_name, O_RDONLY);
+          if (records_fd < 0)
+            print_and_exit("could not open item directory", -1);
+          pack_records(records_fd, &current_buffer->data,
+                       &current_buffer->data_len);
+          __syscall(SYS_close, records_fd);
+          total_buffers++;
+          continue;
+        }
         int item_fd =
             __syscall(SYS_openat, set_folder_fd, set_dirent->d_name, O_RDONLY);
         if (item_fd < 0)
@@ -314,15 +495,75 @@ void __dandelion_platform_init(void) {
   heap_ptr += (output_set_index + 1) * sizeof(struct io_set_info);
 
   sysdata.output_bufs = NULL;
+  sysdata.output_ring = output_ring;
+  sysdata.output_ring_len = OUTPUT_RING_LEN;
+  sysdata.output_ring_head = 0;
+  sysdata.output_ring_tail = 0;
+  // region for outputs allocated in place, mapped separately from the heap
+  void *output_region = vm_alloc(OUTPUT_REGION_SIZE);
+  if (output_region != NULL) {
+    sysdata.output_region_begin = (uintptr_t)output_region;
+    sysdata.output_region_end = (uintptr_t)output_region + OUTPUT_REGION_SIZE;
+    sysdata.output_region_used = 0;
+  }
   sysdata.output_sets = output_sets;
   sysdata.output_sets_len = output_set_index;
 
   sysdata.heap_begin = (uintptr_t)heap_ptr;
   sysdata.heap_end = (uintptr_t)heap_end;
+
+  // seed from the host, keep the default seed if that is not possible
+  uint64_t seed = 0;
+  if (__syscall(SYS_getrandom, &seed, sizeof(seed), 0) == sizeof(seed))
+    sysdata.random_seed = seed;
+
+  calibrate_clock(calibration_ticks, calibration_ns);
+}
+
+void __dandelion_platform_publish(void) {
+  size_t head = __atomic_load_n(&sysdata.output_ring_head, __ATOMIC_ACQUIRE);
+  for (; sysdata.output_ring_tail != head; sysdata.output_ring_tail++) {
+    struct io_stream_entry *entry =
+        &output_ring[sysdata.output_ring_tail & (OUTPUT_RING_LEN - 1)];
+    struct io_set_info *set = &sysdata.output_sets[entry->set_index];
+    dump_io_buf(set->ident, set->ident_len, &entry->buffer, 0);
+  }
+}
+
+// print how long each phase the runtime recorded took
+static void print_phases(void) {
+  write_all(1, "phases:\n", 8);
+  for (int phase = 0; phase < DANDELION_PHASE_END; phase++) {
+    uint64_t start = sysdata.phase_ticks[phase];
+    if (start == 0)
+      continue;
+    int next = phase + 1;
+    while (next < DANDELION_PHASE_END && sysdata.phase_ticks[next] == 0)
+      next++;
+    uint64_t end = sysdata.phase_ticks[next];
+    if (end < start)
+      continue;
+    uint64_t ticks = end - start;
+    // split the conversion so the product can not overflow
+    uint64_t frequency = sysdata.clock_frequency;
+    uint64_t nanoseconds =
+        ticks / frequency * NANOSECONDS_PER_SECOND +
+        ticks % frequency * NANOSECONDS_PER_SECOND / frequency;
+    const char *name = __dandelion_phase_name(phase);
+    char number[21];
+    format_index(number, nanoseconds);
+    write_all(1, "\t", 1);
+    write_all(1, name, my_strlen(name));
+    write_all(1, " ", 1);
+    write_all(1, number, my_strlen(number));
+    write_all(1, " ns\n", 4);
+  }
 }
 
 void __dandelion_platform_exit(void) {
+  __dandelion_platform_publish();
   dump_global_data();
+  print_phases();
   // print exit code
   char exit_message[] = "Exiting with code ";
   size_t message_len = my_strlen(exit_message);
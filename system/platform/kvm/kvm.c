@@ -14,6 +14,9 @@ void __dandelion_platform_exit(void) {
   __builtin_unreachable();
 }
 
+// outputs are only collected at exit
+void __dandelion_platform_publish(void) {}
+
 void __dandelion_platform_set_thread_pointer(void *ptr) {
   size_t thread_data = (size_t)ptr;
 #if defined(__x86_64__)
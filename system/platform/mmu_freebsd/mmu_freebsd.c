@@ -8,6 +8,9 @@ void __dandelion_platform_exit(void) {
   __builtin_unreachable();
 }
 
+// outputs are only collected at exit
+void __dandelion_platform_publish(void) {}
+
 void __dandelion_platform_set_thread_pointer(void *ptr) {
 #if defined(__x86_64__)
   __syscall(FREEBSD_SYS_sysarch, FREEBSD_AMD64_GET_FSBASE, ptr);
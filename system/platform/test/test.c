@@ -5,4 +5,6 @@ void __dandelion_platform_init(void) {}
 
 void __dandelion_platform_exit(void) {}
 
+void __dandelion_platform_publish(void) {}
+
 void __dandelion_platform_set_thread_pointer(void *ptr) {}
\ No newline at end of file
@@ -1,13 +1,17 @@
 #define __SYSCALL_LL_E(x) (x)
 #define __SYSCALL_LL_O(x) (x)
 
+#define SYS_mkdirat 34
 #define SYS_openat 56
+#define SYS_close 57
 #define SYS_lseek 62
 #define SYS_read 63
 #define SYS_write 64
 #define SYS_exit_group 94
 #define SYS_mmap 222
 #define SYS_getdents64 61
+#define SYS_getrandom 278
+#define SYS_clock_gettime 113
 
 #define __asm_syscall(...)                                                     \
   do {                                                                         \
@@ -3,12 +3,16 @@
 
 #define SYS_read 0
 #define SYS_write 1
+#define SYS_close 3
 #define SYS_lseek 8
 #define SYS_mmap 9
 #define SYS_arch_prctl 158
 #define SYS_exit_group 231
 #define SYS_openat 257
+#define SYS_mkdirat 258
 #define SYS_getdents64 217
+#define SYS_getrandom 318
+#define SYS_clock_gettime 228
 
 #define ARCH_SET_FS 0x1002
 
@@ -17,6 +17,9 @@
 #define O_TRUNC 01000
 #define AT_FDCWD -100
 
+#define CLOCK_REALTIME 0
+#define CLOCK_MONOTONIC 1
+
 #ifndef __scc
 #define __scc(X) ((long)(X))
 typedef long syscall_arg_t;
@@ -11,12 +11,27 @@ struct dandelion_system_data __dandelion_system_data = {
     .output_sets_len = -1,
     .output_sets = NULL,
     .input_bufs = NULL,
-    .output_bufs = NULL};
+    .output_bufs = NULL,
+    .output_ring = NULL,
+    .output_ring_len = 0,
+    .output_ring_head = 0,
+    .output_ring_tail = 0,
+    .output_region_begin = 0,
+    .output_region_end = 0,
+    .output_region_used = 0,
+    .random_seed = 0,
+    .clock_frequency = 0,
+    .clock_base = 0,
+    .realtime_base = 0,
+    .phase_ticks = {0},
+    .output_flags = NULL};
 
 void __dandelion_system_init(void) { __dandelion_platform_init(); }
 
 void __dandelion_system_exit(void) { __dandelion_platform_exit(); }
 
+void __dandelion_system_publish(void) { __dandelion_platform_publish(); }
+
 void __dandelion_system_set_thread_pointer(void *ptr) {
   return __dandelion_platform_set_thread_pointer(ptr);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 void __dandelion_platform_init(void);
 void __dandelion_platform_exit(void);
+void __dandelion_platform_publish(void);
 void __dandelion_platform_set_thread_pointer(void *ptr);
 
 // definitions of freestanding functions
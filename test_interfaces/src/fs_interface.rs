@@ -1,6 +1,6 @@
 use std::ptr::null;
 
-use libc::{__errno_location, c_char, c_int, size_t};
+use libc::{__errno_location, c_char, c_int, c_void, size_t};
 
 use crate::{
     dandelion_structures::{
@@ -19,14 +19,33 @@ struct DandelionStat {
 
 type ModeT = u32;
 
+#[repr(C)]
+struct DandelionGlobPart {
+    pattern: *const c_char,
+    length: size_t,
+    literal: c_char,
+}
+
+type GlobMatch = extern "C" fn(*mut c_void, size_t, *const c_char, size_t) -> c_int;
+type GlobFound = extern "C" fn(*mut c_void, *const c_char, size_t, c_int) -> c_int;
+
 extern "C" {
     /// check if the file corresponding to the descriptor is connected to a terminal
-    /// not testing isatty for now, as it is hard coded to be true on stdin, stdout and stderr and false otherwise
-    // fn dandelion_isatty(file: c_int) -> c_int;
+    fn dandelion_isatty(file: c_int) -> c_int;
     /// link the file at one path to another path
     fn dandelion_link(old: *const c_char, new: *const c_char) -> c_int;
     /// remove path from pointing to file, if last path leading to file and if it is not open, remove file
     fn dandelion_unlink(name: *const c_char) -> c_int;
+    /// move a file to a new path without copying its data
+    fn dandelion_rename(old: *const c_char, new: *const c_char) -> c_int;
+    fn dandelion_renameat(
+        old_dirfd: c_int,
+        old: *const c_char,
+        new_dirfd: c_int,
+        new: *const c_char,
+    ) -> c_int;
+    /// hand a finished output file to the platform before exit
+    fn dandelion_publish(name: *const c_char) -> c_int;
     /// open file at path with flags and read/write mode
     fn dandelion_open(name: *const c_char, flags: c_int, mode: ModeT) -> c_int;
     /// reposition file reading/writing offset
@@ -47,12 +66,32 @@ extern "C" {
         offset: int64_t,
         options: c_char,
     ) -> c_int;
+    /// view of the bytes at the current offset without copying
+    fn dandelion_read_view(file: c_int, data: *mut *const c_char) -> i64;
+    /// move offset past bytes of the current view
+    fn dandelion_read_advance(file: c_int, length: size_t) -> c_int;
     /// close file corresponding to descriptor
     fn dandelion_close(file: c_int) -> c_int;
+    /// duplicate descriptor to lowest free descriptor not below min_file
+    fn dandelion_dup(file: c_int, min_file: c_int, flags: c_int) -> c_int;
+    /// duplicate descriptor to new_file, closing it first if it was open
+    fn dandelion_dup2(file: c_int, new_file: c_int, flags: c_int) -> c_int;
+    /// create a pipe and return the read and write end descriptors
+    fn dandelion_pipe(fds: *mut c_int) -> c_int;
     /// get the stat for the file corresponding to the descriptor
     fn dandelion_fstat(file: c_int, st: *mut DandelionStat) -> c_int;
     /// get stat for a file using path
     fn dandelion_stat(name: *const c_char, st: *mut DandelionStat) -> c_int;
+    /// walk the file tree below start and report the paths matching all parts
+    fn dandelion_glob(
+        start: *const c_char,
+        start_len: size_t,
+        parts: *const DandelionGlobPart,
+        part_count: size_t,
+        glob_match: GlobMatch,
+        found: GlobFound,
+        context: *mut c_void,
+    ) -> c_int;
     /// initialize file system from input sets and create stdio
     fn fs_initialize(
         argc: *mut c_int,
@@ -72,6 +111,7 @@ const O_CREAT: i32 = 0x200;
 const O_TRUNC: i32 = 0x400;
 const O_EXCL: i32 = 0x800;
 const O_ACCMODE: i32 = O_RDONLY | O_WRONLY | O_RDWR;
+const AT_FDCWD: i32 = -2;
 
 const SEEK_SET: i32 = 0; /* set file offset to offset */
 const SEEK_CUR: i32 = 1; /* set file offset to current plus offset */
@@ -777,6 +817,115 @@ fn unlink_test() {
     assert_eq!(None, another_file_result);
 }
 
+#[test]
+fn rename_test() {
+    // move input files between sets and check they show up under the new name
+    let heap_size = 16 * 4096;
+    let file_name = "file";
+    let file_content = "abc".as_bytes();
+    let other_name = "other";
+    let other_content = "def".as_bytes();
+    let input_sets = vec![DandelionSet {
+        ident: "in",
+        items: vec![
+            DandelionItem {
+                ident: file_name,
+                key: 0,
+                data: file_content.to_vec(),
+            },
+            DandelionItem {
+                ident: other_name,
+                key: 0,
+                data: other_content.to_vec(),
+            },
+        ],
+    }];
+    let output_sets = vec!["out"];
+    let setup = initialize_dandelion(heap_size, input_sets, output_sets);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    // moving into a folder that does not exist fails
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/in/file\0".as_ptr() as *const i8,
+            "/missing/file\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(-libc::ENOENT, rename_error);
+    // only AT_FDCWD stands for the working directory, other negative
+    // descriptors are invalid
+    for (old_dirfd, new_dirfd) in [(-1, AT_FDCWD), (AT_FDCWD, -100)] {
+        let rename_error = unsafe {
+            dandelion_renameat(
+                old_dirfd,
+                "in/file\0".as_ptr() as *const i8,
+                new_dirfd,
+                "out/file\0".as_ptr() as *const i8,
+            )
+        };
+        assert_eq!(-libc::EBADF, rename_error);
+    }
+    let rename_error = unsafe {
+        dandelion_renameat(
+            AT_FDCWD,
+            "in/other\0".as_ptr() as *const i8,
+            AT_FDCWD,
+            "in/moved\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(0, rename_error);
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/in/moved\0".as_ptr() as *const i8,
+            "/in/other\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(0, rename_error);
+    // renaming a file that does not exist fails
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/in/missing\0".as_ptr() as *const i8,
+            "/out/missing\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(-libc::ENOENT, rename_error);
+    // move file to output set under a new name
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/in/file\0".as_ptr() as *const i8,
+            "/out/renamed\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(0, rename_error);
+    // replace the moved file with the other one
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/in/other\0".as_ptr() as *const i8,
+            "/out/renamed\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(0, rename_error);
+    open_and_read("/out/renamed\0", 3, other_content);
+    let mut stat: DandelionStat = unsafe { std::mem::zeroed() };
+    let stat_result = unsafe { dandelion_stat("/in/file\0".as_ptr() as *const i8, &mut stat) };
+    assert_eq!(-libc::ENOTDIR, stat_result);
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(
+        0, finalize_error,
+        "finalizing file system should not have any errors"
+    );
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+    let renamed_result = setup.get_item_data("out", "renamed");
+    assert_eq!(Some(other_content), renamed_result);
+}
+
 #[test]
 fn stat_test() {
     // setup inputs, relink them to output folders and check if the outputs are available
@@ -808,6 +957,66 @@ fn stat_test() {
     assert_eq!(7, stat.file_size);
 }
 
+#[test]
+fn block_size_test() {
+    // the block size grows with the file up to a cap
+    let heap_size = 64 * 4096;
+    let input_sets = vec![DandelionSet {
+        ident: "folder",
+        items: vec![
+            DandelionItem {
+                ident: "small",
+                key: 0,
+                data: vec![1u8; 100],
+            },
+            DandelionItem {
+                ident: "medium",
+                key: 0,
+                data: vec![2u8; 20000],
+            },
+            DandelionItem {
+                ident: "large",
+                key: 0,
+                data: vec![3u8; 100000],
+            },
+        ],
+    }];
+    let setup = initialize_dandelion(heap_size, input_sets, vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let mut stat: DandelionStat = unsafe { std::mem::zeroed() };
+    for (path, expected) in [
+        ("/folder/small\0", 4096),
+        ("/folder/medium\0", 32768),
+        ("/folder/large\0", 65536),
+    ] {
+        let stat_result = unsafe { dandelion_stat(path.as_ptr() as *const i8, &mut stat) };
+        assert_eq!(0, stat_result);
+        assert_eq!(expected, stat.blk_size);
+    }
+    // new files are expected to be written to
+    let writer = unsafe {
+        dandelion_open(
+            "/out/file\0".as_ptr() as *const i8,
+            O_CREAT | O_WRONLY,
+            S_IRWXU,
+        )
+    };
+    assert_eq!(3, writer);
+    assert_eq!(0, unsafe { dandelion_fstat(writer, &mut stat) });
+    assert_eq!(16384, stat.blk_size);
+    unsafe { dandelion_close(writer) };
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+}
+
 #[test]
 fn fstat_test() {
     // setup inputs, relink them to output folders and check if the outputs are available
@@ -840,4 +1049,680 @@ fn fstat_test() {
     assert_eq!(2, stat.hard_links);
     assert_eq!(7, stat.file_size);
 }
+
+#[test]
+fn small_file_growth_test() {
+    // files start with their data inline and are moved to regular chunks
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, vec![], vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let writer = unsafe {
+        dandelion_open(
+            "/out/file\0".as_ptr() as *const i8,
+            O_CREAT | O_WRONLY,
+            S_IRWXU,
+        )
+    };
+    assert_eq!(3, writer);
+    let written =
+        unsafe { dandelion_write(writer, "abc".as_ptr() as *const i8, 3, 0, MOVE_OFFSET) };
+    assert_eq!(3, written);
+    // second description reading from the small file
+    let reader = unsafe { dandelion_open("/out/file\0".as_ptr() as *const i8, O_RDONLY, 0) };
+    assert_eq!(4, reader);
+    let mut read_buffer = [0u8; 2];
+    let read_bytes = unsafe {
+        dandelion_read(
+            reader,
+            read_buffer.as_mut_ptr() as *mut i8,
+            2,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(2, read_bytes);
+    assert_eq!("ab".as_bytes(), &read_buffer);
+    // grow the file past the inline capacity
+    let large_content = [b'x'; 1000];
+    let written = unsafe {
+        dandelion_write(
+            writer,
+            large_content.as_ptr() as *const i8,
+            1000,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(1000, written);
+    // the reader continues where it left off
+    let read_bytes = unsafe {
+        dandelion_read(
+            reader,
+            read_buffer.as_mut_ptr() as *mut i8,
+            2,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(2, read_bytes);
+    assert_eq!("cx".as_bytes(), &read_buffer);
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+    let mut expected = "abc".as_bytes().to_vec();
+    expected.extend_from_slice(&large_content);
+    assert_eq!(
+        Some(expected.as_slice()),
+        setup.get_item_data("out", "file")
+    );
+}
+
+#[test]
+fn read_view_test() {
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, vec![], vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let writer = unsafe {
+        dandelion_open(
+            "/out/file\0".as_ptr() as *const i8,
+            O_CREAT | O_WRONLY,
+            S_IRWXU,
+        )
+    };
+    assert_eq!(3, writer);
+    // write in several steps so the file consists of multiple chunks
+    let mut expected = Vec::new();
+    for step in 0..20u8 {
+        let content = vec![b'a' + step; 100 * step as usize + 1];
+        let written = unsafe {
+            dandelion_write(
+                writer,
+                content.as_ptr() as *const i8,
+                content.len(),
+                0,
+                MOVE_OFFSET,
+            )
+        };
+        assert_eq!(content.len() as c_int, written);
+        expected.extend_from_slice(&content);
+    }
+    let reader = unsafe { dandelion_open("/out/file\0".as_ptr() as *const i8, O_RDONLY, 0) };
+    assert_eq!(4, reader);
+    // take the first byte with a regular read, the views continue from there
+    let mut read_buffer = [0u8; 1];
+    let read_bytes = unsafe {
+        dandelion_read(
+            reader,
+            read_buffer.as_mut_ptr() as *mut i8,
+            1,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(1, read_bytes);
+    let mut viewed = read_buffer.to_vec();
+    let mut data = null();
+    loop {
+        let available = unsafe { dandelion_read_view(reader, &mut data) };
+        assert!(available >= 0);
+        if available == 0 {
+            break;
+        }
+        // consume views in two parts
+        let first = (available as usize + 1) / 2;
+        viewed.extend_from_slice(unsafe { std::slice::from_raw_parts(data as *const u8, first) });
+        assert_eq!(0, unsafe { dandelion_read_advance(reader, first) });
+        let available = unsafe { dandelion_read_view(reader, &mut data) };
+        let rest = unsafe { std::slice::from_raw_parts(data as *const u8, available as usize) };
+        viewed.extend_from_slice(rest);
+        assert_eq!(-22, unsafe {
+            dandelion_read_advance(reader, rest.len() + 1)
+        });
+        assert_eq!(0, unsafe { dandelion_read_advance(reader, rest.len()) });
+    }
+    assert_eq!(expected, viewed);
+    let offset = unsafe { dandelion_lseek(reader, 0, SEEK_CUR) };
+    assert_eq!(expected.len() as i64, offset);
+    // pipes have no chunks to view
+    let mut fds = [0; 2];
+    assert_eq!(0, unsafe { dandelion_pipe(fds.as_mut_ptr()) });
+    assert_eq!(-22, unsafe { dandelion_read_view(fds[0], &mut data) });
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+}
+
+fn check_isatty(input_sets: Vec<DandelionSet>, expected: c_int) {
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, input_sets, vec![]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+    for file in 0..3 {
+        assert_eq!(expected, unsafe { dandelion_isatty(file) });
+    }
+    assert_eq!(0, unsafe { dandelion_isatty(3) });
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+}
+
+#[test]
+fn isatty_test() {
+    // there is no terminal unless environ asks for one
+    check_isatty(vec![], 0);
+}
+
+#[test]
+fn isatty_environ_test() {
+    let input_sets = vec![DandelionSet {
+        ident: "stdio",
+        items: vec![DandelionItem {
+            ident: "environ",
+            key: 0,
+            data: "HOME=/root DANDELION_TTY=1".as_bytes().to_vec(),
+        }],
+    }];
+    check_isatty(input_sets, 1);
+}
+
+#[test]
+fn device_test() {
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, vec![], vec![]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let mut read_buffer = [1u8; 100];
+    // null reads nothing and swallows writes
+    let null_fd = unsafe { dandelion_open("/dev/null\0".as_ptr() as *const i8, O_RDWR, 0) };
+    assert_eq!(3, null_fd);
+    let read_bytes = unsafe {
+        dandelion_read(
+            null_fd,
+            read_buffer.as_mut_ptr() as *mut i8,
+            100,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(0, read_bytes);
+    let written =
+        unsafe { dandelion_write(null_fd, "abc".as_ptr() as *const i8, 3, 0, MOVE_OFFSET) };
+    assert_eq!(3, written);
+    // zero fills the whole buffer
+    let zero_fd = unsafe { dandelion_open("/dev/zero\0".as_ptr() as *const i8, O_RDONLY, 0) };
+    assert_eq!(4, zero_fd);
+    let read_bytes = unsafe {
+        dandelion_read(
+            zero_fd,
+            read_buffer.as_mut_ptr() as *mut i8,
+            100,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(100, read_bytes);
+    assert!(read_buffer.iter().all(|byte| *byte == 0));
+    // urandom fills the buffer including a partial block at the end
+    let urandom_fd = unsafe { dandelion_open("/dev/urandom\0".as_ptr() as *const i8, O_RDONLY, 0) };
+    assert_eq!(5, urandom_fd);
+    let read_bytes = unsafe {
+        dandelion_read(
+            urandom_fd,
+            read_buffer.as_mut_ptr() as *mut i8,
+            99,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(99, read_bytes);
+    assert!(read_buffer[..99].iter().any(|byte| *byte != 0));
+    assert!(read_buffer[96..99].iter().any(|byte| *byte != 0));
+    assert_eq!(0, read_buffer[99]);
+}
+
+#[test]
+fn dup_test() {
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, vec![], vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let file_descriptor = unsafe {
+        dandelion_open(
+            "/out/file\0".as_ptr() as *const i8,
+            O_CREAT | O_RDWR,
+            S_IRWXU,
+        )
+    };
+    assert_eq!(3, file_descriptor);
+    let duplicate = unsafe { dandelion_dup(file_descriptor, 0, 0) };
+    assert_eq!(4, duplicate);
+    assert_eq!(-libc::EBADF, unsafe { dandelion_dup(10, 0, 0) });
+    // redirect stdout into the file
+    assert_eq!(1, unsafe { dandelion_dup2(file_descriptor, 1, 0) });
+
+    // writes through any of the descriptors share the same offset
+    for descriptor in [file_descriptor, duplicate, 1] {
+        let written =
+            unsafe { dandelion_write(descriptor, "ab".as_ptr() as *const i8, 2, 0, MOVE_OFFSET) };
+        assert_eq!(2, written);
+    }
+    // the file stays open until the last duplicate is closed
+    assert_eq!(0, unsafe { dandelion_close(file_descriptor) });
+    assert_eq!(0, unsafe { dandelion_close(duplicate) });
+    assert_eq!(2, unsafe { dandelion_lseek(1, 2, SEEK_SET) });
+    assert_eq!(-libc::EBADF, unsafe { dandelion_close(duplicate) });
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+    assert_eq!(
+        Some("ababab".as_bytes()),
+        setup.get_item_data("out", "file")
+    );
+}
+
+#[test]
+fn pipe_test() {
+    let heap_size = 16 * 4096;
+    let setup = initialize_dandelion(heap_size, vec![], vec![]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    let mut fds: [c_int; 2] = [-1, -1];
+    let pipe_result = unsafe { dandelion_pipe(fds.as_mut_ptr()) };
+    assert_eq!(0, pipe_result);
+    // stdio takes the first three descriptors
+    assert_eq!([3, 4], fds);
+
+    let mut read_buffer = [0u8; 8];
+    // empty pipe with open write end would block
+    let read_bytes = unsafe {
+        dandelion_read(
+            fds[0],
+            read_buffer.as_mut_ptr() as *mut i8,
+            8,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(-libc::EAGAIN, read_bytes);
+    // ends can only be used in their direction
+    let write_result =
+        unsafe { dandelion_write(fds[0], "abc".as_ptr() as *const i8, 3, 0, MOVE_OFFSET) };
+    assert_eq!(-libc::EBADF, write_result);
+
+    // fill the pipe until it is full, wrapping around the ring buffer
+    let chunk = [7u8; 1000];
+    let mut total_written = 0;
+    loop {
+        let written =
+            unsafe { dandelion_write(fds[1], chunk.as_ptr() as *const i8, 1000, 0, MOVE_OFFSET) };
+        if written < 0 {
+            assert_eq!(-libc::EAGAIN, written);
+            break;
+        }
+        total_written += written;
+    }
+    let mut drain_buffer = vec![0u8; total_written as usize];
+    let read_bytes = unsafe {
+        dandelion_read(
+            fds[0],
+            drain_buffer.as_mut_ptr() as *mut i8,
+            drain_buffer.len() as _,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(total_written, read_bytes);
+    assert!(drain_buffer.iter().all(|byte| *byte == 7));
+
+    let written =
+        unsafe { dandelion_write(fds[1], "abc".as_ptr() as *const i8, 3, 0, MOVE_OFFSET) };
+    assert_eq!(3, written);
+    // after closing the write end the remaining data is still readable
+    assert_eq!(0, unsafe { dandelion_close(fds[1]) });
+    let read_bytes = unsafe {
+        dandelion_read(
+            fds[0],
+            read_buffer.as_mut_ptr() as *mut i8,
+            8,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(3, read_bytes);
+    assert_eq!("abc".as_bytes(), &read_buffer[..3]);
+    // then reports end of file
+    let read_bytes = unsafe {
+        dandelion_read(
+            fds[0],
+            read_buffer.as_mut_ptr() as *mut i8,
+            8,
+            0,
+            MOVE_OFFSET,
+        )
+    };
+    assert_eq!(0, read_bytes);
+    assert_eq!(0, unsafe { dandelion_close(fds[0]) });
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+}
 // TODO permission checks, write to read only file, etc.
+
+#[test]
+fn long_name_test() {
+    // names are not limited by a fixed size buffer in the file node
+    let heap_size = 16 * 4096;
+    let input_content = "abc".as_bytes();
+    let input_sets = vec![DandelionSet {
+        ident: "bucket",
+        items: vec![DandelionItem {
+            ident: "year=2024/month=01/day=01/part-00000-0123456789abcdef0123456789abcdef-c000.snappy.parquet",
+            key: 0,
+            data: input_content.to_vec(),
+        }],
+    }];
+    let setup = initialize_dandelion(heap_size, input_sets, vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    open_and_read(
+        "/bucket/year=2024/month=01/day=01/part-00000-0123456789abcdef0123456789abcdef-c000.snappy.parquet\0",
+        3,
+        input_content,
+    );
+    // created names are copied, so the path buffer can be reused afterwards
+    let mut path = "/out/result-0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\0"
+        .as_bytes()
+        .to_vec();
+    create_and_write(std::str::from_utf8(&path).unwrap(), 4, input_content);
+    path.fill(0);
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+    assert_eq!(
+        Some(input_content),
+        setup.get_item_data(
+            "out",
+            "result-0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef"
+        )
+    );
+}
+
+#[test]
+fn streaming_output_test() {
+    // files are handed to the platform before exit when published, or when
+    // the last description that wrote to them closes in a set directory
+    let heap_size = 16 * 4096;
+    let mut setup = initialize_dandelion(heap_size, vec![], vec!["out"]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    setup.enable_streaming(4);
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    // closing the last description that wrote publishes files right in a set
+    create_and_write("/out/direct\0", 3, "abc".as_bytes());
+    let duplicate = unsafe { dandelion_dup(3, 0, 0) };
+    assert_eq!(4, duplicate);
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    assert_eq!(None, setup.get_streamed_item_data("out", "direct"));
+    assert_eq!(0, unsafe { dandelion_close(4) });
+    assert_eq!(
+        Some("abc".as_bytes()),
+        setup.get_streamed_item_data("out", "direct")
+    );
+    let reopen = unsafe { dandelion_open("/out/direct\0".as_ptr() as *const i8, O_RDONLY, 0) };
+    assert!(reopen < 0);
+    // descriptions that did not write leave the file alone
+    create_and_write("/out/nested/unchanged\0", 3, "xyz".as_bytes());
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    let rename_error = unsafe {
+        dandelion_rename(
+            "/out/nested/unchanged\0".as_ptr() as *const i8,
+            "/out/unchanged\0".as_ptr() as *const i8,
+        )
+    };
+    assert_eq!(0, rename_error);
+    let read_write = unsafe { dandelion_open("/out/unchanged\0".as_ptr() as *const i8, O_RDWR, 0) };
+    assert_eq!(3, read_write);
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    assert_eq!(None, setup.get_streamed_item_data("out", "unchanged"));
+    // closing does not publish nested files, so they can be appended to again
+    create_and_write("/out/nested/done\0", 3, "abc".as_bytes());
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    assert_eq!(None, setup.get_streamed_item_data("out", "nested/done"));
+    let append = unsafe {
+        dandelion_open(
+            "/out/nested/done\0".as_ptr() as *const i8,
+            O_WRONLY | O_APPEND,
+            0,
+        )
+    };
+    assert_eq!(3, append);
+    let written = unsafe { dandelion_write(3, "def".as_ptr() as *mut i8, 3, 0, 0) };
+    assert_eq!(3, written);
+    let publish_path = "/out/nested/done\0".as_ptr() as *const i8;
+    assert_eq!(-libc::EBUSY, unsafe { dandelion_publish(publish_path) });
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    assert_eq!(0, unsafe { dandelion_publish(publish_path) });
+    assert_eq!(
+        Some("abcdef".as_bytes()),
+        setup.get_streamed_item_data("out", "nested/done")
+    );
+    // published files leave the file system
+    let reopen = unsafe { dandelion_open(publish_path, O_RDONLY, 0) };
+    assert!(reopen < 0);
+    // only files in output sets can be published
+    create_and_write("/tmp_file\0", 3, "ghi".as_bytes());
+    assert_eq!(0, unsafe { dandelion_close(3) });
+    assert_eq!(-libc::EINVAL, unsafe {
+        dandelion_publish("/tmp_file\0".as_ptr() as *const i8)
+    });
+    // files that are not published are collected at exit
+    create_and_write("/out/open\0", 3, "def".as_bytes());
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+    assert_eq!(None, setup.get_item_data("out", "nested/done"));
+    assert_eq!(None, setup.get_streamed_item_data("out", "open"));
+    assert_eq!(Some("def".as_bytes()), setup.get_item_data("out", "open"));
+    assert_eq!(None, setup.get_item_data("out", "direct"));
+    assert_eq!(
+        Some("xyz".as_bytes()),
+        setup.get_item_data("out", "unchanged")
+    );
+}
+
+struct GlobResult {
+    // names offered to the match callback
+    offered: Vec<String>,
+    // paths reported as matches, directories with a trailing slash
+    found: Vec<String>,
+    // stop the walk after this many matches
+    limit: usize,
+}
+
+// the non literal parts of the tests only match names ending in .log
+extern "C" fn glob_match_log(
+    context: *mut c_void,
+    _part: size_t,
+    name: *const c_char,
+    name_len: size_t,
+) -> c_int {
+    let result = unsafe { &mut *(context as *mut GlobResult) };
+    let name = unsafe { std::slice::from_raw_parts(name as *const u8, name_len) };
+    let name = String::from_utf8(name.to_vec()).unwrap();
+    let matched = name.ends_with(".log") || !name.contains('.');
+    result.offered.push(name);
+    matched as c_int
+}
+
+extern "C" fn glob_found(
+    context: *mut c_void,
+    path: *const c_char,
+    path_len: size_t,
+    is_directory: c_int,
+) -> c_int {
+    let result = unsafe { &mut *(context as *mut GlobResult) };
+    let path = unsafe { std::slice::from_raw_parts(path as *const u8, path_len + 1) };
+    assert_eq!(0, path[path_len], "path should be zero terminated");
+    let mut path = String::from_utf8(path[..path_len].to_vec()).unwrap();
+    if is_directory != 0 {
+        path.push('/');
+    }
+    result.found.push(path);
+    (result.found.len() >= result.limit) as c_int
+}
+
+fn run_glob(start: &str, parts: &[(&str, bool)], limit: usize) -> (c_int, GlobResult) {
+    let glob_parts: Vec<DandelionGlobPart> = parts
+        .iter()
+        .map(|(pattern, literal)| DandelionGlobPart {
+            pattern: pattern.as_ptr() as *const c_char,
+            length: pattern.len(),
+            literal: *literal as c_char,
+        })
+        .collect();
+    let mut result = GlobResult {
+        offered: vec![],
+        found: vec![],
+        limit,
+    };
+    let error = unsafe {
+        dandelion_glob(
+            start.as_ptr() as *const c_char,
+            start.len(),
+            glob_parts.as_ptr(),
+            glob_parts.len(),
+            glob_match_log,
+            glob_found,
+            &mut result as *mut GlobResult as *mut c_void,
+        )
+    };
+    (error, result)
+}
+
+#[test]
+fn glob_test() {
+    let heap_size = 16 * 4096;
+    let item = |ident| DandelionItem {
+        ident,
+        key: 0,
+        data: "abc".as_bytes().to_vec(),
+    };
+    let input_sets = vec![DandelionSet {
+        ident: "logs",
+        items: vec![
+            item("2024/app.log"),
+            item("2024/app.txt"),
+            item("2024/db/query.log"),
+            item("2025/app.log"),
+            item("readme"),
+        ],
+    }];
+    let setup = initialize_dandelion(heap_size, input_sets, vec![]);
+    dandelion_exit_check!(setup, "Should have initialized without error");
+    let mut argc = 0;
+    let mut argv = null();
+    let mut environ = null();
+    let initialize_val = unsafe { fs_initialize(&mut argc, &mut argv, &mut environ) };
+    assert_eq!(0, initialize_val, "Failed to initialize file system");
+
+    // only directories matching the earlier parts are descended into
+    let (error, result) = run_glob("/logs", &[("*", false), ("*", false)], usize::MAX);
+    assert_eq!(0, error);
+    // children are sorted by the length of their name first
+    assert_eq!(
+        vec!["/logs/2024/db/", "/logs/2024/app.log", "/logs/2025/app.log"],
+        result.found
+    );
+    assert_eq!(
+        vec!["2024", "db", "app.log", "app.txt", "2025", "app.log", "readme"],
+        result.offered
+    );
+    // literal parts are looked up without listing the directory
+    let (error, result) = run_glob(
+        "/logs",
+        &[("2024", true), ("db", true), ("*", false)],
+        usize::MAX,
+    );
+    assert_eq!(0, error);
+    assert_eq!(vec!["/logs/2024/db/query.log"], result.found);
+    assert_eq!(vec!["query.log"], result.offered);
+    let (error, result) = run_glob("/logs", &[("2023", true), ("*", false)], usize::MAX);
+    assert_eq!(0, error);
+    assert!(result.found.is_empty());
+    // relative starts resolve from the root and stay relative
+    let (error, result) = run_glob("logs/2025", &[("*", false)], usize::MAX);
+    assert_eq!(0, error);
+    assert_eq!(vec!["logs/2025/app.log"], result.found);
+    let (error, result) = run_glob("", &[("logs", true), ("readme", true)], usize::MAX);
+    assert_eq!(0, error);
+    assert_eq!(vec!["logs/readme"], result.found);
+    // without parts the start itself is reported if it exists
+    let (error, result) = run_glob("/logs/2024", &[], usize::MAX);
+    assert_eq!(0, error);
+    assert_eq!(vec!["/logs/2024/"], result.found);
+    let (error, result) = run_glob("/logs/2026", &[], usize::MAX);
+    assert_eq!(0, error);
+    assert!(result.found.is_empty());
+    // a non zero return of the found callback stops the walk
+    let (error, result) = run_glob("/", &[("logs", true), ("*", false), ("*", false)], 1);
+    assert_eq!(1, error);
+    assert_eq!(vec!["/logs/2024/db/"], result.found);
+
+    let finalize_error = unsafe { fs_terminate() };
+    assert_eq!(0, finalize_error);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should have exited at end of test without errors");
+}
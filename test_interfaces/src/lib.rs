@@ -27,6 +27,13 @@ pub(crate) mod dandelion_structures {
         _input_buffers: Vec<IoBuffer>,
         _input_data: Vec<Vec<u8>>,
         output_sets: Vec<IoSetInfo>,
+        output_ring: Vec<IoStreamEntry>,
+        output_region: Vec<u8>,
+    }
+
+    fn ident_eq(ident: *const c_char, ident_len: size_t, name: &str) -> bool {
+        ident_len == name.len()
+            && unsafe { slice::from_raw_parts(ident as *const u8, ident_len) } == name.as_bytes()
     }
 
     impl CurrentSetup {
@@ -48,6 +55,15 @@ pub(crate) mod dandelion_structures {
                 core::slice::from_raw_parts(system_data.output_bufs, out_buff_number)
             };
         }
+        /// flags the runtime set for the output buffers in order, None if there are none
+        pub fn output_flags(&self) -> Option<&[u8]> {
+            let system_data = unsafe { &*self.guard.system_data };
+            if system_data.output_flags.is_null() {
+                return None;
+            }
+            let out_buff_number = self.output_sets[self.output_sets.len() - 1].offset;
+            Some(unsafe { core::slice::from_raw_parts(system_data.output_flags, out_buff_number) })
+        }
         pub fn get_item_data(&self, set_name: &str, item_name: &str) -> Option<&[u8]> {
             // find set in set
             let set_index = self
@@ -100,6 +116,59 @@ pub(crate) mod dandelion_structures {
             };
         }
 
+        /// let the runtime publish outputs before exit into a ring of the given length
+        pub fn enable_streaming(&mut self, ring_len: usize) {
+            assert!(ring_len.is_power_of_two());
+            self.output_ring = Vec::with_capacity(ring_len);
+            let system_data = unsafe { &mut *self.guard.system_data };
+            system_data.output_ring = self.output_ring.as_mut_ptr();
+            system_data.output_ring_len = ring_len;
+            system_data.output_ring_head = 0;
+            system_data.output_ring_tail = 0;
+        }
+
+        /// give the runtime a region of the given size to place output data in
+        pub fn enable_output_region(&mut self, region_size: usize) -> core::ops::Range<usize> {
+            self.output_region = vec![0u8; region_size];
+            let system_data = unsafe { &mut *self.guard.system_data };
+            system_data.output_region_begin = self.output_region.as_ptr() as usize;
+            system_data.output_region_end = system_data.output_region_begin + region_size;
+            system_data.output_region_used = 0;
+            system_data.output_region_begin..system_data.output_region_end
+        }
+
+        /// publish a calibrated clock and initialize the runtime again to pick it up
+        pub fn set_clock(&mut self, frequency: u64, base: u64, realtime_base: u64) {
+            let system_data = unsafe { &mut *self.guard.system_data };
+            system_data.clock_frequency = frequency;
+            system_data.clock_base = base;
+            system_data.realtime_base = realtime_base;
+            unsafe { crate::runtime::dandelion_init() };
+        }
+
+        pub fn output_region_used(&self) -> usize {
+            unsafe { (*self.guard.system_data).output_region_used }
+        }
+
+        /// find an item that was published to the output ring
+        pub fn get_streamed_item_data(&self, set_name: &str, item_name: &str) -> Option<&[u8]> {
+            let system_data = unsafe { &*self.guard.system_data };
+            let ring_len = system_data.output_ring_len;
+            (system_data.output_ring_tail..system_data.output_ring_head)
+                .map(|position| unsafe { &*system_data.output_ring.add(position & (ring_len - 1)) })
+                .find(|entry| {
+                    let set = &self.output_sets[entry.set_index];
+                    ident_eq(set.ident, set.ident_len, set_name)
+                        && ident_eq(entry.buffer.ident, entry.buffer.ident_len, item_name)
+                })
+                .map(|entry| unsafe {
+                    core::slice::from_raw_parts(
+                        entry.buffer.data as *const u8,
+                        entry.buffer.data_len,
+                    )
+                })
+        }
+
         #[allow(unused)]
         pub fn print_sets_and_items(&self) {
             for sets in self.output_sets.windows(2) {
@@ -233,6 +302,19 @@ pub(crate) mod dandelion_structures {
             output_sets: output_set_array.as_mut_ptr(),
             input_bufs: input_buffer_array.as_mut_ptr(),
             output_bufs: core::ptr::null_mut(),
+            output_ring: core::ptr::null_mut(),
+            output_ring_len: 0,
+            output_ring_head: 0,
+            output_ring_tail: 0,
+            output_region_begin: 0,
+            output_region_end: 0,
+            output_region_used: 0,
+            random_seed: 0,
+            clock_frequency: 0,
+            clock_base: 0,
+            realtime_base: 0,
+            phase_ticks: [0; 9],
+            output_flags: core::ptr::null_mut(),
         };
         unsafe { *lock_guard.system_data = new_sys_data };
         unsafe { runtime::dandelion_init() };
@@ -244,6 +326,8 @@ pub(crate) mod dandelion_structures {
             _input_sets: input_set_array,
             _input_buffers: input_buffer_array,
             _input_data: input_data,
+            output_ring: Vec::new(),
+            output_region: Vec::new(),
         };
         dandelion_exit_check!(setup, "Should not have error after init");
         return setup;
@@ -269,6 +353,32 @@ pub(crate) mod dandelion_structures {
         input_bufs: *mut IoBuffer,
         /// Buffer array with information about output sets
         output_bufs: *mut IoBuffer,
+        /// ring of outputs published before exit, null if streaming is disabled
+        output_ring: *mut IoStreamEntry,
+        /// number of entries in the ring, power of two
+        output_ring_len: size_t,
+        /// position the runtime writes the next entry to
+        output_ring_head: size_t,
+        /// position the platform consumes the next entry from
+        output_ring_tail: size_t,
+        /// start of the region for output data, 0 if there is none
+        output_region_begin: size_t,
+        /// end of the region for output data
+        output_region_end: size_t,
+        /// bytes used from the start of the output region
+        output_region_used: size_t,
+        /// seed for the random number generators, 0 for the default seed
+        random_seed: u64,
+        /// ticks of the counter per second, 0 to count ticks as nanoseconds
+        clock_frequency: u64,
+        /// counter value at realtime_base, 0 to start the clocks at init
+        clock_base: u64,
+        /// wall clock time in nanoseconds since the epoch at clock_base
+        realtime_base: u64,
+        /// counter values at the start of each phase of the run
+        phase_ticks: [u64; 9],
+        /// flags of each output buffer, null if none has any
+        output_flags: *mut u8,
     }
 
     /// description of a set in the system data
@@ -283,11 +393,17 @@ pub(crate) mod dandelion_structures {
     }
 
     #[repr(C)]
-    struct IoBuffer {
-        ident: *const c_char,
-        ident_len: size_t,
-        data: *const c_void,
-        data_len: size_t,
-        key: size_t,
+    struct IoStreamEntry {
+        set_index: size_t,
+        buffer: IoBuffer,
+    }
+
+    #[repr(C)]
+    pub struct IoBuffer {
+        pub ident: *const c_char,
+        pub ident_len: size_t,
+        pub data: *const c_void,
+        pub data_len: size_t,
+        pub key: size_t,
     }
 }
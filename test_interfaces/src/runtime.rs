@@ -1,9 +1,11 @@
 use core::slice;
-use std::ops::Rem;
+use std::{ops::Rem, ptr::null};
 
-use libc::{c_int, c_void, size_t};
+use libc::{c_char, c_int, c_void, size_t};
 
-use crate::dandelion_structures::{dandelion_exit_check, initialize_dandelion};
+use crate::dandelion_structures::{
+    dandelion_exit_check, initialize_dandelion, DandelionItem, DandelionSet, IoBuffer,
+};
 
 extern "C" {
     /// initialize dandelion
@@ -16,6 +18,141 @@ extern "C" {
     fn dandelion_alloc(size: size_t, alignment: size_t) -> *mut c_void;
     /// dandelion internal free
     fn dandelion_free(free_ptr: *mut c_void);
+    /// add a buffer to an output set
+    fn dandelion_add_output(set_idx: size_t, buf: IoBuffer);
+    /// add several buffers to an output set
+    fn dandelion_add_outputs(set_idx: size_t, bufs: *const IoBuffer, n: size_t) -> c_int;
+    /// allocate data for a new output
+    fn dandelion_alloc_output(
+        set_idx: size_t,
+        ident: *const c_char,
+        ident_len: size_t,
+        size: size_t,
+    ) -> *mut c_void;
+    /// make room for more outputs in a set
+    fn dandelion_reserve_outputs(set_idx: size_t, additional: size_t) -> c_int;
+    /// find input set by name
+    fn dandelion_find_input_set(name: *const c_char, name_len: size_t) -> size_t;
+    /// find input buffer by name
+    fn dandelion_find_input(
+        set_idx: size_t,
+        name: *const c_char,
+        name_len: size_t,
+    ) -> *const IoBuffer;
+    /// find input buffers by key
+    fn dandelion_find_inputs_by_key(
+        set_idx: size_t,
+        key: size_t,
+        count: *mut size_t,
+    ) -> *const *const IoBuffer;
+    /// number of distinct keys in a set
+    fn dandelion_input_key_count(set_idx: size_t) -> size_t;
+    /// buffers of the n-th distinct key
+    fn dandelion_input_key_group(
+        set_idx: size_t,
+        key_idx: size_t,
+        count: *mut size_t,
+    ) -> *const *const IoBuffer;
+    /// check and open a packed container
+    fn dandelion_container_open(
+        container: *mut DandelionContainer,
+        data: *const c_void,
+        data_len: size_t,
+    ) -> c_int;
+    /// set up a container writer
+    fn dandelion_container_writer_init(
+        writer: *mut DandelionContainerWriter,
+        expected_records: size_t,
+        expected_bytes: size_t,
+    ) -> c_int;
+    /// free the memory of a container writer
+    fn dandelion_container_writer_free(writer: *mut DandelionContainerWriter);
+    /// append a record to a container
+    fn dandelion_container_add(
+        writer: *mut DandelionContainerWriter,
+        record: *const c_void,
+        length: size_t,
+    ) -> c_int;
+    /// serialized size of a container
+    fn dandelion_container_size(writer: *const DandelionContainerWriter) -> size_t;
+    /// serialize a container
+    fn dandelion_container_write(writer: *const DandelionContainerWriter, destination: *mut c_void);
+    /// serialize a container into a new output
+    fn dandelion_container_output(
+        writer: *const DandelionContainerWriter,
+        set_idx: size_t,
+        ident: *const c_char,
+        ident_len: size_t,
+    ) -> c_int;
+    /// vectorized search for a byte
+    fn dandelion_find_byte(data: *const c_char, len: size_t, byte: c_char) -> *const c_char;
+    /// vectorized length of the ASCII prefix
+    fn dandelion_ascii_length(data: *const c_char, len: size_t) -> size_t;
+    /// vectorized length of the valid UTF-8 prefix
+    fn dandelion_utf8_length(data: *const c_char, len: size_t) -> size_t;
+    /// current value of the counter behind the clocks
+    fn dandelion_ticks() -> u64;
+    /// nanoseconds since the start of the clocks
+    fn dandelion_monotonic_ns() -> u64;
+    /// nanoseconds since the epoch
+    fn dandelion_realtime_ns() -> u64;
+    /// resolution of the clocks in nanoseconds
+    fn dandelion_clock_resolution_ns() -> u64;
+    /// record that the run enters a phase
+    fn dandelion_mark_phase(phase: c_int);
+    /// set up a record reader
+    fn dandelion_records_init(reader: *mut DandelionRecordReader, delimiter: c_char);
+    /// free the memory of a record reader
+    fn dandelion_records_free(reader: *mut DandelionRecordReader);
+    /// give the next chunk of data to a record reader
+    fn dandelion_records_feed(reader: *mut DandelionRecordReader, data: *const c_void, len: size_t);
+    /// get the next complete record
+    fn dandelion_records_next(
+        reader: *mut DandelionRecordReader,
+        record: *mut *const c_char,
+        len: *mut size_t,
+    ) -> c_int;
+    /// get the record not ended by a delimiter
+    fn dandelion_records_finish(
+        reader: *mut DandelionRecordReader,
+        record: *mut *const c_char,
+        len: *mut size_t,
+    ) -> c_int;
+    /// split data into ranges at record boundaries
+    fn dandelion_split_records(
+        data: *const c_char,
+        len: size_t,
+        delimiter: c_char,
+        ranges: size_t,
+        bounds: *mut size_t,
+    );
+}
+
+#[repr(C)]
+struct DandelionRecordReader {
+    data: *const c_char,
+    end: *const c_char,
+    carry: *mut c_char,
+    carry_len: size_t,
+    carry_cap: size_t,
+    carry_returned: c_char,
+    delimiter: c_char,
+}
+
+#[repr(C)]
+struct DandelionContainer {
+    offsets: *const u8,
+    payload: *const u8,
+    record_count: size_t,
+}
+
+#[repr(C)]
+struct DandelionContainerWriter {
+    offsets: *mut u64,
+    offsets_cap: size_t,
+    payload: *mut u8,
+    payload_cap: size_t,
+    record_count: size_t,
 }
 
 #[test]
@@ -124,3 +261,539 @@ fn test_alloc() {
         }
     }
 }
+
+#[test]
+fn test_find_input() {
+    // enough items to have the lookup go through the hash table
+    let items = (0..100)
+        .map(|index| DandelionItem {
+            ident: Box::leak(format!("item_{}", index).into_boxed_str()),
+            key: 0,
+            data: vec![index as u8],
+        })
+        .collect();
+    let input_sets = vec![
+        DandelionSet {
+            ident: "small",
+            items: vec![DandelionItem {
+                ident: "only",
+                key: 0,
+                data: vec![42],
+            }],
+        },
+        DandelionSet {
+            ident: "large",
+            items,
+        },
+    ];
+    let setup = initialize_dandelion(16 * 4096, input_sets, Vec::new());
+    let find_set = |name: &str| unsafe {
+        dandelion_find_input_set(name.as_ptr() as *const c_char, name.len())
+    };
+    let find_item = |set: size_t, name: &str| unsafe {
+        let buffer = dandelion_find_input(set, name.as_ptr() as *const c_char, name.len());
+        buffer.as_ref().map(|buffer| *(buffer.data as *const u8))
+    };
+    assert_eq!(0, find_set("small"));
+    assert_eq!(1, find_set("large"));
+    assert_eq!(usize::MAX, find_set("missing"));
+    assert_eq!(Some(42), find_item(0, "only"));
+    assert_eq!(None, find_item(0, "item_1"));
+    for index in 0..100 {
+        assert_eq!(Some(index as u8), find_item(1, &format!("item_{}", index)));
+    }
+    assert_eq!(None, find_item(1, "item_100"));
+    assert_eq!(None, find_item(2, "only"));
+    dandelion_exit_check!(setup, "Lookups should not cause errors");
+}
+
+#[test]
+fn test_find_input_without_memory() {
+    let items = (0..100)
+        .map(|index| DandelionItem {
+            ident: Box::leak(format!("item_{}", index).into_boxed_str()),
+            key: 0,
+            data: vec![index as u8],
+        })
+        .collect();
+    let input_sets = vec![DandelionSet {
+        ident: "large",
+        items,
+    }];
+    let setup = initialize_dandelion(16 * 4096, input_sets, Vec::new());
+    // use up the heap so the lookup tables can not be allocated
+    let mut allocations = Vec::new();
+    for allocation_size in [4096, 8] {
+        loop {
+            let allocation = unsafe { dandelion_alloc(allocation_size, 8) };
+            if allocation.is_null() {
+                break;
+            }
+            allocations.push(allocation);
+        }
+    }
+    let find_item = |name: &str| unsafe {
+        let buffer = dandelion_find_input(0, name.as_ptr() as *const c_char, name.len());
+        buffer.as_ref().map(|buffer| *(buffer.data as *const u8))
+    };
+    assert_eq!(Some(7), find_item("item_7"));
+    // once the allocation failed, lookups keep scanning instead of retrying
+    let page = allocations[0];
+    unsafe { dandelion_free(page) };
+    for index in 0..100 {
+        assert_eq!(Some(index as u8), find_item(&format!("item_{}", index)));
+    }
+    assert_eq!(None, find_item("item_100"));
+    let reallocated = unsafe { dandelion_alloc(4096, 8) };
+    assert!(!reallocated.is_null(), "Lookups should not allocate again");
+    allocations[0] = reallocated;
+    for allocation in allocations {
+        unsafe { dandelion_free(allocation) };
+    }
+    dandelion_exit_check!(setup, "Lookups should not cause errors");
+}
+
+#[test]
+fn test_input_keys() {
+    // keys go in descending order with three items each, data is the position in the set
+    let items = (0..30)
+        .map(|index| DandelionItem {
+            ident: "item",
+            key: 100 - index / 3,
+            data: vec![index as u8],
+        })
+        .collect();
+    let input_sets = vec![DandelionSet {
+        ident: "shuffle",
+        items,
+    }];
+    let setup = initialize_dandelion(16 * 4096, input_sets, Vec::new());
+    let group_data = |buffers: *const *const IoBuffer, count: size_t| -> Vec<(usize, u8)> {
+        (0..count)
+            .map(|index| unsafe {
+                let buffer = &**buffers.add(index);
+                (buffer.key, *(buffer.data as *const u8))
+            })
+            .collect()
+    };
+    assert_eq!(10, unsafe { dandelion_input_key_count(0) });
+    let mut count = 0;
+    for key_idx in 0..10 {
+        let group = unsafe { dandelion_input_key_group(0, key_idx, &mut count) };
+        // ascending keys, items keep their order in the set
+        let position = (27 - 3 * key_idx) as u8;
+        let key = 91 + key_idx;
+        assert_eq!(
+            vec![(key, position), (key, position + 1), (key, position + 2)],
+            group_data(group, count)
+        );
+    }
+    assert!(unsafe { dandelion_input_key_group(0, 10, &mut count) }.is_null());
+    assert_eq!(0, count);
+    let group = unsafe { dandelion_find_inputs_by_key(0, 95, &mut count) };
+    assert_eq!(vec![(95, 15), (95, 16), (95, 17)], group_data(group, count));
+    assert!(unsafe { dandelion_find_inputs_by_key(0, 90, &mut count) }.is_null());
+    assert!(unsafe { dandelion_find_inputs_by_key(0, 101, &mut count) }.is_null());
+    assert_eq!(0, unsafe { dandelion_input_key_count(1) });
+    dandelion_exit_check!(setup, "Key lookups should not cause errors");
+}
+
+#[test]
+fn test_outputs() {
+    // interleave adds to several sets so segments have to move while growing
+    let setup = initialize_dandelion(16 * 4096, Vec::new(), vec!["first", "second", "third"]);
+    let idents: Vec<&'static str> = (0..50)
+        .map(|index| &*Box::leak(format!("item_{}", index).into_boxed_str()))
+        .collect();
+    let data: Vec<u8> = (0..50).collect();
+    let add = |set_idx: size_t, index: usize| unsafe {
+        dandelion_add_output(
+            set_idx,
+            IoBuffer {
+                ident: idents[index].as_ptr() as *const c_char,
+                ident_len: idents[index].len(),
+                data: data[index..].as_ptr() as *const c_void,
+                data_len: 1,
+                key: 0,
+            },
+        )
+    };
+    assert_eq!(0, unsafe { dandelion_reserve_outputs(2, 3) });
+    for index in 0..50 {
+        add(index % 2, index);
+        if index % 10 == 0 {
+            add(2, index);
+        }
+    }
+    assert_eq!(-1, unsafe { dandelion_reserve_outputs(3, 1) });
+    // batch of the same buffer added at once
+    let batch: Vec<IoBuffer> = (0..20)
+        .map(|_| IoBuffer {
+            ident: "batch".as_ptr() as *const c_char,
+            ident_len: 5,
+            data: data.as_ptr() as *const c_void,
+            data_len: 50,
+            key: 0,
+        })
+        .collect();
+    assert_eq!(0, unsafe {
+        dandelion_add_outputs(1, batch.as_ptr(), batch.len())
+    });
+    assert_eq!(-1, unsafe { dandelion_add_outputs(3, batch.as_ptr(), 1) });
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+    assert_eq!(Some(&data[..]), setup.get_item_data("second", "batch"));
+    for index in 0..50 {
+        let set = if index % 2 == 0 { "first" } else { "second" };
+        assert_eq!(
+            Some(&data[index..index + 1]),
+            setup.get_item_data(set, idents[index])
+        );
+        let in_third = setup.get_item_data("third", idents[index]);
+        if index % 10 == 0 {
+            assert_eq!(Some(&data[index..index + 1]), in_third);
+        } else {
+            assert_eq!(None, in_third);
+        }
+    }
+}
+
+#[test]
+fn test_alloc_output() {
+    let mut setup = initialize_dandelion(16 * 4096, Vec::new(), vec!["out"]);
+    let region = setup.enable_output_region(4096);
+    let alloc = |ident: &str, size: usize| unsafe {
+        dandelion_alloc_output(0, ident.as_ptr() as *const c_char, ident.len(), size) as *mut u8
+    };
+    let first = alloc("first", 100);
+    let second = alloc("second", 200);
+    for (data, size, value) in [(first, 100, 1u8), (second, 200, 2u8)] {
+        assert!(region.contains(&(data as usize)));
+        unsafe { core::ptr::write_bytes(data, value, size) };
+    }
+    assert!(second as usize >= first as usize + 100 + "first".len());
+    let used = setup.output_region_used();
+    assert!(used >= 300 + "firstsecond".len() && used <= 4096);
+    // does not fit anymore
+    assert!(alloc("third", 4096).is_null());
+    assert!(unsafe { dandelion_alloc_output(1, null(), 0, 1) }.is_null());
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+    assert_eq!(Some(&[1u8; 100][..]), setup.get_item_data("out", "first"));
+    assert_eq!(Some(&[2u8; 200][..]), setup.get_item_data("out", "second"));
+    assert_eq!(None, setup.get_item_data("out", "third"));
+}
+
+#[test]
+fn test_container() {
+    let mut setup = initialize_dandelion(16 * 4096, Vec::new(), vec!["out"]);
+    setup.enable_output_region(4096);
+    let records: Vec<Vec<u8>> = (0..100u8)
+        .map(|index| vec![index; index as usize % 7])
+        .collect();
+    let mut writer = DandelionContainerWriter {
+        offsets: core::ptr::null_mut(),
+        offsets_cap: 0,
+        payload: core::ptr::null_mut(),
+        payload_cap: 0,
+        record_count: 0,
+    };
+    // start small so adding has to grow both arrays
+    assert_eq!(0, unsafe {
+        dandelion_container_writer_init(&mut writer, 1, 1)
+    });
+    for record in records.iter() {
+        assert_eq!(0, unsafe {
+            dandelion_container_add(&mut writer, record.as_ptr() as *const c_void, record.len())
+        });
+    }
+    let size = unsafe { dandelion_container_size(&writer) };
+    let payload_size: usize = records.iter().map(|record| record.len()).sum();
+    assert_eq!(16 + 101 * 8 + payload_size, size);
+    // serialize at an odd address to check unaligned access
+    let mut serialized = vec![0u8; size + 1];
+    unsafe { dandelion_container_write(&writer, serialized[1..].as_mut_ptr() as *mut c_void) };
+    let data = &serialized[1..];
+    let mut container = DandelionContainer {
+        offsets: null(),
+        payload: null(),
+        record_count: 0,
+    };
+    assert_eq!(0, unsafe {
+        dandelion_container_open(&mut container, data.as_ptr() as *const c_void, data.len())
+    });
+    assert_eq!(records.len(), container.record_count);
+    let offset = |index: usize| unsafe {
+        (container.offsets.add(8 * index) as *const u64).read_unaligned() as usize
+    };
+    for (index, record) in records.iter().enumerate() {
+        let stored = unsafe {
+            slice::from_raw_parts(
+                container.payload.add(offset(index)),
+                offset(index + 1) - offset(index),
+            )
+        };
+        assert_eq!(&record[..], stored);
+    }
+    // truncated, wrong magic and decreasing offsets are rejected
+    let mut open = |bytes: &[u8]| unsafe {
+        dandelion_container_open(&mut container, bytes.as_ptr() as *const c_void, bytes.len())
+    };
+    assert_eq!(-1, open(&data[..size - 1]));
+    assert_eq!(-1, open(&data[..15]));
+    let mut corrupted = data.to_vec();
+    corrupted[0] ^= 1;
+    assert_eq!(-1, open(&corrupted));
+    let mut corrupted = data.to_vec();
+    corrupted[16 + 8 * 50..16 + 8 * 51].copy_from_slice(&u64::MAX.to_le_bytes());
+    assert_eq!(-1, open(&corrupted));
+    let mut corrupted = data.to_vec();
+    corrupted[8..16].copy_from_slice(&u64::MAX.to_le_bytes());
+    assert_eq!(-1, open(&corrupted));
+    // plain outputs stay unflagged even if they look like a container
+    let plain = data.to_vec();
+    unsafe {
+        dandelion_add_output(
+            0,
+            IoBuffer {
+                ident: "plain".as_ptr() as *const c_char,
+                ident_len: 5,
+                data: plain.as_ptr() as *mut c_void,
+                data_len: plain.len(),
+                key: 0,
+            },
+        )
+    };
+    assert_eq!(0, unsafe {
+        dandelion_container_output(&writer, 0, "packed".as_ptr() as *const c_char, 6)
+    });
+    assert_eq!(-1, unsafe {
+        dandelion_container_output(&writer, 1, "packed".as_ptr() as *const c_char, 6)
+    });
+    unsafe { dandelion_container_writer_free(&mut writer) };
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+    assert_eq!(Some(data), setup.get_item_data("out", "packed"));
+    assert_eq!(Some(&[0u8, 1][..]), setup.output_flags());
+}
+
+#[test]
+fn test_ascii_length() {
+    let setup = initialize_dandelion(16 * 4096, Vec::new(), Vec::new());
+    // hit every position inside and after the vector blocks, with bytes that
+    // only differ from ASCII in the top bit
+    let mut data = vec![b'a'; 100];
+    for non_ascii in [0x80, 0xe1, 0xff] {
+        for position in 0..100 {
+            data[position] = non_ascii;
+            for len in 0..100 {
+                let ascii = unsafe { dandelion_ascii_length(data.as_ptr() as *const c_char, len) };
+                assert_eq!(position.min(len), ascii);
+            }
+            data[position] = b'a';
+        }
+    }
+    let text = "plain ascii text that is longer than a block, then \u{e9}t\u{e9}";
+    let ascii = unsafe { dandelion_ascii_length(text.as_ptr() as *const c_char, text.len()) };
+    assert_eq!(text.find('\u{e9}').unwrap(), ascii);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+}
+
+#[test]
+fn test_utf8_length() {
+    let setup = initialize_dandelion(16 * 4096, Vec::new(), Vec::new());
+    // characters of every length placed across the block boundaries, each
+    // followed by the invalid forms that differ from valid ones the least
+    let characters: [&[u8]; 5] = [
+        b"a",
+        b"\xc3\xa9",
+        b"\xe2\x82\xac",
+        b"\xf0\x9d\x84\x9e",
+        b"\xf4\x8f\xbf\xbf",
+    ];
+    let invalid: [&[u8]; 12] = [
+        b"\x80",
+        b"\xbf",
+        b"\xc1\xbf",
+        b"\xc3a",
+        b"\xe0\x9f\xbf",
+        b"\xed\xa0\x80",
+        b"\xe2\x82a",
+        b"\xf0\x8f\xbf\xbf",
+        b"\xf4\x90\x80\x80",
+        b"\xf5\x80\x80\x80",
+        b"\xf0\x9d\x84a",
+        b"\xff",
+    ];
+    for character in characters {
+        for offset in 0..40 {
+            let mut data = vec![b'a'; offset];
+            data.extend_from_slice(character);
+            let valid = data.len();
+            data.extend_from_slice(b"bcdefghijklmnopqrstuvwxyz");
+            for len in 0..data.len() {
+                let expected = if len < valid && len >= offset {
+                    offset
+                } else {
+                    len
+                };
+                let found = unsafe { dandelion_utf8_length(data.as_ptr() as *const c_char, len) };
+                assert_eq!(expected, found);
+            }
+            for form in invalid {
+                let mut data = data[..valid].to_vec();
+                data.extend_from_slice(form);
+                data.extend_from_slice(&[b'a'; 40]);
+                let found =
+                    unsafe { dandelion_utf8_length(data.as_ptr() as *const c_char, data.len()) };
+                assert_eq!(valid, found);
+            }
+        }
+    }
+    let text = "plain ascii text that is longer than a block, then \u{e9}t\u{e9} \u{20ac}";
+    let found = unsafe { dandelion_utf8_length(text.as_ptr() as *const c_char, text.len()) };
+    assert_eq!(text.len(), found);
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+}
+
+#[test]
+fn test_clock() {
+    let mut setup = initialize_dandelion(16 * 4096, Vec::new(), Vec::new());
+    // without a frequency ticks since init count as nanoseconds
+    let before = unsafe { dandelion_monotonic_ns() };
+    let after = unsafe { dandelion_monotonic_ns() };
+    assert!(before <= after);
+    assert_eq!(1, unsafe { dandelion_clock_resolution_ns() });
+    // two ticks per nanosecond
+    let base = unsafe { dandelion_ticks() };
+    let realtime_base = 1_700_000_000_000_000_000;
+    setup.set_clock(2_000_000_000, base, realtime_base);
+    let first_ticks = unsafe { dandelion_ticks() };
+    let monotonic = unsafe { dandelion_monotonic_ns() };
+    let realtime = unsafe { dandelion_realtime_ns() };
+    let last_ticks = unsafe { dandelion_ticks() };
+    assert!((first_ticks - base) / 2 <= monotonic);
+    assert!(monotonic <= realtime - realtime_base);
+    assert!(realtime - realtime_base <= (last_ticks - base) / 2);
+    assert_eq!(1, unsafe { dandelion_clock_resolution_ns() });
+    // a slow counter has a coarser resolution
+    setup.set_clock(30_000_000, 0, 0);
+    assert_eq!(34, unsafe { dandelion_clock_resolution_ns() });
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+}
+
+#[test]
+fn test_phases() {
+    let setup = initialize_dandelion(16 * 4096, Vec::new(), vec!["dandelion_phases"]);
+    // static destructors
+    unsafe { dandelion_mark_phase(4) };
+    unsafe { dandelion_mark_phase(42) };
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+    let text =
+        core::str::from_utf8(setup.get_item_data("dandelion_phases", "phases").unwrap()).unwrap();
+    let phases: Vec<&str> = text
+        .lines()
+        .map(|line| {
+            let (name, nanoseconds) = line.split_once(' ').unwrap();
+            nanoseconds.parse::<u64>().unwrap();
+            name
+        })
+        .collect();
+    assert_eq!(vec!["init", "main", "destructors", "exit"], phases);
+}
+
+#[test]
+fn test_records() {
+    let setup = initialize_dandelion(16 * 4096, Vec::new(), Vec::new());
+    // hit every position inside and after the vector blocks
+    let mut data = vec![b'a'; 100];
+    for position in 0..100 {
+        data[position] = b'\n';
+        for len in 0..100 {
+            let found = unsafe {
+                dandelion_find_byte(data.as_ptr() as *const c_char, len, b'\n' as c_char)
+            };
+            if position < len {
+                assert_eq!(
+                    unsafe { data.as_ptr().add(position) } as *const c_char,
+                    found
+                );
+            } else {
+                assert!(found.is_null());
+            }
+        }
+        data[position] = b'a';
+    }
+    let text: Vec<u8> = (0..60)
+        .flat_map(|index| {
+            let mut line = vec![b'0' + (index % 10) as u8; index % 45];
+            line.push(b'\n');
+            line
+        })
+        .chain(b"no newline".iter().copied())
+        .collect();
+    let expected: Vec<&[u8]> = text.split(|byte| *byte == b'\n').collect();
+    let mut reader = DandelionRecordReader {
+        data: null(),
+        end: null(),
+        carry: core::ptr::null_mut(),
+        carry_len: 0,
+        carry_cap: 0,
+        carry_returned: 0,
+        delimiter: 0,
+    };
+    // feed the text in chunks of different sizes, so records span chunks
+    for chunk_size in [1, 7, 32, 100, text.len()] {
+        unsafe { dandelion_records_init(&mut reader, b'\n' as c_char) };
+        let mut records: Vec<Vec<u8>> = Vec::new();
+        let mut record = null();
+        let mut len = 0;
+        for chunk in text.chunks(chunk_size) {
+            unsafe {
+                dandelion_records_feed(&mut reader, chunk.as_ptr() as *const c_void, chunk.len())
+            };
+            loop {
+                let status = unsafe { dandelion_records_next(&mut reader, &mut record, &mut len) };
+                assert!(status >= 0);
+                if status == 0 {
+                    break;
+                }
+                records.push(unsafe { slice::from_raw_parts(record as *const u8, len) }.to_vec());
+            }
+        }
+        assert_eq!(1, unsafe {
+            dandelion_records_finish(&mut reader, &mut record, &mut len)
+        });
+        records.push(unsafe { slice::from_raw_parts(record as *const u8, len) }.to_vec());
+        assert_eq!(0, unsafe {
+            dandelion_records_finish(&mut reader, &mut record, &mut len)
+        });
+        assert_eq!(expected, records);
+        unsafe { dandelion_records_free(&mut reader) };
+    }
+    for ranges in [1, 2, 3, 8, 200] {
+        let mut bounds = vec![0; ranges + 1];
+        unsafe {
+            dandelion_split_records(
+                text.as_ptr() as *const c_char,
+                text.len(),
+                b'\n' as c_char,
+                ranges,
+                bounds.as_mut_ptr(),
+            )
+        };
+        assert_eq!(0, bounds[0]);
+        assert_eq!(text.len(), bounds[ranges]);
+        for range in 1..ranges {
+            assert!(bounds[range - 1] <= bounds[range]);
+            let bound = bounds[range];
+            assert!(bound == 0 || bound == text.len() || text[bound - 1] == b'\n');
+        }
+    }
+    unsafe { dandelion_exit(0) };
+    dandelion_exit_check!(setup, "Should exit without errors");
+}
@@ -0,0 +1,211 @@
+#include <iconv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// size of each generated text in bytes
+#define TEXT_SIZE (8 << 20)
+// conversions are repeated and the fastest round counts, as a single round is
+// easily disturbed by other work on the machine
+#define ROUNDS 5
+
+/*
+    UTF-8 input is only validated character by character outside of ASCII
+    runs, which are skipped a block at a time. The texts go from plain ASCII
+    to scripts without any ASCII letters, so the output shows how close each
+    gets to copying memory and how much the character loop costs when the
+    runs get short.
+*/
+
+typedef struct Check {
+  const char *to;
+  const char *from;
+  const char *in;
+  size_t in_len;
+  const char *out;
+  size_t out_len;
+} Check;
+
+static const Check checks[] = {
+    {"UTF-16LE", "UTF-8", "a\xc3\xa9\xe2\x82\xac", 6, "a\0\xe9\0\xac\x20", 6},
+    {"UTF-8", "UTF-16BE", "\xd8\x34\xdd\x1e", 4, "\xf0\x9d\x84\x9e", 4},
+    {"UTF-8", "LATIN1", "caf\xe9", 4, "caf\xc3\xa9", 5},
+    {"UTF-32LE", "UTF-8", "ab", 2, "a\0\0\0b\0\0\0", 8},
+};
+
+static int self_check(void) {
+  for (size_t index = 0; index < sizeof(checks) / sizeof(checks[0]); index++) {
+    const Check *check = &checks[index];
+    iconv_t converter = iconv_open(check->to, check->from);
+    if (converter == (iconv_t)-1) {
+      printf("failed to open %s to %s\n", check->from, check->to);
+      return -1;
+    }
+    char out[16];
+    char *in_pos = (char *)check->in;
+    char *out_pos = out;
+    size_t in_left = check->in_len;
+    size_t out_left = sizeof(out);
+    size_t result = iconv(converter, &in_pos, &in_left, &out_pos, &out_left);
+    iconv_close(converter);
+    if (result != 0 || (size_t)(out_pos - out) != check->out_len ||
+        memcmp(out, check->out, check->out_len) != 0) {
+      printf("unexpected conversion from %s to %s\n", check->from,
+             check->to);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// lines of random words in UTF-8, separated by spaces
+static size_t generate_text(char *text, size_t size,
+                            const char *const *words, size_t word_count) {
+  unsigned int seed = 42;
+  size_t len = 0;
+  size_t column = 0;
+  while (len + 64 < size) {
+    seed = seed * 1103515245 + 12345;
+    const char *word = words[(seed >> 8) % word_count];
+    size_t word_len = strlen(word);
+    memcpy(text + len, word, word_len);
+    len += word_len;
+    column += word_len + 1;
+    text[len++] = column > 72 ? '\n' : ' ';
+    column = column > 72 ? 0 : column;
+  }
+  return len;
+}
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// convert the whole input in one call, returns the number of bytes written
+// or 0 if the conversion failed
+static size_t run(const char *name, const char *to, const char *from,
+                  const char *in, size_t in_len, char *out, size_t out_size) {
+  iconv_t converter = iconv_open(to, from);
+  if (converter == (iconv_t)-1) {
+    printf("failed to open %s to %s\n", from, to);
+    return 0;
+  }
+  double best = 0;
+  size_t written = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    char *in_pos = (char *)in;
+    char *out_pos = out;
+    size_t in_left = in_len;
+    size_t out_left = out_size;
+    iconv(converter, NULL, NULL, NULL, NULL);
+    double start = seconds();
+    size_t result = iconv(converter, &in_pos, &in_left, &out_pos, &out_left);
+    double elapsed = seconds() - start;
+    if (result != 0 || in_left != 0) {
+      printf("%-10s %-8s to %-8s failed\n", name, from, to);
+      iconv_close(converter);
+      return 0;
+    }
+    best = round == 0 || elapsed < best ? elapsed : best;
+    written = out_pos - out;
+  }
+  iconv_close(converter);
+  printf("%-10s %-8s to %-8s %10.1f MB/s\n", name, from, to,
+         in_len / best / 1e6);
+  return written;
+}
+
+// throughput of copying the text, the limit for the conversion to UTF-8
+static void run_copy(const char *name, const char *in, size_t in_len,
+                     char *out) {
+  double best = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    double start = seconds();
+    memcpy(out, in, in_len);
+    double elapsed = seconds() - start;
+    best = round == 0 || elapsed < best ? elapsed : best;
+  }
+  printf("%-10s %-20s %10.1f MB/s\n", name, "memcpy", in_len / best / 1e6);
+}
+
+static const char *const english[] = {
+    "the",   "quick", "brown",     "fox",      "jumps", "over",
+    "lazy",  "dog",   "transcode", "encoding", "text",  "of",
+    "corpus", "and",  "a",         "byte",
+};
+static const char *const french[] = {
+    "le",     "caf\xc3\xa9", "\xc3\xa9t\xc3\xa9", "tr\xc3\xa8s", "et",
+    "la",     "for\xc3\xaat", "na\xc3\xaf" "f",   "o\xc3\xb9",   "des",
+    "gar\xc3\xa7on", "un",   "texte",             "avec",        "mot",
+    "fran\xc3\xa7" "ais",
+};
+static const char *const russian[] = {
+    "\xd0\xb8",
+    "\xd0\xb2",
+    "\xd0\xbd\xd0\xb5",
+    "\xd1\x82\xd0\xb5\xd0\xba\xd1\x81\xd1\x82",
+    "\xd1\x81\xd0\xbb\xd0\xbe\xd0\xb2\xd0\xbe",
+    "\xd0\xb4\xd0\xbe\xd0\xbc",
+    "\xd0\xbc\xd0\xb8\xd1\x80",
+    "\xd0\xb1\xd0\xb0\xd0\xb9\xd1\x82",
+};
+static const char *const chinese[] = {
+    "\xe6\x96\x87\xe6\x9c\xac",
+    "\xe7\xbc\x96\xe7\xa0\x81",
+    "\xe8\xbd\xac\xe6\x8d\xa2",
+    "\xe5\xad\x97\xe8\x8a\x82",
+    "\xe6\x95\xb0\xe6\x8d\xae",
+    "\xe7\x9a\x84",
+};
+
+typedef struct Corpus {
+  const char *name;
+  const char *const *words;
+  size_t word_count;
+} Corpus;
+
+int main(void) {
+  if (self_check() != 0) {
+    return 1;
+  }
+  char *text = malloc(TEXT_SIZE);
+  char *wide = malloc(4 * TEXT_SIZE);
+  char *back = malloc(TEXT_SIZE);
+  if (text == NULL || wide == NULL || back == NULL) {
+    return 2;
+  }
+  // fault the output pages in before timing anything
+  memset(wide, 0, 4 * TEXT_SIZE);
+  memset(back, 0, TEXT_SIZE);
+  const Corpus corpora[] = {
+      {"english", english, sizeof(english) / sizeof(english[0])},
+      {"french", french, sizeof(french) / sizeof(french[0])},
+      {"russian", russian, sizeof(russian) / sizeof(russian[0])},
+      {"chinese", chinese, sizeof(chinese) / sizeof(chinese[0])},
+  };
+  int failed = 0;
+  for (size_t index = 0; index < sizeof(corpora) / sizeof(corpora[0]);
+       index++) {
+    const Corpus *corpus = &corpora[index];
+    size_t len =
+        generate_text(text, TEXT_SIZE, corpus->words, corpus->word_count);
+    run_copy(corpus->name, text, len, back);
+    failed |= run(corpus->name, "UTF-8", "UTF-8", text, len, back,
+                  TEXT_SIZE) != len;
+    size_t wide_len =
+        run(corpus->name, "UTF-16LE", "UTF-8", text, len, wide, 4 * TEXT_SIZE);
+    failed |= wide_len == 0;
+    failed |= run(corpus->name, "UTF-8", "UTF-16LE", wide, wide_len, back,
+                  TEXT_SIZE) != len;
+    failed |= memcmp(text, back, len) != 0;
+    failed |= run(corpus->name, "UTF-32LE", "UTF-8", text, len, wide,
+                  4 * TEXT_SIZE) == 0;
+  }
+  free(text);
+  free(wide);
+  free(back);
+  return failed ? 3 : 0;
+}
@@ -1,9 +1,638 @@
 #include <errno.h>
+#include <fnmatch.h>
+#include <glob.h>
+#include <iconv.h>
+#include <regex.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 
 #include "unistd.h"
 
+static int write_file(const char *path, const char *content) {
+  size_t length = strlen(content);
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    return -1;
+  }
+  size_t written = fwrite(content, 1, length, file);
+  if (fclose(file) != 0 || written != length) {
+    return -1;
+  }
+  return 0;
+}
+
+// read the next record and compare it to the expected one, NULL expects the
+// end of the file
+static int expect_record(char **line, size_t *size, int delimiter,
+                         FILE *file, const char *expected) {
+  ssize_t length = getdelim(line, size, delimiter, file);
+  if (expected == NULL) {
+    return length == -1 && feof(file) ? 0 : -1;
+  }
+  size_t expected_length = strlen(expected);
+  if (length != (ssize_t)expected_length || *size <= expected_length ||
+      memcmp(*line, expected, expected_length + 1) != 0) {
+    printf("getdelim read %zd bytes instead of %s\n", length, expected);
+    return -1;
+  }
+  return 0;
+}
+
+// getdelim takes lines straight from the file when nothing is buffered and
+// goes through the stream buffer otherwise, both need to give the same lines
+static int test_getdelim(void) {
+  static char long_line[10001];
+  memset(long_line, 'x', sizeof(long_line) - 2);
+  long_line[sizeof(long_line) - 2] = '\n';
+  if (write_file("getline_long", long_line) != 0 ||
+      write_file("getline_empty", "") != 0 ||
+      write_file("getline_lines", "first\nsecond line\nlast") != 0 ||
+      write_file("getline_fields", "a:bc::d") != 0) {
+    return -1;
+  }
+
+  // a NULL line is allocated, a too small one grows
+  char *line = NULL;
+  size_t size = 0;
+  FILE *file = fopen("getline_lines", "r");
+  if (file == NULL || expect_record(&line, &size, '\n', file, "first\n") ||
+      expect_record(&line, &size, '\n', file, "second line\n") ||
+      expect_record(&line, &size, '\n', file, "last") ||
+      expect_record(&line, &size, '\n', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+  free(line);
+  size = 2;
+  line = malloc(size);
+  file = fopen("getline_long", "r");
+  if (line == NULL || file == NULL ||
+      expect_record(&line, &size, '\n', file, long_line) ||
+      expect_record(&line, &size, '\n', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+
+  // an empty file has no lines
+  file = fopen("getline_empty", "r");
+  if (file == NULL || expect_record(&line, &size, '\n', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+
+  // with a byte already buffered the rest comes from a small stream buffer
+  // that is refilled several times within the long line
+  file = fopen("getline_long", "r");
+  if (file == NULL || setvbuf(file, NULL, _IOFBF, 16) != 0 ||
+      fgetc(file) != 'x' ||
+      expect_record(&line, &size, '\n', file, long_line + 1) ||
+      expect_record(&line, &size, '\n', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+  file = fopen("getline_lines", "r");
+  if (file == NULL || setvbuf(file, NULL, _IOFBF, 4) != 0 ||
+      fgetc(file) != 'f' || expect_record(&line, &size, '\n', file, "irst\n") ||
+      expect_record(&line, &size, '\n', file, "second line\n") ||
+      expect_record(&line, &size, '\n', file, "last") ||
+      expect_record(&line, &size, '\n', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+
+  // other delimiters, on both paths
+  file = fopen("getline_fields", "r");
+  if (file == NULL || expect_record(&line, &size, ':', file, "a:") ||
+      expect_record(&line, &size, ':', file, "bc:") ||
+      expect_record(&line, &size, ':', file, ":") ||
+      expect_record(&line, &size, ':', file, "d") ||
+      expect_record(&line, &size, ':', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+  file = fopen("getline_fields", "r");
+  if (file == NULL || fgetc(file) != 'a' ||
+      expect_record(&line, &size, ':', file, ":") ||
+      expect_record(&line, &size, ':', file, "bc:") ||
+      expect_record(&line, &size, ':', file, ":") ||
+      expect_record(&line, &size, ':', file, "d") ||
+      expect_record(&line, &size, ':', file, NULL)) {
+    return -1;
+  }
+  fclose(file);
+  free(line);
+  return 0;
+}
+
+// match string against pattern and compare the whole match and the first
+// subexpression to the expected offsets, a start of -1 expects no match or
+// an unset subexpression
+static int expect_regex(const char *pattern, int cflags, const char *string,
+                        int eflags, regoff_t start, regoff_t end,
+                        regoff_t sub_start, regoff_t sub_end) {
+  regex_t regex;
+  int error = regcomp(&regex, pattern, cflags);
+  if (error != 0) {
+    printf("regcomp of %s failed with %d\n", pattern, error);
+    return -1;
+  }
+  regmatch_t matches[2];
+  error = regexec(&regex, string, 2, matches, eflags);
+  regfree(&regex);
+  if (start == -1) {
+    if (error != REG_NOMATCH) {
+      printf("%s should not match %s\n", pattern, string);
+      return -1;
+    }
+    return 0;
+  }
+  if (error != 0 || matches[0].rm_so != start || matches[0].rm_eo != end ||
+      matches[1].rm_so != sub_start || matches[1].rm_eo != sub_end) {
+    printf("%s matched %s with %d at %lld-%lld and %lld-%lld\n", pattern,
+           string, error, (long long)matches[0].rm_so,
+           (long long)matches[0].rm_eo, (long long)matches[1].rm_so,
+           (long long)matches[1].rm_eo);
+    return -1;
+  }
+  return 0;
+}
+
+static int expect_regcomp_error(const char *pattern, int cflags,
+                                int expected) {
+  regex_t regex;
+  int error = regcomp(&regex, pattern, cflags);
+  if (error == 0) {
+    regfree(&regex);
+  }
+  if (error != expected) {
+    printf("regcomp of %s returned %d instead of %d\n", pattern, error,
+           expected);
+    return -1;
+  }
+  return 0;
+}
+
+static int test_regex(void) {
+  // bracket expressions and named classes
+  if (expect_regex("[[:digit:]]+", REG_EXTENDED, "ab123c", 0, 2, 5, -1, -1) ||
+      expect_regex("[^[:alpha:]_]+", REG_EXTENDED, "ab_12;c", 0, 3, 6, -1,
+                   -1) ||
+      expect_regex("[]a-]+", REG_EXTENDED, "x]-a]y", 0, 1, 5, -1, -1) ||
+      expect_regex("([[:upper:][:space:]]+)x", REG_EXTENDED, "ab C Dx", 0, 2,
+                   7, 2, 6) ||
+      expect_regex("[[:alpha:]]", REG_EXTENDED, "123", 0, -1, -1, -1, -1) ||
+      expect_regex("abc", REG_EXTENDED | REG_ICASE, "xABC", 0, 1, 4, -1,
+                   -1)) {
+    return -1;
+  }
+  // basic expressions with intervals and back-references
+  if (expect_regex("a\\{2,3\\}", 0, "aaaa", 0, 0, 3, -1, -1) ||
+      expect_regex("x\\{2\\}", 0, "xxx", 0, 0, 2, -1, -1) ||
+      expect_regex("a{2}", 0, "aa a{2}", 0, 3, 7, -1, -1) ||
+      expect_regex("\\(ab\\)\\1", 0, "xababy", 0, 1, 5, 1, 3) ||
+      expect_regex("\\(a*\\)b\\1", 0, "aabaa", 0, 0, 5, 0, 2) ||
+      expect_regex("\\(a*\\)b\\1", 0, "aaba", 0, 1, 4, 1, 2) ||
+      expect_regex("\\(ab\\)\\1", 0, "abba", 0, -1, -1, -1, -1)) {
+    return -1;
+  }
+  // anchors with and without REG_NEWLINE, REG_NOTBOL and REG_NOTEOL
+  if (expect_regex("^b.*$", REG_NEWLINE, "a\nbc\nd", 0, 2, 4, -1, -1) ||
+      expect_regex("^b.*$", 0, "a\nbc\nd", 0, -1, -1, -1, -1) ||
+      expect_regex("a.c", 0, "a\nc", 0, 0, 3, -1, -1) ||
+      expect_regex("a.c", REG_NEWLINE, "a\nc", 0, -1, -1, -1, -1) ||
+      expect_regex("^a", 0, "abc", REG_NOTBOL, -1, -1, -1, -1) ||
+      expect_regex("^a", REG_NEWLINE, "xa\nab", REG_NOTBOL, 3, 4, -1, -1) ||
+      expect_regex("c$", 0, "abc", REG_NOTEOL, -1, -1, -1, -1) ||
+      expect_regex("c$", REG_NEWLINE, "abc\nd", REG_NOTEOL, 2, 3, -1, -1)) {
+    return -1;
+  }
+
+  // REG_STARTEND only looks at the given range, which may hold a zero byte,
+  // offsets stay relative to the string
+  regex_t regex;
+  regmatch_t match;
+  if (regcomp(&regex, "^b[^x]c$", REG_EXTENDED) != 0) {
+    return -1;
+  }
+  match.rm_so = 2;
+  match.rm_eo = 5;
+  int error = regexec(&regex, "xxb\0cxx", 1, &match, REG_STARTEND);
+  regfree(&regex);
+  if (error != 0 || match.rm_so != 2 || match.rm_eo != 5) {
+    printf("REG_STARTEND matched with %d at %lld-%lld\n", error,
+           (long long)match.rm_so, (long long)match.rm_eo);
+    return -1;
+  }
+
+  // telling if the eleventh byte from the end is an a needs more DFA states
+  // than are cached, so the cache is started over while scanning
+  static char long_string[4097];
+  uint32_t random = 1;
+  for (size_t index = 0; index < sizeof(long_string) - 1; index++) {
+    random = random * 1103515245 + 12345;
+    long_string[index] = (random >> 16) & 1 ? 'a' : 'b';
+  }
+  size_t long_length = sizeof(long_string) - 1;
+  for (int matching = 0; matching < 2; matching++) {
+    long_string[long_length - 11] = matching ? 'a' : 'b';
+    if (regcomp(&regex, "a[ab]{10}$", REG_EXTENDED | REG_NOSUB) != 0) {
+      return -1;
+    }
+    error = regexec(&regex, long_string, 0, NULL, 0);
+    regfree(&regex);
+    if (error != (matching ? 0 : REG_NOMATCH)) {
+      printf("long match only scan returned %d\n", error);
+      return -1;
+    }
+    if (expect_regex("a[ab]{10}$", REG_EXTENDED, long_string, 0,
+                     matching ? (regoff_t)long_length - 11 : -1,
+                     (regoff_t)long_length, -1, -1)) {
+      return -1;
+    }
+  }
+
+  // errors and their messages
+  if (expect_regcomp_error("a\\{1", 0, REG_EBRACE) ||
+      expect_regcomp_error("(ab", REG_EXTENDED, REG_EPAREN) ||
+      expect_regcomp_error("[ab", REG_EXTENDED, REG_EBRACK) ||
+      expect_regcomp_error("\\(a\\)\\2", 0, REG_ESUBREG) ||
+      expect_regcomp_error("a{2,1}", REG_EXTENDED, REG_BADBR) ||
+      expect_regcomp_error("[[:foo:]]", REG_EXTENDED, REG_ECTYPE) ||
+      expect_regcomp_error("[b-a]", REG_EXTENDED, REG_ERANGE) ||
+      expect_regcomp_error("a\\", REG_EXTENDED, REG_EESCAPE)) {
+    return -1;
+  }
+  char message[128];
+  size_t message_length = regerror(REG_EPAREN, NULL, message, sizeof(message));
+  if (message_length != strlen(message) + 1 || message_length < 2) {
+    return -1;
+  }
+  char short_message[4];
+  if (regerror(REG_EPAREN, NULL, short_message, sizeof(short_message)) !=
+          message_length ||
+      strlen(short_message) != 3 || memcmp(short_message, message, 3) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+static int expect_fnmatch(const char *pattern, const char *string, int flags,
+                          int expected) {
+  int result = fnmatch(pattern, string, flags);
+  if ((result == 0) != (expected == 0)) {
+    printf("fnmatch of %s against %s with %x returned %d\n", pattern, string,
+           flags, result);
+    return -1;
+  }
+  return 0;
+}
+
+static int test_fnmatch(void) {
+  if (expect_fnmatch("*.c", "a.c", 0, 0) ||
+      expect_fnmatch("a?c", "abc", 0, 0) ||
+      expect_fnmatch("a?c", "ac", 0, FNM_NOMATCH) ||
+      expect_fnmatch("*", "", 0, 0)) {
+    return -1;
+  }
+  // wildcards only match a slash without FNM_PATHNAME
+  if (expect_fnmatch("*", "a/b", 0, 0) ||
+      expect_fnmatch("*", "a/b", FNM_PATHNAME, FNM_NOMATCH) ||
+      expect_fnmatch("a?b", "a/b", FNM_PATHNAME, FNM_NOMATCH) ||
+      expect_fnmatch("a[/]b", "a/b", FNM_PATHNAME, FNM_NOMATCH) ||
+      expect_fnmatch("a/*", "a/b", FNM_PATHNAME, 0) ||
+      expect_fnmatch("*/*", "a/b/c", FNM_PATHNAME, FNM_NOMATCH)) {
+    return -1;
+  }
+  // a leading period needs to be matched by a period with FNM_PERIOD, with
+  // FNM_PATHNAME that holds for every component
+  if (expect_fnmatch("*", ".hidden", 0, 0) ||
+      expect_fnmatch("*", ".hidden", FNM_PERIOD, FNM_NOMATCH) ||
+      expect_fnmatch("?hidden", ".hidden", FNM_PERIOD, FNM_NOMATCH) ||
+      expect_fnmatch("[.]hidden", ".hidden", FNM_PERIOD, FNM_NOMATCH) ||
+      expect_fnmatch(".*", ".hidden", FNM_PERIOD, 0) ||
+      expect_fnmatch("a*", "a.b", FNM_PERIOD, 0) ||
+      expect_fnmatch("a/*", "a/.b", FNM_PATHNAME | FNM_PERIOD,
+                     FNM_NOMATCH) ||
+      expect_fnmatch("a/*", "a/.b", FNM_PATHNAME, 0)) {
+    return -1;
+  }
+  // FNM_LEADING_DIR ignores whatever follows a slash after the match
+  if (expect_fnmatch("a/b", "a/b/c", FNM_LEADING_DIR, 0) ||
+      expect_fnmatch("a/b", "a/b/c", 0, FNM_NOMATCH) ||
+      expect_fnmatch("a*", "abc/d", FNM_PATHNAME | FNM_LEADING_DIR, 0) ||
+      expect_fnmatch("a*", "abc/d", FNM_PATHNAME, FNM_NOMATCH) ||
+      expect_fnmatch("a/b", "a/bc", FNM_LEADING_DIR, FNM_NOMATCH)) {
+    return -1;
+  }
+  if (expect_fnmatch("ABC*", "abcd", FNM_CASEFOLD, 0) ||
+      expect_fnmatch("ABC*", "abcd", 0, FNM_NOMATCH) ||
+      expect_fnmatch("[A-C]x", "bX", FNM_CASEFOLD, 0) ||
+      expect_fnmatch("[A-C]x", "bX", 0, FNM_NOMATCH)) {
+    return -1;
+  }
+  // escapes, unless FNM_NOESCAPE makes the backslash an ordinary character
+  if (expect_fnmatch("\\*", "*", 0, 0) ||
+      expect_fnmatch("\\*", "a", 0, FNM_NOMATCH) ||
+      expect_fnmatch("a\\?", "ab", 0, FNM_NOMATCH) ||
+      expect_fnmatch("[\\]]", "]", 0, 0) ||
+      expect_fnmatch("\\*", "\\abc", FNM_NOESCAPE, 0) ||
+      expect_fnmatch("\\a", "a", FNM_NOESCAPE, FNM_NOMATCH)) {
+    return -1;
+  }
+  // bracket expressions, a ']' right after the opening or the negation is
+  // part of the set and an unterminated '[' is an ordinary character
+  if (expect_fnmatch("[!]]", "]", 0, FNM_NOMATCH) ||
+      expect_fnmatch("[!]]", "a", 0, 0) ||
+      expect_fnmatch("[]a]", "]", 0, 0) ||
+      expect_fnmatch("[!a-c]", "d", 0, 0) ||
+      expect_fnmatch("[!a-c]", "b", 0, FNM_NOMATCH) ||
+      expect_fnmatch("[a-]", "-", 0, 0) ||
+      expect_fnmatch("[[:digit:]]x", "5x", 0, 0) ||
+      expect_fnmatch("[[:digit:]]x", "ax", 0, FNM_NOMATCH) ||
+      expect_fnmatch("[a", "[a", 0, 0)) {
+    return -1;
+  }
+  return 0;
+}
+
+// run glob and compare the paths after the first offsets entries to the
+// expected ones, expected ends with NULL
+static int expect_glob(const char *pattern, int flags, glob_t *result,
+                       const char *const *expected) {
+  int error = glob(pattern, flags, NULL, result);
+  size_t offsets = flags & GLOB_DOOFFS ? result->gl_offs : 0;
+  size_t count = 0;
+  while (expected[count] != NULL) {
+    count++;
+  }
+  if (count == 0) {
+    return error == GLOB_NOMATCH ? 0 : -1;
+  }
+  if (error != 0 || result->gl_pathc != count ||
+      result->gl_pathv[offsets + count] != NULL) {
+    printf("glob of %s returned %d with %zu paths\n", pattern, error,
+           error == 0 ? (size_t)result->gl_pathc : 0);
+    return -1;
+  }
+  for (size_t index = 0; index < count; index++) {
+    if (strcmp(result->gl_pathv[offsets + index], expected[index]) != 0) {
+      printf("glob of %s found %s instead of %s\n", pattern,
+             result->gl_pathv[offsets + index], expected[index]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int test_glob(void) {
+  if (mkdir("glob_test", 0777) != 0 || mkdir("glob_test/dir", 0777) != 0 ||
+      mkdir("glob_test/dir2", 0777) != 0 ||
+      write_file("glob_test/one.c", "") != 0 ||
+      write_file("glob_test/two.c", "") != 0 ||
+      write_file("glob_test/two.h", "") != 0 ||
+      write_file("glob_test/.dot.c", "") != 0 ||
+      write_file("glob_test/dir/three.c", "") != 0) {
+    return -1;
+  }
+  glob_t result;
+  const char *const sources[] = {"glob_test/one.c", "glob_test/two.c", NULL};
+  const char *const hidden[] = {"glob_test/.dot.c", NULL};
+  const char *const nested[] = {"glob_test/dir/three.c", NULL};
+  const char *const none[] = {NULL};
+  // names starting with a period are only found with a literal period
+  if (expect_glob("glob_test/*.c", 0, &result, sources) ||
+      !(result.gl_flags & GLOB_MAGCHAR)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/.*.c", 0, &result, hidden)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/*/*.c", 0, &result, nested)) {
+    return -1;
+  }
+  globfree(&result);
+  // the literal text at the start and end of a component filters names
+  // before the pattern is matched
+  const char *const headers[] = {"glob_test/two.h", NULL};
+  const char *const ending_in_o[] = {"glob_test/two.c", NULL};
+  const char *const one[] = {"glob_test/one.c", NULL};
+  if (expect_glob("glob_test/t*.h", 0, &result, headers)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/*o.c", 0, &result, ending_in_o)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/o[n]e.c", 0, &result, one)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/[ot]*[.]c", 0, &result, sources)) {
+    return -1;
+  }
+  globfree(&result);
+  // patterns without wildcards only find existing files
+  if (expect_glob("glob_test/one.c", 0, &result, one) ||
+      (result.gl_flags & GLOB_MAGCHAR)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/missing.c", 0, &result, none)) {
+    return -1;
+  }
+
+  // directories get a slash with GLOB_MARK, a trailing slash in the pattern
+  // only matches directories
+  const char *const directories[] = {"glob_test/dir", "glob_test/dir2", NULL};
+  const char *const marked[] = {"glob_test/dir/", "glob_test/dir2/", NULL};
+  if (expect_glob("glob_test/d*", 0, &result, directories)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/d*", GLOB_MARK, &result, marked)) {
+    return -1;
+  }
+  globfree(&result);
+  if (expect_glob("glob_test/*/", 0, &result, marked)) {
+    return -1;
+  }
+  globfree(&result);
+
+  // GLOB_NOCHECK returns the pattern itself if nothing matches
+  const char *const unmatched[] = {"glob_test/*.x", NULL};
+  if (expect_glob("glob_test/*.x", 0, &result, none) ||
+      expect_glob("glob_test/*.x", GLOB_NOCHECK, &result, unmatched)) {
+    return -1;
+  }
+  globfree(&result);
+
+  // the reserved entries stay NULL when appending to the result
+  const char *const appended[] = {"glob_test/two.h", "glob_test/one.c",
+                                  NULL};
+  result.gl_offs = 2;
+  if (expect_glob("glob_test/*.h", GLOB_DOOFFS, &result, headers) ||
+      expect_glob("glob_test/o*", GLOB_DOOFFS | GLOB_APPEND, &result,
+                  appended) ||
+      result.gl_pathv[0] != NULL || result.gl_pathv[1] != NULL) {
+    return -1;
+  }
+  globfree(&result);
+  return 0;
+}
+
+// convert the whole input with a new descriptor into an output buffer of
+// out_size bytes and compare the result, errno, the output and the input left
+static int expect_iconv(const char *to, const char *from, const char *in,
+                        size_t in_len, size_t out_size, size_t result,
+                        int error, const char *out, size_t out_len,
+                        size_t in_left) {
+  iconv_t converter = iconv_open(to, from);
+  if (converter == (iconv_t)-1) {
+    printf("could not open iconv from %s to %s\n", from, to);
+    return -1;
+  }
+  char buffer[256];
+  char *in_pos = (char *)in;
+  char *out_pos = buffer;
+  size_t in_bytes = in_len;
+  size_t out_bytes = out_size;
+  errno = 0;
+  size_t converted = iconv(converter, &in_pos, &in_bytes, &out_pos, &out_bytes);
+  int converted_error = errno;
+  iconv_close(converter);
+  if (converted != result ||
+      (result == (size_t)-1 && converted_error != error) ||
+      (size_t)(out_pos - buffer) != out_len ||
+      out_bytes != out_size - out_len || memcmp(buffer, out, out_len) != 0 ||
+      in_bytes != in_left || in_pos != in + in_len - in_left) {
+    printf("iconv from %s to %s returned %zd with errno %d, wrote %zu bytes "
+           "and left %zu bytes\n",
+           from, to, converted, converted_error, (size_t)(out_pos - buffer),
+           in_bytes);
+    return -1;
+  }
+  return 0;
+}
+
+static int test_iconv(void) {
+  // characters of one, two, three and four bytes in UTF-8
+  const char utf8[] = "h\xc3\xa9llo \xe2\x82\xac\xf0\x9d\x84\x9e";
+  const char utf16le[] = "h\0\xe9\0l\0l\0o\0 \0\xac\x20\x34\xd8\x1e\xdd";
+  const char utf32be[] = "\0\0\0h\0\0\0\xe9\0\0\0l\0\0\0l\0\0\0o\0\0\0 "
+                         "\0\0\x20\xac\0\x01\xd1\x1e";
+  if (expect_iconv("UTF-16LE", "UTF-8", utf8, 14, 64, 0, 0, utf16le, 18, 0) ||
+      expect_iconv("utf8", "UTF-16LE", utf16le, 18, 64, 0, 0, utf8, 14, 0) ||
+      expect_iconv("UTF-32BE", "UTF-8", utf8, 14, 64, 0, 0, utf32be, 32, 0) ||
+      expect_iconv("UTF-8", "UTF-32BE", utf32be, 32, 64, 0, 0, utf8, 14, 0) ||
+      expect_iconv("UTF-8", "ISO-8859-1", "caf\xe9", 4, 64, 0, 0,
+                   "caf\xc3\xa9", 5, 0) ||
+      expect_iconv("LATIN1", "UTF-8", "caf\xc3\xa9", 5, 64, 0, 0, "caf\xe9", 4,
+                   0)) {
+    return -1;
+  }
+  // ASCII runs longer than a block are copied or widened as a whole
+  char long_text[100];
+  char long_wide[200];
+  memset(long_text, 'a', sizeof(long_text));
+  for (size_t index = 0; index < sizeof(long_text); index++) {
+    long_wide[2 * index] = '\0';
+    long_wide[2 * index + 1] = 'a';
+  }
+  long_text[70] = '\xe9';
+  long_wide[141] = '\xe9';
+  if (expect_iconv("UTF-16BE", "LATIN1", long_text, 100, 256, 0, 0, long_wide,
+                   200, 0) ||
+      expect_iconv("LATIN1", "UTF-16BE", long_wide, 200, 256, 0, 0, long_text,
+                   100, 0)) {
+    return -1;
+  }
+
+  // without an explicit byte order the output starts with a byte order mark
+  // in the native order and the input is read in the order of its mark
+  const uint16_t marked16[] = {0xfeff, 'A'};
+  const uint32_t marked32[] = {0xfeff, 'A'};
+  if (expect_iconv("UTF-16", "UTF-8", "A", 1, 64, 0, 0,
+                   (const char *)marked16, 4, 0) ||
+      expect_iconv("UTF-32", "UTF-8", "A", 1, 64, 0, 0,
+                   (const char *)marked32, 8, 0) ||
+      expect_iconv("UTF-8", "UTF-16", "\xfe\xff\0A", 4, 64, 0, 0, "A", 1, 0) ||
+      expect_iconv("UTF-8", "UTF-16", "\xff\xfe"
+                                      "A\0",
+                   4, 64, 0, 0, "A", 1, 0) ||
+      expect_iconv("UTF-8", "UTF-32", "\0\0\xfe\xff\0\0\0A", 8, 64, 0, 0, "A",
+                   1, 0) ||
+      expect_iconv("UTF-8", "UTF-16", (const char *)marked16, 4, 64, 0, 0, "A",
+                   1, 0)) {
+    return -1;
+  }
+
+  // surrogates only appear as pairs in UTF-16 and never in the other
+  // encodings
+  if (expect_iconv("UTF-8", "UTF-16LE", "\x34\xd8\x1e\xdd", 4, 64, 0, 0,
+                   "\xf0\x9d\x84\x9e", 4, 0) ||
+      expect_iconv("UTF-8", "UTF-16LE", "a\0\x34\xd8"
+                                        "b\0",
+                   6, 64, (size_t)-1, EILSEQ, "a", 1, 4) ||
+      expect_iconv("UTF-8", "UTF-16LE", "\x1e\xdd\x34\xd8", 4, 64, (size_t)-1,
+                   EILSEQ, "", 0, 4) ||
+      expect_iconv("UTF-16LE", "UTF-8", "\xed\xa0\x80", 3, 64, (size_t)-1,
+                   EILSEQ, "", 0, 3) ||
+      expect_iconv("UTF-8", "UTF-32LE", "\0\xd8\0\0", 4, 64, (size_t)-1, EILSEQ,
+                   "", 0, 4)) {
+    return -1;
+  }
+
+  // input ending inside of a character, the start of the character is left
+  if (expect_iconv("UTF-16LE", "UTF-8", "a\xe2\x82", 3, 64, (size_t)-1, EINVAL,
+                   "a\0", 2, 2) ||
+      expect_iconv("UTF-8", "UTF-16LE", "a\0\x34\xd8", 4, 64, (size_t)-1,
+                   EINVAL, "a", 1, 2) ||
+      expect_iconv("UTF-8", "UTF-32BE", "\0\0", 2, 64, (size_t)-1, EINVAL, "",
+                   0, 2) ||
+      expect_iconv("UTF-16LE", "UTF-8", "\xc3\x28", 2, 64, (size_t)-1, EILSEQ,
+                   "", 0, 2)) {
+    return -1;
+  }
+
+  // a full output stops before the first character that does not fit
+  if (expect_iconv("UTF-8", "UTF-8", "hello", 5, 3, (size_t)-1, E2BIG, "hel",
+                   3, 2) ||
+      expect_iconv("UTF-8", "UTF-8", "a\xe2\x82\xac", 4, 3, (size_t)-1, E2BIG,
+                   "a", 1, 3) ||
+      expect_iconv("UTF-16LE", "UTF-8", "\xf0\x9d\x84\x9e", 4, 2, (size_t)-1,
+                   E2BIG, "", 0, 4)) {
+    return -1;
+  }
+
+  // //IGNORE skips what can not be converted and fails after the rest,
+  // //TRANSLIT replaces it and counts the replacements
+  if (expect_iconv("ASCII//IGNORE", "UTF-8", "a\xff"
+                                             "b\xe2\x82\xac"
+                                             "c",
+                   7, 64, (size_t)-1, EILSEQ, "abc", 3, 0) ||
+      expect_iconv("ASCII", "UTF-8", "a\xe2\x82\xac", 4, 64, (size_t)-1,
+                   EILSEQ, "a", 1, 3) ||
+      expect_iconv("ASCII//TRANSLIT", "UTF-8", "caf\xc3\xa9 \xe2\x82\xac", 9,
+                   64, 2, 0, "caf? ?", 6, 0) ||
+      expect_iconv("LATIN1//TRANSLIT", "UTF-8", "\xc3\xa9\xe2\x82\xac", 5, 64,
+                   1, 0, "\xe9?", 2, 0)) {
+    return -1;
+  }
+
+  errno = 0;
+  if (iconv_open("UTF-8", "EBCDIC") != (iconv_t)-1 || errno != EINVAL) {
+    printf("iconv_open accepted an unknown encoding\n");
+    return -1;
+  }
+  return 0;
+}
+
 int main(int argc, char const *argv[]) {
   // print to std out and std err with the usual mode
   int err;
@@ -30,5 +659,17 @@ int main(int argc, char const *argv[]) {
   }
   char *env_home = getenv("HOME");
   printf("environmental variable HOME is %s\n", env_home);
+  if (test_getdelim() != 0) {
+    return -5;
+  }
+  if (test_regex() != 0) {
+    return -6;
+  }
+  if (test_fnmatch() != 0 || test_glob() != 0) {
+    return -7;
+  }
+  if (test_iconv() != 0) {
+    return -8;
+  }
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// size of the generated log in bytes
+#define LOG_SIZE (8 << 20)
+
+typedef struct Check {
+  const char *pattern;
+  int cflags;
+  const char *string;
+  // expected offsets of the whole match and the first group, -1 if none
+  regoff_t match[4];
+} Check;
+
+static const Check checks[] = {
+    {"b+", REG_EXTENDED, "aabbbc", {2, 5, -1, -1}},
+    {"(a|ab)(c|bcd)", REG_EXTENDED, "abcd", {0, 4, 0, 1}},
+    {"\\(a*\\)b\\1", 0, "xaabaa", {1, 6, 1, 3}},
+    {"^b", REG_NEWLINE, "a\nb", {2, 3, -1, -1}},
+    {"[[:digit:]]\\{2\\}", 0, "a1b22", {3, 5, -1, -1}},
+    {"x$", REG_EXTENDED, "x\ny", {-1, -1, -1, -1}},
+    {"HELLO", REG_ICASE, "say hello", {4, 9, -1, -1}},
+};
+
+static int self_check(void) {
+  for (size_t index = 0; index < sizeof(checks) / sizeof(checks[0]); index++) {
+    const Check *check = &checks[index];
+    regex_t regex;
+    if (regcomp(&regex, check->pattern, check->cflags) != 0) {
+      printf("failed to compile %s\n", check->pattern);
+      return -1;
+    }
+    regmatch_t match[2];
+    int result = regexec(&regex, check->string, 2, match, 0);
+    regfree(&regex);
+    regoff_t found[4] = {-1, -1, -1, -1};
+    if (result == 0) {
+      found[0] = match[0].rm_so;
+      found[1] = match[0].rm_eo;
+      found[2] = match[1].rm_so;
+      found[3] = match[1].rm_eo;
+    }
+    if (memcmp(found, check->match, sizeof(found)) != 0) {
+      printf("unexpected match for %s on %s\n", check->pattern, check->string);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// synthetic web server log with mostly successful requests
+static size_t generate_log(char *log, size_t size) {
+  static const char *const methods[] = {"GET", "POST", "PUT", "DELETE"};
+  static const char *const paths[] = {"/index.html", "/api/users",
+                                      "/api/orders", "/static/app.js"};
+  static const char *const levels[] = {"INFO", "INFO", "INFO", "WARN",
+                                       "ERROR"};
+  unsigned int seed = 42;
+  size_t len = 0;
+  while (len + 256 < size) {
+    seed = seed * 1103515245 + 12345;
+    unsigned int random = seed >> 8;
+    len += snprintf(log + len, size - len,
+                    "2024-03-%02u 12:%02u:%02u %s 10.0.%u.%u %s %s %u %ums\n",
+                    random % 28 + 1, random % 60, random / 60 % 60,
+                    levels[random % 5], random / 7 % 256, random / 13 % 256,
+                    methods[random / 3 % 4], paths[random / 5 % 4],
+                    random % 11 == 0 ? 500 : 200, random % 997);
+  }
+  return len;
+}
+
+static double seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// matches every line of the log separately, as grep does
+static int run(const char *name, const char *pattern, int cflags,
+               size_t nmatch, const char *log, size_t len) {
+  regex_t regex;
+  if (regcomp(&regex, pattern, cflags) != 0) {
+    printf("failed to compile %s\n", pattern);
+    return -1;
+  }
+  regmatch_t match[4];
+  size_t lines = 0;
+  double start = seconds();
+  for (const char *line = log; line < log + len;) {
+    const char *end = memchr(line, '\n', log + len - line);
+    match[0].rm_so = 0;
+    match[0].rm_eo = end - line;
+    if (regexec(&regex, line, nmatch, match, REG_STARTEND) == 0) {
+      lines++;
+    }
+    line = end + 1;
+  }
+  double elapsed = seconds() - start;
+  regfree(&regex);
+  printf("%-12s %8zu lines %10.1f MB/s\n", name, lines,
+         len / elapsed / 1e6);
+  return 0;
+}
+
+int main(void) {
+  if (self_check() != 0) {
+    return 1;
+  }
+  char *log = malloc(LOG_SIZE);
+  if (log == NULL) {
+    return 2;
+  }
+  size_t len = generate_log(log, LOG_SIZE);
+  int failed = 0;
+  failed |= run("literal", "ERROR", REG_NOSUB, 0, log, len);
+  failed |= run("prefix", "POST /api/[a-z]+ 500", REG_EXTENDED | REG_NOSUB,
+                0, log, len);
+  failed |= run("classes", "[0-9]+\\.[0-9]+\\.[0-9]+\\.[0-9]+ DELETE",
+                REG_EXTENDED | REG_NOSUB, 0, log, len);
+  failed |= run("alternation", "(WARN|ERROR).*(users|orders)",
+                REG_EXTENDED | REG_NOSUB, 0, log, len);
+  failed |= run("anchored", "^2024-03-1[0-9] ", REG_EXTENDED | REG_NOSUB, 0,
+                log, len);
+  failed |= run("icase", "delete /static", REG_ICASE | REG_NOSUB, 0, log,
+                len);
+  failed |= run("captures", "(ERROR) ([0-9.]+) ([A-Z]+)", REG_EXTENDED, 4,
+                log, len);
+  failed |= run("no match", "TRACE", REG_NOSUB, 0, log, len);
+  free(log);
+  return failed ? 3 : 0;
+}